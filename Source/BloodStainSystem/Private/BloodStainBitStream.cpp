@@ -0,0 +1,149 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#include "BloodStainBitStream.h"
+
+FBloodStainBitWriter::FBloodStainBitWriter(TArray<uint8>& InBytes)
+	: Bytes(InBytes)
+{
+}
+
+void FBloodStainBitWriter::WriteBits(uint64 Value, int32 NumBits)
+{
+	check(NumBits >= 0 && NumBits <= 64);
+	if (NumBits < 64)
+	{
+		Value &= (uint64(1) << NumBits) - 1;
+	}
+	NumBitsWritten += NumBits;
+
+	while (NumBits > 0)
+	{
+		const int32 Take = FMath::Min(NumBits, 64 - NumPending);
+		const uint64 Chunk = Take < 64 ? (Value & ((uint64(1) << Take) - 1)) : Value;
+		Pending |= Chunk << NumPending;
+		NumPending += Take;
+		NumBits -= Take;
+		Value = Take < 64 ? (Value >> Take) : 0;
+
+		while (NumPending >= 8)
+		{
+			Bytes.Add(static_cast<uint8>(Pending));
+			Pending >>= 8;
+			NumPending -= 8;
+		}
+	}
+}
+
+void FBloodStainBitWriter::Flush()
+{
+	if (NumPending > 0)
+	{
+		Bytes.Add(static_cast<uint8>(Pending));
+		Pending = 0;
+		NumPending = 0;
+	}
+}
+
+FBloodStainBitReader::FBloodStainBitReader(const uint8* InData, int64 InNumBytes)
+	: Data(InData)
+	, NumBytes(InNumBytes)
+{
+}
+
+void FBloodStainBitReader::Seek(int64 InBitPosition)
+{
+	BitPosition = FMath::Clamp<int64>(InBitPosition, 0, NumBytes * 8);
+	bOverflowed |= BitPosition != InBitPosition;
+}
+
+uint64 FBloodStainBitReader::ReadBits(int32 NumBits)
+{
+	check(NumBits >= 0 && NumBits <= 64);
+	if (BitPosition + NumBits > NumBytes * 8)
+	{
+		bOverflowed = true;
+		BitPosition = NumBytes * 8;
+		return 0;
+	}
+
+	uint64 Value = 0;
+	int32 NumRead = 0;
+	while (NumRead < NumBits)
+	{
+		const int64 ByteIndex = BitPosition >> 3;
+		const int32 BitOffset = static_cast<int32>(BitPosition & 7);
+		const int32 Take = FMath::Min(8 - BitOffset, NumBits - NumRead);
+		const uint64 Bits = (Data[ByteIndex] >> BitOffset) & ((1u << Take) - 1);
+		Value |= Bits << NumRead;
+		NumRead += Take;
+		BitPosition += Take;
+	}
+	return Value;
+}
+
+namespace BloodStainBitStream
+{
+	int64 PackFixedWidth(TConstArrayView<uint64> Values, int32 Width, TArray<uint8>& OutBytes)
+	{
+		const int64 StartSize = OutBytes.Num();
+		OutBytes.Reserve(StartSize + GetPackedSize(Values.Num(), Width));
+
+		FBloodStainBitWriter Writer(OutBytes);
+		for (const uint64 Value : Values)
+		{
+			Writer.WriteBits(Value, Width);
+		}
+		Writer.Flush();
+		return OutBytes.Num() - StartSize;
+	}
+
+	bool UnpackFixedWidth(const uint8* Data, int64 NumBytes, int32 Width, TArrayView<uint64> OutValues)
+	{
+		const int64 Count = OutValues.Num();
+		if (Width < 0 || Width > 64 || NumBytes < GetPackedSize(Count, Width))
+		{
+			return false;
+		}
+
+		uint64* const Out = OutValues.GetData();
+		if (Width == 0)
+		{
+			FMemory::Memzero(Out, Count * sizeof(uint64));
+			return true;
+		}
+
+		int64 Index = 0;
+
+		// A value starts at most 7 bits into its first byte, so one unaligned word covers it up to 57 bits wide
+		if (Width <= 57)
+		{
+			const uint64 Mask = Width < 64 ? (uint64(1) << Width) - 1 : ~uint64(0);
+			for (; Index < Count; ++Index)
+			{
+				const int64 BitPosition = Index * Width;
+				const int64 ByteIndex = BitPosition >> 3;
+				if (ByteIndex + 8 > NumBytes)
+				{
+					break;
+				}
+				const uint64 Word = FPlatformMemory::ReadUnaligned<uint64>(Data + ByteIndex);
+				Out[Index] = (Word >> (BitPosition & 7)) & Mask;
+			}
+		}
+
+		if (Index < Count)
+		{
+			FBloodStainBitReader Reader(Data, NumBytes);
+			Reader.Seek(Index * Width);
+			for (; Index < Count; ++Index)
+			{
+				Out[Index] = Reader.ReadBits(Width);
+			}
+			return !Reader.IsOverflowed();
+		}
+		return true;
+	}
+}
@@ -0,0 +1,372 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#include "BloodStainBlockUtils.h"
+#include "BloodStainCompressionUtils.h"
+#include "BloodStainRecordDataUtils.h"
+#include "BloodStainSystem.h"
+#include "BloodStainTrackUtils.h"
+#include "QuantizationHelper.h"
+#include "Async/ParallelFor.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DECLARE_CYCLE_STAT(TEXT("BlockUtils EncodeBlock"), STAT_BlockUtils_EncodeBlock, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("BlockUtils DecodeBlock"), STAT_BlockUtils_DecodeBlock, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("BlockUtils EncodeActors"), STAT_BlockUtils_EncodeActors, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("BlockUtils ReadContainerRange"), STAT_BlockUtils_ReadContainerRange, STATGROUP_BloodStain);
+
+namespace BloodStainBlockUtils
+{
+	bool EncodeBlock(TConstArrayView<FRecordFrame> Frames, const FBloodStainFileOptions& Options, FEncodedFrameBlock& OutBlock)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BlockUtils_EncodeBlock);
+
+		if (Frames.Num() == 0)
+		{
+			return false;
+		}
+
+		TArray<uint8> RawBytes;
+		FMemoryWriter RawAr(RawBytes);
+
+		// Every track carries its own range, so nothing shared is written ahead of the tracks
+		FTrackQuantizationTable TrackTable;
+		if (Options.QuantizationOption == ETransformQuantizationMethod::Auto)
+		{
+			BloodStainFileUtils_Internal::ChooseTrackQuantization(Frames, nullptr, Options.AutoQuantizationMaxPositionError, Options.AutoQuantizationMaxRotationError, Options.SmallestThreeRotationBits, TrackTable);
+			RawAr << TrackTable;
+		}
+		const int32 CurveTolerance = Options.bFitCurves ? Options.CurveMaxError : 0;
+		BloodStainTrackUtils::SerializeTracks(RawAr, Frames, Options.QuantizationOption, &TrackTable, Options.SmallestThreeRotationBits, CurveTolerance);
+
+		if (!BloodStainCompressionUtils::CompressBuffer(RawBytes, OutBlock.Bytes, Options.CompressionOption, Options.CompressionFilter, Options.OodleCompressor, Options.OodleCompressionLevel))
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] EncodeBlock: CompressBuffer failed"));
+			return false;
+		}
+
+		OutBlock.FirstFrameIndex = Frames[0].FrameIndex;
+		OutBlock.NumFrames = Frames.Num();
+		OutBlock.StartTime = Frames[0].TimeStamp;
+		OutBlock.EndTime = Frames.Last().TimeStamp;
+		OutBlock.UncompressedSize = RawBytes.Num();
+
+		OutBlock.Bounds.Init();
+		for (const FRecordFrame& Frame : Frames)
+		{
+			for (const TPair<FString, FTransform>& Pair : Frame.ComponentTransforms)
+			{
+				OutBlock.Bounds += Pair.Value.GetLocation();
+			}
+		}
+		return true;
+	}
+
+	bool DecodeBlock(const uint8* Data, int64 CompressedSize, int32 UncompressedSize, const FBloodStainFileOptions& Options, uint32 Version, TArray<FRecordFrame>& OutFrames)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BlockUtils_DecodeBlock);
+
+		TArray<uint8> RawBytes;
+		if (!BloodStainCompressionUtils::DecompressBuffer(UncompressedSize, Data, CompressedSize, RawBytes, Options.CompressionOption, Options.CompressionFilter))
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] DecodeBlock: DecompressBuffer failed"));
+			return false;
+		}
+
+		FMemoryReader RawAr(RawBytes, true);
+		const bool bColumnar = Version >= EBloodStainFileVersion::Columnar;
+
+		FActorTransformRanges Ranges;
+		if (!bColumnar)
+		{
+			RawAr << Ranges;
+		}
+
+		FTrackQuantizationTable TrackTable;
+		if (Options.QuantizationOption == ETransformQuantizationMethod::Auto)
+		{
+			RawAr << TrackTable;
+		}
+
+		if (bColumnar)
+		{
+			BloodStainTrackUtils::DeserializeTracks(RawAr, OutFrames, Options.QuantizationOption, &TrackTable);
+		}
+		else
+		{
+			BloodStainFileUtils_Internal::DeserializeFrames(RawAr, OutFrames, Options.QuantizationOption, Ranges, &TrackTable);
+		}
+
+		return !RawAr.IsError();
+	}
+
+	bool EncodeActors(TConstArrayView<FRecordActorSaveData> Actors, float BlockDuration, int32 MaxBlockFrames, const FBloodStainFileOptions& Options, TArray<FEncodedActorData>& OutActors)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BlockUtils_EncodeActors);
+
+		MaxBlockFrames = FMath::Max(MaxBlockFrames, 1);
+
+		struct FBlockJob
+		{
+			int32 ActorIndex;
+			int32 BlockIndex;
+			int32 FirstFrame;
+			int32 NumFrames;
+		};
+
+		// Lay out every block up front so workers only ever write to their own slot
+		TArray<FBlockJob> Jobs;
+		OutActors.SetNum(Actors.Num());
+		for (int32 ActorIndex = 0; ActorIndex < Actors.Num(); ++ActorIndex)
+		{
+			const FRecordActorSaveData& Actor = Actors[ActorIndex];
+			const TArray<FRecordFrame>& Frames = Actor.RecordedFrames;
+			const int32 NumFrames = Frames.Num();
+
+			FEncodedActorData& OutActor = OutActors[ActorIndex];
+			OutActor.PrimaryComponentName = Actor.PrimaryComponentName;
+			OutActor.ComponentIntervals = Actor.ComponentIntervals;
+			OutActor.NumFrames = NumFrames;
+
+			// A block ends once it spans BlockDuration or holds MaxBlockFrames frames
+			int32 FirstFrame = 0;
+			while (FirstFrame < NumFrames)
+			{
+				int32 EndFrame = FirstFrame + 1;
+				while (EndFrame < NumFrames && EndFrame - FirstFrame < MaxBlockFrames && Frames[EndFrame].TimeStamp - Frames[FirstFrame].TimeStamp < BlockDuration)
+				{
+					++EndFrame;
+				}
+				Jobs.Add({ ActorIndex, OutActor.Blocks.Num(), FirstFrame, EndFrame - FirstFrame });
+				OutActor.Blocks.AddDefaulted();
+				FirstFrame = EndFrame;
+			}
+		}
+
+		TArray<bool> Results;
+		Results.SetNumZeroed(Jobs.Num());
+		ParallelFor(Jobs.Num(), [&](int32 JobIndex)
+		{
+			const FBlockJob& Job = Jobs[JobIndex];
+			const TConstArrayView<FRecordFrame> Frames(Actors[Job.ActorIndex].RecordedFrames.GetData() + Job.FirstFrame, Job.NumFrames);
+			Results[JobIndex] = EncodeBlock(Frames, Options, OutActors[Job.ActorIndex].Blocks[Job.BlockIndex]);
+		});
+
+		return !Results.Contains(false);
+	}
+
+	int64 GetUncompressedSize(const TArray<FEncodedActorData>& Actors)
+	{
+		int64 TotalUncompressedSize = 0;
+		for (const FEncodedActorData& Actor : Actors)
+		{
+			for (const FEncodedFrameBlock& Block : Actor.Blocks)
+			{
+				TotalUncompressedSize += Block.UncompressedSize;
+			}
+		}
+		return TotalUncompressedSize;
+	}
+
+	int64 GetCompressedSize(const TArray<FEncodedActorData>& Actors)
+	{
+		int64 TotalCompressedSize = 0;
+		for (const FEncodedActorData& Actor : Actors)
+		{
+			for (const FEncodedFrameBlock& Block : Actor.Blocks)
+			{
+				TotalCompressedSize += Block.Bytes.Num();
+			}
+		}
+		return TotalCompressedSize;
+	}
+
+	void BuildHeaderSummary(TConstArrayView<FEncodedActorData> Actors, FRecordHeaderSummary& OutSummary)
+	{
+		OutSummary.NumActors = Actors.Num();
+		OutSummary.NumFrames = 0;
+		OutSummary.Bounds.Init();
+		for (const FEncodedActorData& Actor : Actors)
+		{
+			OutSummary.NumFrames += Actor.NumFrames;
+			for (const FEncodedFrameBlock& Block : Actor.Blocks)
+			{
+				OutSummary.Bounds += Block.Bounds;
+			}
+		}
+
+		OutSummary.PreviewComponentNames.Reset();
+		OutSummary.PreviewTransforms.Reset();
+		if (Actors.IsValidIndex(OutSummary.MainActorIndex))
+		{
+			const FEncodedActorData& MainActor = Actors[OutSummary.MainActorIndex];
+			OutSummary.PreviewComponentNames.Add(MainActor.PrimaryComponentName.ToString());
+			OutSummary.PreviewTransforms.Add(MainActor.FirstPrimaryTransform);
+		}
+	}
+
+	int64 WriteContainer(FArchive& Ar, const TArray<FEncodedActorData>& Actors)
+	{
+		TArray<FBlockActorDirectoryEntry> Directory;
+		TArray<FBlockTableEntry> BlockTable;
+		Directory.Reserve(Actors.Num());
+
+		int64 BlockOffset = 0;
+		int64 TotalUncompressedSize = 0;
+		for (int32 ActorIndex = 0; ActorIndex < Actors.Num(); ++ActorIndex)
+		{
+			const FEncodedActorData& Actor = Actors[ActorIndex];
+
+			FBlockActorDirectoryEntry& Entry = Directory.AddDefaulted_GetRef();
+			Entry.PrimaryComponentName = Actor.PrimaryComponentName;
+			Entry.ComponentIntervals = Actor.ComponentIntervals;
+			Entry.TimeBase = Actor.TimeBase;
+			Entry.SkipFrames = Actor.SkipFrames;
+			Entry.NumFrames = Actor.NumFrames;
+			Entry.FirstBlock = BlockTable.Num();
+			Entry.NumBlocks = Actor.Blocks.Num();
+
+			for (const FEncodedFrameBlock& Block : Actor.Blocks)
+			{
+				FBlockTableEntry& TableEntry = BlockTable.AddDefaulted_GetRef();
+				TableEntry.ActorIndex = ActorIndex;
+				TableEntry.FirstFrameIndex = Block.FirstFrameIndex;
+				TableEntry.NumFrames = Block.NumFrames;
+				TableEntry.StartTime = Block.StartTime;
+				TableEntry.EndTime = Block.EndTime;
+				TableEntry.Offset = BlockOffset;
+				TableEntry.CompressedSize = Block.Bytes.Num();
+				TableEntry.UncompressedSize = Block.UncompressedSize;
+
+				BlockOffset += Block.Bytes.Num();
+				TotalUncompressedSize += Block.UncompressedSize;
+			}
+		}
+
+		Ar << Directory;
+		Ar << BlockTable;
+
+		for (const FEncodedActorData& Actor : Actors)
+		{
+			for (const FEncodedFrameBlock& Block : Actor.Blocks)
+			{
+				Ar.Serialize(const_cast<uint8*>(Block.Bytes.GetData()), Block.Bytes.Num());
+			}
+		}
+
+		return TotalUncompressedSize;
+	}
+
+	bool ReadContainer(TConstArrayView<uint8> Payload, const FBloodStainFileOptions& Options, uint32 Version, FRecordSaveData& OutData)
+	{
+		FMemoryReaderView Reader(Payload, true);
+
+		TArray<FBlockActorDirectoryEntry> Directory;
+		TArray<FBlockTableEntry> BlockTable;
+		if (!ReadContainerIndex(Reader, Payload.Num(), Directory, BlockTable))
+		{
+			return false;
+		}
+
+		return ReadContainerRange(Reader, Reader.Tell(), Payload.Num(), Directory, BlockTable, Options, Version, -MAX_flt, MAX_flt, OutData);
+	}
+
+	bool ReadContainerIndex(FArchive& Ar, int64 PayloadEnd, TArray<FBlockActorDirectoryEntry>& OutDirectory, TArray<FBlockTableEntry>& OutBlockTable)
+	{
+		Ar << OutDirectory;
+		Ar << OutBlockTable;
+
+		if (Ar.IsError() || Ar.Tell() > PayloadEnd)
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] ReadContainer: Failed to read block directory"));
+			return false;
+		}
+		return true;
+	}
+
+	bool ReadContainerRange(FArchive& Ar, int64 BlockDataStart, int64 PayloadEnd, const TArray<FBlockActorDirectoryEntry>& Directory, const TArray<FBlockTableEntry>& BlockTable,
+		const FBloodStainFileOptions& Options, uint32 Version, float StartTime, float EndTime, FRecordSaveData& OutData)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BlockUtils_ReadContainerRange);
+
+		const int64 BlockDataSize = PayloadEnd - BlockDataStart;
+		TArray<uint8> BlockBytes;
+
+		OutData.RecordActorDataArray.Empty(Directory.Num());
+		for (const FBlockActorDirectoryEntry& Entry : Directory)
+		{
+			FRecordActorSaveData& ActorData = OutData.RecordActorDataArray.AddDefaulted_GetRef();
+			ActorData.PrimaryComponentName = Entry.PrimaryComponentName;
+			ActorData.ComponentIntervals = Entry.ComponentIntervals;
+
+			if (Entry.NumBlocks < 0 || Entry.FirstBlock < 0 || Entry.FirstBlock + Entry.NumBlocks > BlockTable.Num())
+			{
+				UE_LOG(LogBloodStain, Error, TEXT("[BS] ReadContainer: Block range %d+%d out of range"), Entry.FirstBlock, Entry.NumBlocks);
+				return false;
+			}
+			const TConstArrayView<FBlockTableEntry> Blocks(BlockTable.GetData() + Entry.FirstBlock, Entry.NumBlocks);
+
+			// The last block starting at or before StartTime through the first block ending at or after EndTime
+			int32 FirstBlock = 0;
+			while (FirstBlock + 1 < Blocks.Num() && Blocks[FirstBlock + 1].StartTime - Entry.TimeBase <= StartTime)
+			{
+				++FirstBlock;
+			}
+			int32 LastBlock = FirstBlock;
+			while (LastBlock + 1 < Blocks.Num() && Blocks[LastBlock].EndTime - Entry.TimeBase < EndTime)
+			{
+				++LastBlock;
+			}
+
+			// Saved index of the first decoded frame; the window's leading frames only exist in the actor's first block
+			int32 FirstSavedFrame = -Entry.SkipFrames;
+			for (int32 BlockIndex = 0; BlockIndex < FirstBlock; ++BlockIndex)
+			{
+				FirstSavedFrame += Blocks[BlockIndex].NumFrames;
+			}
+
+			for (int32 BlockIndex = FirstBlock; BlockIndex <= LastBlock && Blocks.Num() > 0; ++BlockIndex)
+			{
+				const FBlockTableEntry& Block = Blocks[BlockIndex];
+				if (Block.Offset < 0 || Block.CompressedSize < 0 || Block.Offset + Block.CompressedSize > BlockDataSize)
+				{
+					UE_LOG(LogBloodStain, Error, TEXT("[BS] ReadContainer: Block %d exceeds payload"), Entry.FirstBlock + BlockIndex);
+					return false;
+				}
+
+				BlockBytes.SetNumUninitialized(Block.CompressedSize, EAllowShrinking::No);
+				Ar.Seek(BlockDataStart + Block.Offset);
+				Ar.Serialize(BlockBytes.GetData(), Block.CompressedSize);
+				if (Ar.IsError())
+				{
+					UE_LOG(LogBloodStain, Error, TEXT("[BS] ReadContainer: Failed to read block %d"), Entry.FirstBlock + BlockIndex);
+					return false;
+				}
+
+				if (!DecodeBlock(BlockBytes.GetData(), Block.CompressedSize, Block.UncompressedSize, Options, Version, ActorData.RecordedFrames))
+				{
+					return false;
+				}
+			}
+
+			TArray<FRecordFrame>& Frames = ActorData.RecordedFrames;
+			if (FirstSavedFrame < 0)
+			{
+				Frames.RemoveAt(0, FMath::Min(-FirstSavedFrame, Frames.Num()), EAllowShrinking::No);
+				FirstSavedFrame = 0;
+			}
+
+			for (FRecordFrame& Frame : Frames)
+			{
+				Frame.TimeStamp -= Entry.TimeBase;
+			}
+
+			BloodStainRecordDataUtils::TrimToTimeRange(ActorData, StartTime, EndTime, FirstSavedFrame);
+		}
+
+		return true;
+	}
+}
@@ -4,8 +4,12 @@
 
 
 #include "BloodStainCompressionUtils.h"
+#include "BloodStainSystem.h"
+#include "Compression/OodleDataCompression.h"
 #include "Misc/Compression.h"
 
+DECLARE_CYCLE_STAT(TEXT("CompressionUtils Filter"), STAT_CompressionUtils_Filter, STATGROUP_BloodStain);
+
 namespace BloodStainCompressionUtils_Internal
 {
     static FName CompressionFormat(ECompressionMethod Method)
@@ -18,27 +22,165 @@ namespace BloodStainCompressionUtils_Internal
         default:                          return NAME_None;
         }
     }
+
+    static FOodleDataCompression::ECompressor OodleCompressor(EOodleCompressorType Compressor)
+    {
+        switch (Compressor)
+        {
+        case EOodleCompressorType::Selkie:    return FOodleDataCompression::ECompressor::Selkie;
+        case EOodleCompressorType::Mermaid:   return FOodleDataCompression::ECompressor::Mermaid;
+        case EOodleCompressorType::Leviathan: return FOodleDataCompression::ECompressor::Leviathan;
+        case EOodleCompressorType::Kraken:
+        default:                              return FOodleDataCompression::ECompressor::Kraken;
+        }
+    }
+
+    /** Levels share Oodle's numbering, HyperFast4 (-4) to Optimal5 (9) */
+    static FOodleDataCompression::ECompressionLevel OodleLevel(int32 Level)
+    {
+        return static_cast<FOodleDataCompression::ECompressionLevel>(FMath::Clamp(Level, -4, 9));
+    }
+
+    /** Element width the shuffle filters transpose over */
+    constexpr int64 FilterElementSize = 4;
+
+    /** Byte plane b of element i moves from In[i * W + b] to Out[b * N + i] (or back when bReverse) */
+    static void ByteShuffle(const uint8* In, int64 Size, uint8* Out, bool bReverse)
+    {
+        const int64 NumElements = Size / FilterElementSize;
+        for (int64 Byte = 0; Byte < FilterElementSize; ++Byte)
+        {
+            for (int64 Index = 0; Index < NumElements; ++Index)
+            {
+                const int64 Element = Index * FilterElementSize + Byte;
+                const int64 Plane = Byte * NumElements + Index;
+                Out[bReverse ? Element : Plane] = In[bReverse ? Plane : Element];
+            }
+        }
+
+        const int64 Shuffled = NumElements * FilterElementSize;
+        FMemory::Memcpy(Out + Shuffled, In + Shuffled, Size - Shuffled);
+    }
+
+    /** Bit b of element i moves to bit (i % 8) of byte (b * N / 8 + i / 8). Only whole groups of 8 elements are transposed */
+    static void BitShuffle(const uint8* In, int64 Size, uint8* Out, bool bReverse)
+    {
+        const int64 NumGroups = Size / (FilterElementSize * 8);
+        const int64 NumBits = FilterElementSize * 8;
+
+        if (bReverse)
+        {
+            FMemory::Memzero(Out, NumGroups * 8 * FilterElementSize);
+        }
+
+        for (int64 Bit = 0; Bit < NumBits; ++Bit)
+        {
+            const int64 Byte = Bit / 8;
+            const int32 Shift = static_cast<int32>(Bit % 8);
+            for (int64 Group = 0; Group < NumGroups; ++Group)
+            {
+                const int64 PlaneByte = Bit * NumGroups + Group;
+                const int64 FirstElement = Group * 8 * FilterElementSize + Byte;
+                if (bReverse)
+                {
+                    const uint8 Packed = In[PlaneByte];
+                    for (int32 Lane = 0; Lane < 8; ++Lane)
+                    {
+                        Out[FirstElement + Lane * FilterElementSize] |= static_cast<uint8>(((Packed >> Lane) & 1) << Shift);
+                    }
+                }
+                else
+                {
+                    uint8 Packed = 0;
+                    for (int32 Lane = 0; Lane < 8; ++Lane)
+                    {
+                        Packed |= static_cast<uint8>(((In[FirstElement + Lane * FilterElementSize] >> Shift) & 1) << Lane);
+                    }
+                    Out[PlaneByte] = Packed;
+                }
+            }
+        }
+
+        const int64 Shuffled = NumGroups * 8 * FilterElementSize;
+        FMemory::Memcpy(Out + Shuffled, In + Shuffled, Size - Shuffled);
+    }
+
+    static void RunFilter(const uint8* In, int64 Size, uint8* Out, ECompressionFilter Filter, bool bReverse)
+    {
+        SCOPE_CYCLE_COUNTER(STAT_CompressionUtils_Filter);
+
+        switch (Filter)
+        {
+        case ECompressionFilter::ByteShuffle: ByteShuffle(In, Size, Out, bReverse); break;
+        case ECompressionFilter::BitShuffle:  BitShuffle(In, Size, Out, bReverse);  break;
+        default:                              FMemory::Memcpy(Out, In, Size);       break;
+        }
+    }
 }
 
 namespace BloodStainCompressionUtils
 {
-    bool CompressBuffer(const TArray<uint8>& InBuffer, TArray<uint8>& OutCompressed, ECompressionMethod Opts)
+    void ApplyFilter(const uint8* InData, int64 Size, uint8* OutData, ECompressionFilter Filter)
+    {
+        BloodStainCompressionUtils_Internal::RunFilter(InData, Size, OutData, Filter, false);
+    }
+
+    void ReverseFilter(const uint8* InData, int64 Size, uint8* OutData, ECompressionFilter Filter)
     {
+        BloodStainCompressionUtils_Internal::RunFilter(InData, Size, OutData, Filter, true);
+    }
+
+    bool CompressBuffer(const TArray<uint8>& InBuffer, TArray<uint8>& OutCompressed, ECompressionMethod Opts, ECompressionFilter Filter, EOodleCompressorType OodleCompressor, int32 OodleLevel)
+    {
+        return CompressBuffer(InBuffer.GetData(), InBuffer.Num(), OutCompressed, Opts, Filter, OodleCompressor, OodleLevel);
+    }
+
+    bool CompressBuffer(const uint8* InData, int64 InSize, TArray<uint8>& OutCompressed, ECompressionMethod Opts, ECompressionFilter Filter, EOodleCompressorType OodleCompressor, int32 OodleLevel)
+    {
+        TArray<uint8> Filtered;
+        if (Filter != ECompressionFilter::None)
+        {
+            Filtered.SetNumUninitialized(InSize);
+            ApplyFilter(InData, InSize, Filtered.GetData(), Filter);
+            InData = Filtered.GetData();
+        }
+
         if (Opts == ECompressionMethod::None)
         {
-            OutCompressed = InBuffer;
+            OutCompressed.Reset();
+            OutCompressed.Append(InData, InSize);
+            return true;
+        }
+
+        if (Opts == ECompressionMethod::Oodle)
+        {
+            // FName based Oodle only uses the global default codec and level, so call Oodle directly
+            const int64 MaxSize = FOodleDataCompression::CompressedBufferSizeNeeded(InSize);
+            OutCompressed.SetNumUninitialized(MaxSize);
+
+            const int64 CompressedSize = FOodleDataCompression::Compress(
+                OutCompressed.GetData(), MaxSize,
+                InData, InSize,
+                BloodStainCompressionUtils_Internal::OodleCompressor(OodleCompressor),
+                BloodStainCompressionUtils_Internal::OodleLevel(OodleLevel));
+            if (CompressedSize <= 0)
+            {
+                return false;
+            }
+
+            OutCompressed.SetNum(CompressedSize);
             return true;
         }
 
         FName Format = BloodStainCompressionUtils_Internal::CompressionFormat(Opts);
-        int32 MaxSize = FCompression::CompressMemoryBound(Format, InBuffer.Num());
+        int32 MaxSize = FCompression::CompressMemoryBound(Format, InSize);
         OutCompressed.SetNumUninitialized(MaxSize);
 
         int64 CompressedSize = MaxSize;
         if (!FCompression::CompressMemory(
             Format,
             OutCompressed.GetData(), CompressedSize,
-            InBuffer.GetData(), InBuffer.Num(),
+            InData, InSize,
             COMPRESS_NoFlags))
         {
             return false;
@@ -48,19 +190,46 @@ namespace BloodStainCompressionUtils
         return true;
     }
 
-    bool DecompressBuffer(int64 UncompressedSize, const TArray<uint8>& Compressed, TArray<uint8>& OutRaw, ECompressionMethod Opts)
+    bool DecompressBuffer(int64 UncompressedSize, const TArray<uint8>& Compressed, TArray<uint8>& OutRaw, ECompressionMethod Opts, ECompressionFilter Filter)
+    {
+        return DecompressBuffer(UncompressedSize, Compressed.GetData(), Compressed.Num(), OutRaw, Opts, Filter);
+    }
+
+    bool DecompressBuffer(int64 UncompressedSize, const uint8* CompressedData, int64 CompressedSize, TArray<uint8>& OutRaw, ECompressionMethod Opts, ECompressionFilter Filter)
     {
         if (Opts == ECompressionMethod::None)
         {
-            OutRaw = Compressed;
-            return true;
+            OutRaw.Reset();
+            OutRaw.Append(CompressedData, CompressedSize);
+        }
+        else if (Opts == ECompressionMethod::Oodle)
+        {
+            // Oodle streams name their codec, so neither compressor nor level is needed here
+            OutRaw.SetNumUninitialized(UncompressedSize);
+            if (!FOodleDataCompression::Decompress(OutRaw.GetData(), UncompressedSize, CompressedData, CompressedSize))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            OutRaw.SetNumUninitialized(UncompressedSize);
+            if (!FCompression::UncompressMemory(
+                BloodStainCompressionUtils_Internal::CompressionFormat(Opts),
+                OutRaw.GetData(), UncompressedSize,
+                CompressedData, CompressedSize))
+            {
+                return false;
+            }
         }
 
-        OutRaw.SetNumUninitialized(UncompressedSize);
-        return FCompression::UncompressMemory(
-            BloodStainCompressionUtils_Internal::CompressionFormat(Opts),
-            OutRaw.GetData(), UncompressedSize,
-            Compressed.GetData(), Compressed.Num()
-        );
+        if (Filter != ECompressionFilter::None)
+        {
+            TArray<uint8> Unfiltered;
+            Unfiltered.SetNumUninitialized(OutRaw.Num());
+            ReverseFilter(OutRaw.GetData(), OutRaw.Num(), Unfiltered.GetData(), Filter);
+            OutRaw = MoveTemp(Unfiltered);
+        }
+        return true;
     }
 }
\ No newline at end of file
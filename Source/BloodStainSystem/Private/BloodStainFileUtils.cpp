@@ -4,10 +4,17 @@
 
 
 #include "BloodStainFileUtils.h"
+#include "BloodStainBlockUtils.h"
 #include "BloodStainCompressionUtils.h"
+#include "BloodStainIOScheduler.h"
+#include "BloodStainPackUtils.h"
+#include "BloodStainRecordDataUtils.h"
 #include "BloodStainSystem.h"
 #include "QuantizationHelper.h"
-#include "Serialization/BufferArchive.h"
+#include "Async/Async.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Tasks/Task.h"
 
 namespace BloodStainFileUtils_Internal
 {
@@ -38,6 +45,711 @@ namespace BloodStainFileUtils_Internal
 		const FString Dir = GetSaveDirectory();
 		return Dir / (RelativeFilePath + FILE_EXTENSION);
 	}
+
+	/** Where a recording's bytes live: a whole loose .bin file, or a range of its level pack's data segment */
+	struct FRecordingLocation
+	{
+		FString Path;
+		int64 Offset = 0;
+
+		/** Size of the recording, INDEX_NONE for a whole loose file */
+		int64 Size = INDEX_NONE;
+	};
+
+	/** Resolves a recording ("<Level>/<FileName>"), preferring a loose file over a pack entry of the same name */
+	bool FindRecording(const FString& RelativeFilePath, FRecordingLocation& OutLocation)
+	{
+		OutLocation = FRecordingLocation();
+		OutLocation.Path = GetFullFilePath(RelativeFilePath);
+		if (FPaths::FileExists(OutLocation.Path))
+		{
+			return true;
+		}
+
+		const FString LevelDir = GetSaveDirectory() / FPaths::GetPath(RelativeFilePath);
+		FBloodStainPackEntry Entry;
+		int32 Generation = 0;
+		if (!BloodStainPackUtils::FindEntry(LevelDir, FPaths::GetCleanFilename(RelativeFilePath), Entry, Generation))
+		{
+			return false;
+		}
+		OutLocation.Path = BloodStainPackUtils::GetDataPath(LevelDir, Generation);
+		OutLocation.Offset = Entry.HeaderOffset;
+		OutLocation.Size = Entry.GetTotalSize();
+		return true;
+	}
+
+	/**
+	 * Opens a recording for reading, positioned at its first byte. Positions stay those of the underlying file
+	 * @param OutEnd  Position just past the recording's last byte: the end of a loose file, or of the entry's payload in a pack
+	 */
+	TUniquePtr<FArchive> OpenRecording(const FString& RelativeFilePath, int64& OutEnd)
+	{
+		FRecordingLocation Location;
+		if (!FindRecording(RelativeFilePath, Location))
+		{
+			return nullptr;
+		}
+
+		TUniquePtr<FArchive> FileAr(IFileManager::Get().CreateFileReader(*Location.Path));
+		if (!FileAr)
+		{
+			return nullptr;
+		}
+
+		OutEnd = Location.Size == INDEX_NONE ? FileAr->TotalSize() : Location.Offset + Location.Size;
+		if (OutEnd > FileAr->TotalSize())
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] Recording %s runs past the end of %s"), *RelativeFilePath, *Location.Path);
+			return nullptr;
+		}
+		FileAr->Seek(Location.Offset);
+		return FileAr;
+	}
+
+	/** Reads a whole recording, loose or packed, through the replay I/O scheduler */
+	bool ReadRecordingToArray(TArray<uint8>& OutBytes, const FString& RelativeFilePath, EBloodStainIOPriority Priority)
+	{
+		return FBloodStainIOScheduler::Get().SubmitAndWait(Priority, [&OutBytes, &RelativeFilePath]()
+		{
+			FRecordingLocation Location;
+			if (!FindRecording(RelativeFilePath, Location))
+			{
+				return false;
+			}
+			if (Location.Size == INDEX_NONE)
+			{
+				return FFileHelper::LoadFileToArray(OutBytes, *Location.Path);
+			}
+
+			TUniquePtr<FArchive> FileAr(IFileManager::Get().CreateFileReader(*Location.Path));
+			if (!FileAr || Location.Offset + Location.Size > FileAr->TotalSize())
+			{
+				return false;
+			}
+			FileAr->Seek(Location.Offset);
+			OutBytes.SetNumUninitialized(static_cast<int32>(Location.Size));
+			FileAr->Serialize(OutBytes.GetData(), Location.Size);
+			return !FileAr->IsError();
+		});
+	}
+
+	/** @return Names of the entries in a level's pack, empty if the level has none */
+	TArray<FString> GetPackedFileNames(const FString& LevelName)
+	{
+		TArray<FString> FileNames;
+		FBloodStainPackDirectory Directory;
+		if (BloodStainPackUtils::ReadDirectory(GetSaveDirectory(LevelName), Directory))
+		{
+			Directory.Entries.GetKeys(FileNames);
+		}
+		return FileNames;
+	}
+
+	/** @return Names of every level under the save directory that has a pack, including nested level directories */
+	TArray<FString> GetPackedLevelNames()
+	{
+		const FString SearchDirectory = GetSaveDirectory();
+		const FString DirectoryFileName = FPaths::GetCleanFilename(BloodStainPackUtils::GetDirectoryPath(TEXT("")));
+
+		TArray<FString> FoundDirectoryPaths;
+		IFileManager::Get().FindFilesRecursive(FoundDirectoryPaths, *SearchDirectory, *DirectoryFileName, true, false);
+
+		TArray<FString> LevelNames;
+		for (const FString& DirectoryPath : FoundDirectoryPaths)
+		{
+			FString LevelName = FPaths::GetPath(DirectoryPath);
+			if (FPaths::MakePathRelativeTo(LevelName, *(SearchDirectory / TEXT(""))))
+			{
+				LevelNames.Add(LevelName);
+			}
+		}
+		return LevelNames;
+	}
+
+	/** Options the low resolution tier is encoded and decoded with */
+	FBloodStainFileOptions GetLowResolutionOptions(const FBloodStainFileOptions& Options, ETransformQuantizationMethod TierQuantization)
+	{
+		FBloodStainFileOptions TierOptions = Options;
+		TierOptions.QuantizationOption = TierQuantization;
+		return TierOptions;
+	}
+
+	/**
+	 * Writes the tier section in front of the full block container (EBloodStainFileVersion::Columnar):
+	 * the size of what follows, then the tier's quantization and its own block container. Size 0 means no tier.
+	 */
+	void WriteLowResolutionTier(FArchive& Ar, const TArray<FEncodedActorData>* LowResolutionActors, ETransformQuantizationMethod TierQuantization)
+	{
+		const int64 SizePos = Ar.Tell();
+		int64 TierSize = 0;
+		Ar << TierSize;
+		if (!LowResolutionActors)
+		{
+			return;
+		}
+
+		uint8 Quantization = static_cast<uint8>(TierQuantization);
+		Ar << Quantization;
+		BloodStainBlockUtils::WriteContainer(Ar, *LowResolutionActors);
+
+		const int64 EndPos = Ar.Tell();
+		TierSize = EndPos - SizePos - sizeof(int64);
+		Ar.Seek(SizePos);
+		Ar << TierSize;
+		Ar.Seek(EndPos);
+	}
+
+	/**
+	 * Reads the tier size written by WriteLowResolutionTier, rejecting sizes beyond the recording's payload
+	 * @param PayloadEnd  Position just past the payload in Ar
+	 */
+	bool ReadLowResolutionTierSize(FArchive& Ar, int64 PayloadEnd, int64& OutTierSize)
+	{
+		OutTierSize = 0;
+		Ar << OutTierSize;
+		return !Ar.IsError() && OutTierSize >= 0 && OutTierSize <= PayloadEnd - Ar.Tell();
+	}
+
+	/** Upper bound on preview pose entries accepted when reading, so a corrupt count cannot trigger a huge allocation */
+	constexpr int32 MaxPreviewComponents = 4096;
+
+	/**
+	 * Serializes the header summary (EBloodStainFileVersion::Columnar).
+	 * The preview pose is stored with 'Standard_SmallestThree' quantization.
+	 */
+	void SerializeHeaderSummary(FArchive& Ar, FRecordHeaderSummary& Summary)
+	{
+		Ar << Summary.NumActors;
+		Ar << Summary.NumFrames;
+		Ar << Summary.Bounds;
+		Ar << Summary.UncompressedSize;
+		Ar << Summary.CompressedSize;
+
+		uint8 Quantization = static_cast<uint8>(Summary.QuantizationOption);
+		Ar << Quantization;
+		Summary.QuantizationOption = static_cast<ETransformQuantizationMethod>(Quantization);
+
+		Ar << Summary.MainActorIndex;
+
+		int32 NumPreview = Summary.PreviewComponentNames.Num();
+		Ar << NumPreview;
+		if (Ar.IsLoading())
+		{
+			if (NumPreview < 0 || NumPreview > MaxPreviewComponents)
+			{
+				Ar.SetError();
+				return;
+			}
+			Summary.PreviewComponentNames.SetNum(NumPreview);
+			Summary.PreviewTransforms.SetNum(NumPreview);
+		}
+
+		for (int32 Index = 0; Index < NumPreview && !Ar.IsError(); ++Index)
+		{
+			Ar << Summary.PreviewComponentNames[Index];
+			if (Ar.IsLoading())
+			{
+				Summary.PreviewTransforms[Index] = DeserializeQuantizedTransform(Ar, ETransformQuantizationMethod::Standard_SmallestThree);
+			}
+			else
+			{
+				SerializeQuantizedTransform(Ar, Summary.PreviewTransforms[Index], ETransformQuantizationMethod::Standard_SmallestThree);
+			}
+		}
+	}
+
+	/**
+	 * Reads the file header and record header that follow the header size, plus the summary on files that have one.
+	 * @return false on read errors or a file header without the BloodStain magic
+	 */
+	bool ReadHeaders(FArchive& Ar, FBloodStainFileHeader& OutFileHeader, FRecordHeaderData& OutRecordHeader)
+	{
+		Ar << OutFileHeader;
+		if (Ar.IsError())
+		{
+			return false;
+		}
+		if (OutFileHeader.Magic != FBloodStainFileHeader::ExpectedMagic)
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] ReadHeaders: Not a BloodStain file header (magic 0x%08X)"), OutFileHeader.Magic);
+			Ar.SetError();
+			return false;
+		}
+		Ar << OutRecordHeader;
+
+		OutRecordHeader.Summary = FRecordHeaderSummary();
+		if (OutFileHeader.Version >= EBloodStainFileVersion::Columnar)
+		{
+			SerializeHeaderSummary(Ar, OutRecordHeader.Summary);
+		}
+		return !Ar.IsError();
+	}
+
+	/** Parses a size-prefixed header block, as stored in front of every recording and in pack directories */
+	bool ParseHeaderBlock(TConstArrayView<uint8> HeaderBlock, FBloodStainFileHeader& OutFileHeader, FRecordHeaderData& OutRecordHeader)
+	{
+		FMemoryReaderView MemR(HeaderBlock, true);
+		int32 HeaderByteSize = 0;
+		MemR << HeaderByteSize;
+		return ReadHeaders(MemR, OutFileHeader, OutRecordHeader);
+	}
+
+	/**
+	 * Adds the headers of a level's pack entries, parsed from the pack directory alone (one file read for the whole level).
+	 * Entries whose key is already present, i.e. shadowed by a loose file, are skipped.
+	 * @return Number of headers added
+	 */
+	int32 AddPackedHeaders(const FString& LevelName, TMap<FString, FRecordHeaderData>& OutLoadedHeaders)
+	{
+		FBloodStainPackDirectory Directory;
+		const bool bRead = FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Prefetch, [&]()
+		{
+			return BloodStainPackUtils::ReadDirectory(GetSaveDirectory(LevelName), Directory);
+		});
+		if (!bRead)
+		{
+			return 0;
+		}
+
+		int32 NumAdded = 0;
+		for (const TPair<FString, FBloodStainPackEntry>& Pair : Directory.Entries)
+		{
+			const FString RelativeFilePath = LevelName / Pair.Key;
+			if (OutLoadedHeaders.Contains(RelativeFilePath))
+			{
+				continue;
+			}
+
+			FBloodStainFileHeader FileHeader;
+			FRecordHeaderData LoadedData;
+			if (ParseHeaderBlock(Pair.Value.HeaderBytes, FileHeader, LoadedData))
+			{
+				LoadedData.FileName = FName(Pair.Key);
+				OutLoadedHeaders.Add(RelativeFilePath, MoveTemp(LoadedData));
+				++NumAdded;
+			}
+		}
+
+		UE_LOG(LogBloodStain, Log, TEXT("Found %d packed recordings in %s."), NumAdded, *LevelName);
+		return NumAdded;
+	}
+
+	/**
+	 * Writes a recording (header block, then payload) as a loose .bin file or as an entry of its level's pack.
+	 * Whichever copy is not written is dropped, so a stale copy never shadows the new one.
+	 * @return Success or failure
+	 */
+	bool WriteRecording(const FString& LevelName, const FString& FileName, TConstArrayView<uint8> HeaderBytes, const FGameplayTagContainer& Tags, bool bStoreInLevelPack, TFunctionRef<bool(FArchive&)> WritePayload)
+	{
+		const FString LevelDir = GetSaveDirectory(LevelName);
+		const FString Path = GetFullFilePath(FileName, LevelName);
+
+		if (bStoreInLevelPack)
+		{
+			if (!BloodStainPackUtils::AppendEntry(LevelDir, FileName, HeaderBytes, Tags, WritePayload))
+			{
+				return false;
+			}
+			IFileManager::Get().Delete(*Path, false, false, true);
+			return true;
+		}
+
+		IFileManager::Get().MakeDirectory(*LevelDir, /*Tree*/true);
+
+		// Written next to the recording and moved over it once complete, so a failed save never leaves a truncated file behind
+		const FString TempPath = Path + TEXT(".tmp");
+		TUniquePtr<FArchive> FileAr(IFileManager::Get().CreateFileWriter(*TempPath));
+		if (!FileAr)
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] Failed to open for writing: %s"), *TempPath);
+			return false;
+		}
+
+		FileAr->Serialize(const_cast<uint8*>(HeaderBytes.GetData()), HeaderBytes.Num());
+		const bool bPayloadWritten = WritePayload(*FileAr);
+		const bool bWritten = FileAr->Close() && !FileAr->IsError() && bPayloadWritten;
+		FileAr.Reset();
+		if (!bWritten || !IFileManager::Get().Move(*Path, *TempPath, /*Replace*/true))
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] Failed to write: %s"), *Path);
+			IFileManager::Get().Delete(*TempPath, false, false, true);
+			return false;
+		}
+
+		BloodStainPackUtils::RemoveEntry(LevelDir, FileName);
+		return true;
+	}
+
+	/** Queues a compaction of a level's pack on the maintenance class, if it has enough dead data to be worth it */
+	void ScheduleCompaction(const FString& LevelDir)
+	{
+		FBloodStainIOScheduler::Get().Submit(EBloodStainIOPriority::Maintenance, [LevelDir]()
+		{
+			return !BloodStainPackUtils::ShouldCompact(LevelDir) || BloodStainPackUtils::Compact(LevelDir);
+		});
+	}
+
+	/** Writes the size-prefixed file header, record header and header summary */
+	void WriteHeaders(FArchive& FileAr, FBloodStainFileHeader& FileHeader, const FRecordHeaderData& RecordHeader)
+	{
+		int64 StartPos = FileAr.Tell();
+		int32 HeaderByteSize = 0;
+		FileAr << HeaderByteSize;
+		
+		FileAr << FileHeader;
+		// Saving never writes through the references; the casts only satisfy operator<<
+		FileAr << const_cast<FRecordHeaderData&>(RecordHeader);
+		SerializeHeaderSummary(FileAr, const_cast<FRecordHeaderSummary&>(RecordHeader.Summary));
+
+		int64 EndPos = FileAr.Tell();
+		HeaderByteSize = static_cast<int32>(EndPos - StartPos);
+
+		FileAr.Seek(StartPos);
+		FileAr << HeaderByteSize;
+
+		FileAr.Seek(EndPos);
+	}
+
+	/**
+	 * Adds the headers of a level's loose and packed recordings, keyed by relative file path.
+	 * Like the other Scan* helpers it enumerates directories, so it runs on an I/O worker (the public entry points submit it)
+	 * and its nested SubmitAndWait reads run inline.
+	 */
+	void ScanHeadersInLevel(const FString& LevelName, TMap<FString, FRecordHeaderData>& OutLoadedHeaders)
+	{
+		// Decide the directory and file pattern to search for
+		const FString SearchDirectory = GetSaveDirectory(LevelName);
+		const FString FilePattern = FString(TEXT("*")) + FILE_EXTENSION; // "*.bin"
+
+		// Find all files in the specified directory that match the pattern
+		TArray<FString> FoundFileNamesWithExt;
+		IFileManager::Get().FindFiles(FoundFileNamesWithExt, *SearchDirectory, *FilePattern);
+
+		UE_LOG(LogBloodStain, Log, TEXT("Found %d recording files in %s."), FoundFileNamesWithExt.Num(), *SearchDirectory);
+
+		// Load each found file
+		for (const FString& FileNameWithExt : FoundFileNamesWithExt)
+		{
+			FString BaseFileName = FileNameWithExt;
+			BaseFileName.RemoveFromEnd(FILE_EXTENSION);
+
+			FRecordHeaderData LoadedData;
+			if (BloodStainFileUtils::LoadHeaderFromFile(BaseFileName, LevelName, LoadedData))
+			{
+				const FString RelativeFilePath = BloodStainFileUtils::GetRelativeFilePath(BaseFileName, LevelName);
+				// If loading was successful, add to the map
+				OutLoadedHeaders.Add(RelativeFilePath, LoadedData);
+			}
+		}
+
+		AddPackedHeaders(LevelName, OutLoadedHeaders);
+	}
+
+	/** Adds the headers of every recording under the save directory */
+	void ScanAllHeaders(TMap<FString, FRecordHeaderData>& OutLoadedHeaders)
+	{
+		// Decide the directory and file pattern to search for
+		const FString SearchDirectory = GetSaveDirectory();
+		const FString FilePattern = FString(TEXT("*")) + FILE_EXTENSION; // "*.bin"
+
+		// Find all files in the specified directory that match the pattern
+		TArray<FString> FoundFileNamesWithExt;
+		IFileManager::Get().FindFilesRecursive(FoundFileNamesWithExt, *SearchDirectory, *FilePattern, true, false);
+
+		UE_LOG(LogBloodStain, Log, TEXT("Found %d recording files in %s."), FoundFileNamesWithExt.Num(), *SearchDirectory);
+
+		// Load each found file
+		for (const FString& FileNameWithExt : FoundFileNamesWithExt)
+		{
+			const FString RelativeFilePathWithExt = FileNameWithExt.Replace(*SearchDirectory, TEXT(""));
+
+			FString RelativeFilePathWithoutExt = RelativeFilePathWithExt;
+			RelativeFilePathWithoutExt.RemoveFromStart(TEXT("/"));
+			RelativeFilePathWithoutExt.RemoveFromEnd(FILE_EXTENSION);
+
+			FRecordHeaderData LoadedData;
+			if (BloodStainFileUtils::LoadHeaderFromFile(RelativeFilePathWithoutExt, LoadedData))
+			{
+				// If loading was successful, add to the map
+				OutLoadedHeaders.Add(RelativeFilePathWithExt, LoadedData);
+			}
+		}
+
+		for (const FString& LevelName : GetPackedLevelNames())
+		{
+			AddPackedHeaders(LevelName, OutLoadedHeaders);
+		}
+	}
+
+	/** Adds the full data of a level's loose and packed recordings, keyed by file name */
+	void ScanAllFilesInLevel(const FString& LevelName, TMap<FString, FRecordSaveData>& OutLoadedDataMap)
+	{
+		const FString SearchDirectory = GetSaveDirectory(LevelName);
+		const FString FilePattern = FString(TEXT("*")) + FILE_EXTENSION; // "*.bin"
+
+		TArray<FString> FoundFileNamesWithExt;
+		IFileManager::Get().FindFiles(FoundFileNamesWithExt, *SearchDirectory, *FilePattern);
+
+		UE_LOG(LogBloodStain, Log, TEXT("Found %d recording files in %s."), FoundFileNamesWithExt.Num(), *SearchDirectory);
+
+		for (const FString& FileNameWithExt : FoundFileNamesWithExt)
+		{
+			FString BaseFileName = FileNameWithExt;
+			BaseFileName.RemoveFromEnd(FILE_EXTENSION);
+
+			FRecordSaveData LoadedData;
+			if (BloodStainFileUtils::LoadFromFile(BaseFileName, LevelName, LoadedData))
+			{
+				OutLoadedDataMap.Add(BaseFileName, LoadedData);
+			}
+		}
+
+		for (const FString& PackedFileName : GetPackedFileNames(LevelName))
+		{
+			FRecordSaveData LoadedData;
+			if (!OutLoadedDataMap.Contains(PackedFileName) && BloodStainFileUtils::LoadFromFile(PackedFileName, LevelName, LoadedData))
+			{
+				OutLoadedDataMap.Add(PackedFileName, LoadedData);
+			}
+		}
+	}
+
+	/** Adds the full data of every recording under the save directory, keyed by relative file path */
+	void ScanAllFiles(TMap<FString, FRecordSaveData>& OutLoadedDataMap)
+	{
+		const FString SearchDirectory = GetSaveDirectory();
+		const FString FilePattern = FString(TEXT("*")) + FILE_EXTENSION; // "*.bin"
+
+		TArray<FString> FoundFileNamesWithExt;
+		IFileManager::Get().FindFilesRecursive(FoundFileNamesWithExt, *SearchDirectory, *FilePattern, true, false);
+
+		UE_LOG(LogBloodStain, Log, TEXT("Found %d recording files in %s."), FoundFileNamesWithExt.Num(), *SearchDirectory);
+
+		for (const FString& FileNameWithExt : FoundFileNamesWithExt)
+		{
+			const FString RelativeFilePathWithExt = FileNameWithExt.Replace(*SearchDirectory, TEXT(""));
+
+			FString RelativeFilePathWithoutExt = RelativeFilePathWithExt;
+			RelativeFilePathWithoutExt.RemoveFromStart(TEXT("/"));
+			RelativeFilePathWithoutExt.RemoveFromEnd(FILE_EXTENSION);
+
+			FRecordSaveData LoadedData;
+			if (BloodStainFileUtils::LoadFromFile(RelativeFilePathWithoutExt, LoadedData))
+			{
+				OutLoadedDataMap.Add(RelativeFilePathWithoutExt, LoadedData);
+			}
+		}
+
+		for (const FString& LevelName : GetPackedLevelNames())
+		{
+			for (const FString& PackedFileName : GetPackedFileNames(LevelName))
+			{
+				const FString RelativeFilePath = BloodStainFileUtils::GetRelativeFilePath(PackedFileName, LevelName);
+				FRecordSaveData LoadedData;
+				if (!OutLoadedDataMap.Contains(RelativeFilePath) && BloodStainFileUtils::LoadFromFile(RelativeFilePath, LoadedData))
+				{
+					OutLoadedDataMap.Add(RelativeFilePath, LoadedData);
+				}
+			}
+		}
+	}
+
+	/** @return Level directories directly under the save directory that hold any file */
+	TArray<FString> ScanSavedLevelNames()
+	{
+		IFileManager& FileManager = IFileManager::Get();
+
+		const FString SearchDirectory = GetSaveDirectory();
+
+		TArray<FString> SubDirectories;
+		FileManager.FindFiles(SubDirectories, *(SearchDirectory / TEXT("*")), false, true);
+
+		TArray<FString> LevelNames;
+
+		for (const FString& SubDirName : SubDirectories)
+		{
+			const FString FullSubDirPath = SearchDirectory / SubDirName;
+
+			TArray<FString> FilesInSubDir;
+			FileManager.FindFiles(FilesInSubDir, *(FullSubDirPath / TEXT("*.*")), true, false);
+
+			if (FilesInSubDir.Num() > 0)
+			{
+				LevelNames.Add(SubDirName);
+			}
+		}
+
+		return LevelNames;
+	}
+
+	/** @return Names of a level's loose and packed recordings */
+	TArray<FString> ScanSavedFileNames(const FString& LevelName)
+	{
+		const FString LevelDirectory = GetSaveDirectory(LevelName);
+
+		// Only recordings; pack files in the same directory are listed through their entries below
+		TArray<FString> FileNamesWithExt;
+		IFileManager::Get().FindFiles(FileNamesWithExt, *(LevelDirectory / (FString(TEXT("*")) + FILE_EXTENSION)), true, false);
+
+		TArray<FString> FileNames;
+
+		for (const FString& FileNameWithExt : FileNamesWithExt)
+		{
+			const FString FileName = FPaths::GetBaseFilename(FileNameWithExt);
+			FileNames.Add(FileName);
+		}
+
+		for (const FString& PackedFileName : GetPackedFileNames(LevelName))
+		{
+			FileNames.AddUnique(PackedFileName);
+		}
+
+		return FileNames;
+	}
+
+	/** Runs Scan on an I/O worker and hands what it produced to OnDone on the game thread */
+	template <typename ResultType>
+	void LaunchScan(EBloodStainIOPriority Priority, TUniqueFunction<void(ResultType&)>&& Scan, TUniqueFunction<void(ResultType&&)>&& OnDone)
+	{
+		TSharedRef<ResultType> Result = MakeShared<ResultType>();
+
+		FBloodStainIOScheduler::Get().Submit(Priority, [Result, Scan = MoveTemp(Scan)]()
+		{
+			Scan(*Result);
+			return true;
+		}).Next([Result, OnDone = MoveTemp(OnDone)](bool) mutable
+		{
+			AsyncTask(ENamedThreads::GameThread, [Result, OnDone = MoveTemp(OnDone)]() mutable
+			{
+				OnDone(MoveTemp(*Result));
+			});
+		});
+	}
+
+	/** Encodes cooked actors for saving, plus their low resolution tier if Options asks for one */
+	bool EncodeSaveData(const FRecordSaveData& SaveData, const FBloodStainFileOptions& Options, TArray<FEncodedActorData>& OutEncodedActors, TArray<FEncodedActorData>& OutLowResolutionActors, FRecordHeaderData& OutHeader)
+	{
+		// Actors are cut into time-based blocks that are quantized and compressed independently across cores
+		if (!BloodStainBlockUtils::EncodeActors(SaveData.RecordActorDataArray, BloodStainBlockUtils::SaveBlockDuration, BloodStainBlockUtils::SaveBlockMaxFrames, Options, OutEncodedActors))
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] EncodeActors failed"));
+			return false;
+		}
+
+		if (Options.bWriteLowResolutionTier)
+		{
+			TArray<FRecordActorSaveData> TierActors;
+			TierActors.SetNum(SaveData.RecordActorDataArray.Num());
+			for (int32 Index = 0; Index < TierActors.Num(); ++Index)
+			{
+				BloodStainRecordDataUtils::BuildLowResolutionTier(SaveData.RecordActorDataArray[Index], Options.LowResolutionFrameStep, Options.LowResolutionMaxBones, TierActors[Index]);
+			}
+
+			const FBloodStainFileOptions TierOptions = GetLowResolutionOptions(Options, Options.LowResolutionQuantization);
+			if (!BloodStainBlockUtils::EncodeActors(TierActors, BloodStainBlockUtils::SaveBlockDuration, BloodStainBlockUtils::SaveBlockMaxFrames, TierOptions, OutLowResolutionActors))
+			{
+				UE_LOG(LogBloodStain, Error, TEXT("[BS] EncodeActors failed for the low resolution tier"));
+				return false;
+			}
+		}
+
+		// Frames are still at hand here, so the summary covers every component instead of only the primary ones
+		OutHeader = SaveData.Header;
+		BloodStainRecordDataUtils::BuildHeaderSummary(SaveData.RecordActorDataArray, OutHeader.Summary);
+		return true;
+	}
+
+	void LogSavedActors(TConstArrayView<FRecordActorSaveData> Actors)
+	{
+		for (const FRecordActorSaveData& RecordActorData : Actors)
+		{
+			const int32 NumFrames = RecordActorData.RecordedFrames.Num();
+			const float Duration  = NumFrames > 0
+				? RecordActorData.RecordedFrames.Last().TimeStamp - RecordActorData.RecordedFrames[0].TimeStamp
+				: 0.0f;
+
+			int32 BoneCount = 0;
+			if (NumFrames > 0)
+			{
+				BoneCount = RecordActorData.RecordedFrames[0].ComponentTransforms.Num();
+			}
+
+			UE_LOG(LogBloodStain, Log, TEXT("[BloodStain] ▶ Duration: %.2f sec | Frames: %d | Sockets: %d"),
+				Duration, NumFrames, BoneCount);
+		}
+	}
+
+	/** Serializes the header block of an encoded recording, completing the summary from the blocks */
+	void BuildEncodedHeaderBlock(const FRecordHeaderData& Header, const TArray<FEncodedActorData>& EncodedActors, const FBloodStainFileOptions& Options, TArray<uint8>& OutHeaderBytes)
+	{
+		FBloodStainFileHeader FileHeader;
+		FileHeader.Version = EBloodStainFileVersion::LatestVersion;
+		FileHeader.Options = Options;
+		FileHeader.UncompressedSize = BloodStainBlockUtils::GetUncompressedSize(EncodedActors);
+
+		FRecordHeaderData SavedHeader = Header;
+		if (!SavedHeader.Summary.HasBodyStats())
+		{
+			BloodStainBlockUtils::BuildHeaderSummary(EncodedActors, SavedHeader.Summary);
+		}
+		SavedHeader.Summary.UncompressedSize = FileHeader.UncompressedSize;
+		SavedHeader.Summary.CompressedSize = BloodStainBlockUtils::GetCompressedSize(EncodedActors);
+		SavedHeader.Summary.QuantizationOption = Options.QuantizationOption;
+
+		FMemoryWriter HeaderAr(OutHeaderBytes);
+		WriteHeaders(HeaderAr, FileHeader, SavedHeader);
+	}
+
+	/** Streams an encoded recording into its file or pack; the compressed blocks are never gathered into one buffer. Runs on an I/O worker */
+	bool WriteEncodedRecording(const FString& LevelName, const FString& FileName, TConstArrayView<uint8> HeaderBytes, const FGameplayTagContainer& Tags, const FBloodStainFileOptions& Options,
+		const TArray<FEncodedActorData>& EncodedActors, const TArray<FEncodedActorData>* LowResolutionActors, int64& OutFileSize)
+	{
+		return WriteRecording(LevelName, FileName, HeaderBytes, Tags, Options.bStoreInLevelPack, [&](FArchive& FileAr)
+		{
+			const int64 PayloadStart = FileAr.Tell();
+			WriteLowResolutionTier(FileAr, LowResolutionActors, Options.LowResolutionQuantization);
+			BloodStainBlockUtils::WriteContainer(FileAr, EncodedActors);
+			OutFileSize = HeaderBytes.Num() + FileAr.Tell() - PayloadStart;
+			return !FileAr.IsError();
+		});
+	}
+
+	void LogSaveResult(bool bSaved, const FString& Path, const FBloodStainFileOptions& Options, int32 NumActors, int64 FileSize)
+	{
+		if (!bSaved)
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] SaveEncodedToFile: %s was not written (write failed or superseded by a newer save)"), *Path);
+			return;
+		}
+		UE_LOG(LogBloodStain, Log, TEXT("[BloodStain] Saved recording to %s%s (%d actors, %lld bytes)"), *Path, Options.bStoreInLevelPack ? TEXT(" (level pack)") : TEXT(""), NumActors, FileSize);
+	}
+
+	/** Parses and decodes a whole recording read into memory. Pure CPU work */
+	bool DecodeRecordingBytes(const TArray<uint8>& AllBytes, const FString& RelativeFilePath, FRecordSaveData& OutData)
+	{
+		const FString Path = GetFullFilePath(RelativeFilePath);
+		int32 HeaderByteSize;
+
+		// Header Deserialization
+		FMemoryReader MemR(AllBytes, true);
+		FBloodStainFileHeader FileHeader;
+
+		MemR << HeaderByteSize;
+		if (!ReadHeaders(MemR, FileHeader, OutData.Header))
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] LoadFromFile failed to read headers: %s"), *Path);
+			return false;
+		}
+
+		FString FileNameWithoutExtension = FPaths::GetBaseFilename(RelativeFilePath);
+		OutData.Header.FileName = FName(FileNameWithoutExtension);
+
+		const int64 Offset = MemR.Tell();
+		const TConstArrayView<uint8> Payload(AllBytes.GetData() + Offset, static_cast<int32>(AllBytes.Num() - Offset));
+
+		return BloodStainFileUtils::DecodePayload(FileHeader, Payload, OutData);
+	}
 }
 
 bool BloodStainFileUtils::SaveToFile(
@@ -46,87 +758,162 @@ bool BloodStainFileUtils::SaveToFile(
     const FString&               FileName,
     const FBloodStainFileOptions& Options)
 {
-    FRecordSaveData LocalCopy = SaveData;
-	FBloodStainFileOptions LocalOptions = Options;
-	FBufferArchive BufferAr;
+	TArray<FEncodedActorData> EncodedActors;
+	TArray<FEncodedActorData> LowResolutionActors;
+	FRecordHeaderData Header;
+	if (!BloodStainFileUtils_Internal::EncodeSaveData(SaveData, Options, EncodedActors, LowResolutionActors, Header))
+	{
+		return false;
+	}
 
-	BloodStainFileUtils_Internal::SerializeSaveData(BufferAr, LocalCopy,LocalOptions.QuantizationOption);
+	if (!SaveEncodedToFile(Header, EncodedActors, LevelName, FileName, Options, Options.bWriteLowResolutionTier ? &LowResolutionActors : nullptr))
+	{
+		return false;
+	}
 
-    TArray<uint8> RawBytes;
-    RawBytes.Append(BufferAr.GetData(), BufferAr.Num());
-	
-    TArray<uint8> Payload;
-    if (Options.CompressionOption == ECompressionMethod::None)
-    {
-        Payload = MoveTemp(RawBytes);
-    }
-    else
-    {
-        if (!BloodStainCompressionUtils::CompressBuffer(RawBytes, Payload, Options.CompressionOption))
-        {
-            UE_LOG(LogBloodStain, Error, TEXT("[BS] CompressBuffer failed"));
-            return false;
-        }
-    }
-
-    FBloodStainFileHeader FileHeader;
-    FileHeader.Options          = Options;
-    FileHeader.UncompressedSize = RawBytes.Num();
-
-    FBufferArchive FileAr;
-
-	FileAr.SetIsSaving(true);
-
-	int64 StartPos = FileAr.Tell();
+	BloodStainFileUtils_Internal::LogSavedActors(SaveData.RecordActorDataArray);
+	return true;
+}
+
+TFuture<bool> BloodStainFileUtils::SaveToFileAsync(const FRecordSaveData& SaveData, const FString& LevelName, const FString& FileName, const FBloodStainFileOptions& Options)
+{
+	TArray<FEncodedActorData> EncodedActors;
+	TArray<FEncodedActorData> LowResolutionActors;
+	FRecordHeaderData Header;
+	if (!BloodStainFileUtils_Internal::EncodeSaveData(SaveData, Options, EncodedActors, LowResolutionActors, Header))
+	{
+		return MakeFulfilledPromise<bool>(false).GetFuture();
+	}
+
+	BloodStainFileUtils_Internal::LogSavedActors(SaveData.RecordActorDataArray);
+	return SaveEncodedToFileAsync(Header, MoveTemp(EncodedActors), LevelName, FileName, Options, MoveTemp(LowResolutionActors));
+}
+
+bool BloodStainFileUtils::SaveEncodedToFile(const FRecordHeaderData& Header, const TArray<FEncodedActorData>& EncodedActors, const FString& LevelName, const FString& FileName, const FBloodStainFileOptions& Options, const TArray<FEncodedActorData>* LowResolutionActors)
+{
+	const FString Path = BloodStainFileUtils_Internal::GetFullFilePath(FileName, LevelName);
+
+	TArray<uint8> HeaderBytes;
+	BloodStainFileUtils_Internal::BuildEncodedHeaderBlock(Header, EncodedActors, Options, HeaderBytes);
+
+	int64 FileSize = 0;
+	const bool bOK = FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Save, [&]()
+	{
+		return BloodStainFileUtils_Internal::WriteEncodedRecording(LevelName, FileName, HeaderBytes, Header.Tags, Options, EncodedActors, LowResolutionActors, FileSize);
+	}, Path);
+
+	BloodStainFileUtils_Internal::LogSaveResult(bOK, Path, Options, EncodedActors.Num(), FileSize);
+	return bOK;
+}
+
+TFuture<bool> BloodStainFileUtils::SaveEncodedToFileAsync(const FRecordHeaderData& Header, TArray<FEncodedActorData>&& EncodedActors, const FString& LevelName, const FString& FileName, const FBloodStainFileOptions& Options, TArray<FEncodedActorData>&& LowResolutionActors)
+{
+	/** Everything the queued write needs, owned by the request until it has run */
+	struct FPendingSave
+	{
+		TArray<uint8> HeaderBytes;
+		FGameplayTagContainer Tags;
+		TArray<FEncodedActorData> EncodedActors;
+		TArray<FEncodedActorData> LowResolutionActors;
+		int64 FileSize = 0;
+	};
+
+	const FString Path = BloodStainFileUtils_Internal::GetFullFilePath(FileName, LevelName);
+
+	TSharedRef<FPendingSave> Save = MakeShared<FPendingSave>();
+	BloodStainFileUtils_Internal::BuildEncodedHeaderBlock(Header, EncodedActors, Options, Save->HeaderBytes);
+	Save->Tags = Header.Tags;
+	Save->EncodedActors = MoveTemp(EncodedActors);
+	Save->LowResolutionActors = MoveTemp(LowResolutionActors);
+
+	return FBloodStainIOScheduler::Get().Submit(EBloodStainIOPriority::Save, [Save, LevelName, FileName, Options]()
+	{
+		const TArray<FEncodedActorData>* Tier = Save->LowResolutionActors.Num() > 0 ? &Save->LowResolutionActors : nullptr;
+		return BloodStainFileUtils_Internal::WriteEncodedRecording(LevelName, FileName, Save->HeaderBytes, Save->Tags, Options, Save->EncodedActors, Tier, Save->FileSize);
+	}, Path).Next([Save, Path, Options](bool bOK)
+	{
+		BloodStainFileUtils_Internal::LogSaveResult(bOK, Path, Options, Save->EncodedActors.Num(), Save->FileSize);
+		return bOK;
+	});
+}
+
+bool BloodStainFileUtils::SaveFileBytes(const TArray<uint8>& FileBytes, const FString& LevelName, const FString& FileName, const FBloodStainFileOptions& Options)
+{
+	// Only the header block is parsed, for its size and the tags the pack directory keeps
+	FMemoryReader MemR(FileBytes, true);
 	int32 HeaderByteSize = 0;
-	FileAr << HeaderByteSize;
-	
-    FileAr << FileHeader;
-	FileAr << LocalCopy.Header;
+	MemR << HeaderByteSize;
+	FBloodStainFileHeader FileHeader;
+	FRecordHeaderData RecordHeader;
+	if (!BloodStainFileUtils_Internal::ReadHeaders(MemR, FileHeader, RecordHeader) || HeaderByteSize < MemR.Tell() || HeaderByteSize > FileBytes.Num())
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] SaveFileBytes: Invalid headers for %s"), *FileName);
+		return false;
+	}
 
-	int64 EndPos = FileAr.Tell();
-	HeaderByteSize = static_cast<int32>(EndPos - StartPos);
+	const TConstArrayView<uint8> AllBytes(FileBytes);
+	const TConstArrayView<uint8> HeaderBytes = AllBytes.Left(HeaderByteSize);
+	const TConstArrayView<uint8> Payload = AllBytes.RightChop(HeaderByteSize);
 
-	FileAr.Seek(StartPos);
-	FileAr << HeaderByteSize;
+	const FString Path = BloodStainFileUtils_Internal::GetFullFilePath(FileName, LevelName);
+	return FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Save, [&]()
+	{
+		return BloodStainFileUtils_Internal::WriteRecording(LevelName, FileName, HeaderBytes, RecordHeader.Tags, Options.bStoreInLevelPack, [&Payload](FArchive& FileAr)
+		{
+			FileAr.Serialize(const_cast<uint8*>(Payload.GetData()), Payload.Num());
+			return !FileAr.IsError();
+		});
+	}, Path);
+}
 
-	FileAr.Seek(EndPos);
+void BloodStainFileUtils::LoadFileBytesAsync(const FString& FileName, const FString& LevelName, TUniqueFunction<void(bool bSuccess, TArray<uint8>&& FileBytes)>&& OnLoaded)
+{
+	const FString RelativeFilePath = GetRelativeFilePath(FileName, LevelName);
+	TSharedRef<TArray<uint8>> FileBytes = MakeShared<TArray<uint8>>();
 
-    FileAr.Serialize(Payload.GetData(), Payload.Num());
+	// ReadRecordingToArray runs inline on the I/O worker
+	FBloodStainIOScheduler::Get().Submit(EBloodStainIOPriority::Interactive, [FileBytes, RelativeFilePath]()
+	{
+		return BloodStainFileUtils_Internal::ReadRecordingToArray(*FileBytes, RelativeFilePath, EBloodStainIOPriority::Interactive);
+	}).Next([FileBytes, OnLoaded = MoveTemp(OnLoaded)](bool bSuccess) mutable
+	{
+		AsyncTask(ENamedThreads::GameThread, [bSuccess, FileBytes, OnLoaded = MoveTemp(OnLoaded)]() mutable
+		{
+			OnLoaded(bSuccess, MoveTemp(*FileBytes));
+		});
+	});
+}
 
-    const FString Path = BloodStainFileUtils_Internal::GetFullFilePath(FileName, LevelName);
+bool BloodStainFileUtils::DecodePayload(const FBloodStainFileHeader& FileHeader, TConstArrayView<uint8> Payload, FRecordSaveData& OutData)
+{
+	if (FileHeader.Version >= EBloodStainFileVersion::Columnar)
+	{
+		// Skip the low resolution tier in front of the full data
+		FMemoryReaderView TierReader(Payload, true);
+		int64 TierSize = 0;
+		if (!BloodStainFileUtils_Internal::ReadLowResolutionTierSize(TierReader, TierReader.TotalSize(), TierSize))
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] DecodePayload: Invalid low resolution tier size"));
+			return false;
+		}
+		return BloodStainBlockUtils::ReadContainer(Payload.RightChop(static_cast<int32>(TierReader.Tell() + TierSize)), FileHeader.Options, FileHeader.Version, OutData);
+	}
 
-	const FString SaveDir = BloodStainFileUtils_Internal::GetSaveDirectory(LevelName);
-	IFileManager::Get().MakeDirectory(*SaveDir, /*Tree*/true);
-	
-    bool bOK = FFileHelper::SaveArrayToFile(FileAr, *Path);
-    FileAr.FlushCache(); FileAr.Empty();
+	if (FileHeader.Version >= EBloodStainFileVersion::BlockContainer)
+	{
+		return BloodStainBlockUtils::ReadContainer(Payload, FileHeader.Options, FileHeader.Version, OutData);
+	}
 
-    if (!bOK)
-    {
-        UE_LOG(LogBloodStain, Error, TEXT("[BS] SaveToFile failed: %s"), *Path);
-    }
+	TArray<uint8> RawBytes;
+	if (!BloodStainCompressionUtils::DecompressBuffer(FileHeader.UncompressedSize, Payload.GetData(), Payload.Num(), RawBytes, FileHeader.Options.CompressionOption))
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] DecompressBuffer failed"));
+		return false;
+	}
 
-    
-    for (const FRecordActorSaveData& RecordActorData : SaveData.RecordActorDataArray)
-    {
-        const int32 NumFrames = RecordActorData.RecordedFrames.Num();
-        const float Duration  = NumFrames > 0 
-            ? RecordActorData.RecordedFrames.Last().TimeStamp - RecordActorData.RecordedFrames[0].TimeStamp 
-            : 0.0f;
-
-        int32 BoneCount = 0;
-        if (NumFrames > 0)
-        {
-            BoneCount = RecordActorData.RecordedFrames[0].ComponentTransforms.Num();
-        }
-
-        UE_LOG(LogBloodStain, Log, TEXT("[BloodStain] Saved recording to %s"), *Path);
-        UE_LOG(LogBloodStain, Log, TEXT("[BloodStain] ▶ Duration: %.2f sec | Frames: %d | Sockets: %d"), 
-            Duration, NumFrames, BoneCount);    
-    }
-    
-    return bOK;
+	FMemoryReader MemoryReader(RawBytes, true);
+	BloodStainFileUtils_Internal::DeserializeSaveData(MemoryReader, OutData, FileHeader.Options.QuantizationOption);
+	return !MemoryReader.IsError();
 }
 
 bool BloodStainFileUtils::LoadFromFile(const FString& FileName, const FString& LevelName, FRecordSaveData& OutData)
@@ -138,52 +925,181 @@ bool BloodStainFileUtils::LoadFromFile(const FString& FileName, const FString& L
 bool BloodStainFileUtils::LoadFromFile(const FString& RelativeFilePath, FRecordSaveData& OutData)
 {
 	// Reading entire file from disk
-	const FString Path = BloodStainFileUtils_Internal::GetFullFilePath(RelativeFilePath);
 	TArray<uint8> AllBytes;
-	if (!FFileHelper::LoadFileToArray(AllBytes, *Path))
+	if (!BloodStainFileUtils_Internal::ReadRecordingToArray(AllBytes, RelativeFilePath, EBloodStainIOPriority::Interactive))
 	{
-		UE_LOG(LogBloodStain, Error, TEXT("[BS] LoadFromFile failed read: %s"), *Path);
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] LoadFromFile failed read: %s"), *BloodStainFileUtils_Internal::GetFullFilePath(RelativeFilePath));
 		return false;	
 	}
 
-	int32 HeaderByteSize;
-	
-	// Header Deserialization
-	FMemoryReader MemR(AllBytes, true);
+	return BloodStainFileUtils_Internal::DecodeRecordingBytes(AllBytes, RelativeFilePath, OutData);
+}
+
+void BloodStainFileUtils::LoadFromFileAsync(const FString& FileName, const FString& LevelName, TUniqueFunction<void(bool bSuccess, FRecordSaveData&& Data)>&& OnLoaded)
+{
+	const FString RelativeFilePath = GetRelativeFilePath(FileName, LevelName);
+	TSharedRef<TArray<uint8>> FileBytes = MakeShared<TArray<uint8>>();
+
+	// ReadRecordingToArray runs inline on the I/O worker
+	FBloodStainIOScheduler::Get().Submit(EBloodStainIOPriority::Interactive, [FileBytes, RelativeFilePath]()
+	{
+		return BloodStainFileUtils_Internal::ReadRecordingToArray(*FileBytes, RelativeFilePath, EBloodStainIOPriority::Interactive);
+	}).Next([FileBytes, RelativeFilePath, OnLoaded = MoveTemp(OnLoaded)](bool bRead) mutable
+	{
+		// Decoding is CPU work; it runs as a task instead of holding the I/O slot
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [bRead, FileBytes, RelativeFilePath, OnLoaded = MoveTemp(OnLoaded)]() mutable
+		{
+			TSharedRef<FRecordSaveData> Data = MakeShared<FRecordSaveData>();
+			if (!bRead)
+			{
+				UE_LOG(LogBloodStain, Error, TEXT("[BS] LoadFromFileAsync failed read: %s"), *BloodStainFileUtils_Internal::GetFullFilePath(RelativeFilePath));
+			}
+			const bool bLoaded = bRead && BloodStainFileUtils_Internal::DecodeRecordingBytes(*FileBytes, RelativeFilePath, *Data);
+
+			AsyncTask(ENamedThreads::GameThread, [bLoaded, Data, OnLoaded = MoveTemp(OnLoaded)]() mutable
+			{
+				OnLoaded(bLoaded, MoveTemp(*Data));
+			});
+		});
+	});
+}
+
+bool BloodStainFileUtils::LoadTimeRangeFromFile(const FString& FileName, const FString& LevelName, float StartTime, float EndTime, FRecordSaveData& OutData)
+{
+	if (StartTime > EndTime)
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BS] LoadTimeRangeFromFile: Invalid range [%.2f, %.2f]"), StartTime, EndTime);
+		return false;
+	}
+
+	const FString Path = BloodStainFileUtils_Internal::GetFullFilePath(FileName, LevelName);
 	FBloodStainFileHeader FileHeader;
-	
-	MemR << HeaderByteSize;
-	MemR << FileHeader;
-	MemR << OutData.Header;
-	
-	FString FileNameWithoutExtension = FPaths::GetBaseFilename(RelativeFilePath);
-	OutData.Header.FileName = FName(FileNameWithoutExtension);
+	bool bLegacyFile = false;
+
+	// Only the headers, the block index and the blocks covering the range are read from disk
+	const bool bOK = FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Interactive, [&]()
+	{
+		int64 PayloadEnd = 0;
+		TUniquePtr<FArchive> FileAr = BloodStainFileUtils_Internal::OpenRecording(GetRelativeFilePath(FileName, LevelName), PayloadEnd);
+		if (!FileAr)
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] LoadTimeRangeFromFile failed to open: %s"), *Path);
+			return false;
+		}
 
-	int64 Offset = MemR.Tell();
-	int64 Remain = AllBytes.Num() - Offset;
-	const uint8* Ptr = AllBytes.GetData() + Offset;
+		int32 HeaderByteSize = 0;
+		*FileAr << HeaderByteSize;
+		if (!BloodStainFileUtils_Internal::ReadHeaders(*FileAr, FileHeader, OutData.Header))
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] LoadTimeRangeFromFile failed to read headers: %s"), *Path);
+			return false;
+		}
 
-	TArray<uint8> Compressed;
-	Compressed.SetNumUninitialized(Remain);
-	FMemory::Memcpy(Compressed.GetData(), Ptr, Remain);
+		if (FileHeader.Version < EBloodStainFileVersion::BlockContainer)
+		{
+			bLegacyFile = true;
+			return true;
+		}
 
-	TArray<uint8> RawBytes;
-	if (FileHeader.Options.CompressionOption == ECompressionMethod::None)
+		if (FileHeader.Version >= EBloodStainFileVersion::Columnar)
+		{
+			int64 TierSize = 0;
+			if (!BloodStainFileUtils_Internal::ReadLowResolutionTierSize(*FileAr, PayloadEnd, TierSize))
+			{
+				UE_LOG(LogBloodStain, Error, TEXT("[BS] LoadTimeRangeFromFile: Invalid low resolution tier size: %s"), *Path);
+				return false;
+			}
+			FileAr->Seek(FileAr->Tell() + TierSize);
+		}
+
+		TArray<FBlockActorDirectoryEntry> Directory;
+		TArray<FBlockTableEntry> BlockTable;
+		if (!BloodStainBlockUtils::ReadContainerIndex(*FileAr, PayloadEnd, Directory, BlockTable))
+		{
+			return false;
+		}
+
+		return BloodStainBlockUtils::ReadContainerRange(*FileAr, FileAr->Tell(), PayloadEnd, Directory, BlockTable, FileHeader.Options, FileHeader.Version, StartTime, EndTime, OutData);
+	});
+
+	if (!bOK)
 	{
-		RawBytes = MoveTemp(Compressed);
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] LoadTimeRangeFromFile failed: %s"), *Path);
+		return false;
 	}
-	else
+
+	// Single-blob files have no block index; decode everything and cut the range afterwards
+	if (bLegacyFile)
 	{
-		if (!BloodStainCompressionUtils::DecompressBuffer(FileHeader.UncompressedSize, Compressed, RawBytes, FileHeader.Options.CompressionOption))
+		if (!LoadFromFile(FileName, LevelName, OutData))
 		{
-			UE_LOG(LogBloodStain, Error, TEXT("[BS] DecompressBuffer failed"));
 			return false;
 		}
+		for (FRecordActorSaveData& ActorData : OutData.RecordActorDataArray)
+		{
+			BloodStainRecordDataUtils::TrimToTimeRange(ActorData, StartTime, EndTime);
+		}
 	}
 
-	FMemoryReader MemoryReader(RawBytes, true);
-	BloodStainFileUtils_Internal::DeserializeSaveData(MemoryReader,OutData,FileHeader.Options.QuantizationOption);
-	
+	OutData.Header.FileName = FName(FileName);
+	return true;
+}
+
+bool BloodStainFileUtils::LoadLowResolutionFromFile(const FString& FileName, const FString& LevelName, FRecordSaveData& OutData)
+{
+	const FString Path = BloodStainFileUtils_Internal::GetFullFilePath(FileName, LevelName);
+	FBloodStainFileHeader FileHeader;
+	TArray<uint8> TierBytes;
+
+	// Only the headers and the tier are read; the full data behind them is never touched
+	const bool bRead = FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Interactive, [&]()
+	{
+		int64 PayloadEnd = 0;
+		TUniquePtr<FArchive> FileAr = BloodStainFileUtils_Internal::OpenRecording(GetRelativeFilePath(FileName, LevelName), PayloadEnd);
+		if (!FileAr)
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] LoadLowResolutionFromFile failed to open: %s"), *Path);
+			return false;
+		}
+
+		int32 HeaderByteSize = 0;
+		*FileAr << HeaderByteSize;
+		if (!BloodStainFileUtils_Internal::ReadHeaders(*FileAr, FileHeader, OutData.Header) || FileHeader.Version < EBloodStainFileVersion::Columnar)
+		{
+			return false;
+		}
+
+		int64 TierSize = 0;
+		if (!BloodStainFileUtils_Internal::ReadLowResolutionTierSize(*FileAr, PayloadEnd, TierSize) || TierSize == 0)
+		{
+			return false;
+		}
+
+		TierBytes.SetNumUninitialized(TierSize);
+		FileAr->Serialize(TierBytes.GetData(), TierSize);
+		return !FileAr->IsError();
+	});
+
+	if (!bRead)
+	{
+		UE_LOG(LogBloodStain, Log, TEXT("[BS] LoadLowResolutionFromFile: No low resolution tier in %s"), *Path);
+		return false;
+	}
+
+	FMemoryReader TierReader(TierBytes, true);
+	uint8 TierQuantization = 0;
+	TierReader << TierQuantization;
+
+	const FBloodStainFileOptions TierOptions = BloodStainFileUtils_Internal::GetLowResolutionOptions(FileHeader.Options, static_cast<ETransformQuantizationMethod>(TierQuantization));
+	const TConstArrayView<uint8> Container = TConstArrayView<uint8>(TierBytes).RightChop(static_cast<int32>(TierReader.Tell()));
+	if (TierReader.IsError() || TierQuantization > static_cast<uint8>(ETransformQuantizationMethod::Standard_SmallestThree)
+		|| !BloodStainBlockUtils::ReadContainer(Container, TierOptions, FileHeader.Version, OutData))
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] LoadLowResolutionFromFile: Failed to decode tier of %s"), *Path);
+		return false;
+	}
+
+	OutData.Header.FileName = FName(FileName);
 	return true;
 }
 
@@ -192,7 +1108,7 @@ bool BloodStainFileUtils::LoadRawPayloadFromFile(const FString& FileName, const
 {
 	const FString Path = BloodStainFileUtils_Internal::GetFullFilePath(FileName, LevelName);
 	TArray<uint8> AllBytes;
-	if (!FFileHelper::LoadFileToArray(AllBytes, *Path))
+	if (!BloodStainFileUtils_Internal::ReadRecordingToArray(AllBytes, GetRelativeFilePath(FileName, LevelName), EBloodStainIOPriority::Interactive))
 	{
 		UE_LOG(LogBloodStain, Error, TEXT("[BloodStainFileUtils] LoadRawPayloadFromFile failed read: %s"), *Path);
 		return false;
@@ -204,8 +1120,11 @@ bool BloodStainFileUtils::LoadRawPayloadFromFile(const FString& FileName, const
 
 	// Only Deserialize the file header and record header
 	MemR << HeaderByteSize;
-	MemR << OutFileHeader;
-	MemR << OutRecordHeader;
+	if (!BloodStainFileUtils_Internal::ReadHeaders(MemR, OutFileHeader, OutRecordHeader))
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BloodStainFileUtils] LoadRawPayloadFromFile failed to read headers: %s"), *Path);
+		return false;
+	}
 	OutRecordHeader.FileName = FName(FileName);
 	
 	const int64 Offset = MemR.Tell();
@@ -229,62 +1148,89 @@ bool BloodStainFileUtils::LoadHeaderFromFile(const FString& FileName, const FStr
 bool BloodStainFileUtils::LoadHeaderFromFile(const FString& RelativeFilePath, FRecordHeaderData& OutRecordHeaderData)
 {	
 	const FString Path = BloodStainFileUtils_Internal::GetFullFilePath(RelativeFilePath);
-	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
-	TUniquePtr<IFileHandle> FileHandle(PlatformFile.OpenRead(*Path));
 
-	if (!FileHandle)
+	// Only the size-prefixed header block is read, so header scans stay cheap next to full loads
+	TArray<uint8> HeaderBytes;
+	const bool bRead = FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Prefetch, [&Path, &HeaderBytes, &RelativeFilePath]()
 	{
-		UE_LOG(LogBloodStain, Error, TEXT("[BS] Failed to open file for reading: %s"), *Path);
-		return false;
-	}
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		if (!PlatformFile.FileExists(*Path))
+		{
+			// Packed recordings keep a copy of their header block in the pack directory
+			FBloodStainPackEntry Entry;
+			int32 Generation = 0;
+			if (BloodStainPackUtils::FindEntry(BloodStainFileUtils_Internal::GetSaveDirectory() / FPaths::GetPath(RelativeFilePath), FPaths::GetCleanFilename(RelativeFilePath), Entry, Generation)
+				&& Entry.HeaderBytes.Num() > static_cast<int32>(sizeof(int32)))
+			{
+				HeaderBytes = TArray<uint8>(TConstArrayView<uint8>(Entry.HeaderBytes).RightChop(sizeof(int32)));
+				return true;
+			}
+		}
 
-	if (FileHandle->Size() <= 0)
-	{
-		UE_LOG(LogBloodStain, Error, TEXT("[BS] File is smaller than the expected header size: %s"), *Path);
-		return false;
-	}
-	
-	int32 HeaderByteSize = 0;
+		TUniquePtr<IFileHandle> FileHandle(PlatformFile.OpenRead(*Path));
 
-	int32 IntByteSize = sizeof(int32);
-	{
-		TArray<uint8> IntBuffer;
-		IntBuffer.SetNum(IntByteSize);
-		
-		if (FileHandle->Size() < IntByteSize)
+		if (!FileHandle)
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] Failed to open file for reading: %s"), *Path);
+			return false;
+		}
+
+		if (FileHandle->Size() <= 0)
 		{
 			UE_LOG(LogBloodStain, Error, TEXT("[BS] File is smaller than the expected header size: %s"), *Path);
 			return false;
 		}
 		
-		if (!FileHandle->Read(IntBuffer.GetData(), IntByteSize))
+		int32 HeaderByteSize = 0;
+
+		int32 IntByteSize = sizeof(int32);
 		{
-			UE_LOG(LogBloodStain, Error, TEXT("[BS] Failed to read header size from file: %s"), *Path);
-			return false;
+			TArray<uint8> IntBuffer;
+			IntBuffer.SetNum(IntByteSize);
+			
+			if (FileHandle->Size() < IntByteSize)
+			{
+				UE_LOG(LogBloodStain, Error, TEXT("[BS] File is smaller than the expected header size: %s"), *Path);
+				return false;
+			}
+			
+			if (!FileHandle->Read(IntBuffer.GetData(), IntByteSize))
+			{
+				UE_LOG(LogBloodStain, Error, TEXT("[BS] Failed to read header size from file: %s"), *Path);
+				return false;
+			}
+
+			FMemoryReader IntReader(IntBuffer, true);
+			IntReader << HeaderByteSize;
 		}
 
-		FMemoryReader IntReader(IntBuffer, true);
-		IntReader << HeaderByteSize;
-	}
+		if (FileHandle->Size() < HeaderByteSize)
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] File is smaller than the expected header size: %s"), *Path);
+			return false;
+		}
 
-	if (FileHandle->Size() < HeaderByteSize)
-	{
-		UE_LOG(LogBloodStain, Error, TEXT("[BS] File is smaller than the expected header size: %s"), *Path);
-		return false;
-	}
+		HeaderBytes.SetNum(HeaderByteSize);
+		if (!FileHandle->Read(HeaderBytes.GetData(), HeaderByteSize - IntByteSize))
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] Failed to read header data from file: %s"), *Path);
+			return false;
+		}
+		return true;
+	});
 
-	TArray<uint8> HeaderBytes;
-	HeaderBytes.SetNum(HeaderByteSize);
-	if (!FileHandle->Read(HeaderBytes.GetData(), HeaderByteSize - IntByteSize))
+	if (!bRead)
 	{
-		UE_LOG(LogBloodStain, Error, TEXT("[BS] Failed to read header data from file: %s"), *Path);
 		return false;
 	}
 	
 	FMemoryReader MemR(HeaderBytes, true);
 	FBloodStainFileHeader FileHeader;
-	MemR << FileHeader;
-	MemR << OutRecordHeaderData;
+	if (!BloodStainFileUtils_Internal::ReadHeaders(MemR, FileHeader, OutRecordHeaderData))
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] Failed to parse header data from file: %s"), *Path);
+		return false;
+	}
 	
 	FString FileNameWithoutExtension = FPaths::GetBaseFilename(RelativeFilePath);
 	OutRecordHeaderData.FileName = FName(FileNameWithoutExtension);
@@ -297,71 +1243,20 @@ int32 BloodStainFileUtils::LoadHeadersForAllFilesInLevel(TMap<FString, FRecordHe
 	// Initialize existing map data
 	OutLoadedHeaders.Empty();
 
-	IFileManager& FileManager = IFileManager::Get();
-	const FString FilePattern = FString(TEXT("*")) + BloodStainFileUtils_Internal::FILE_EXTENSION; // "*.bin"
-	
-	for (const FString& LevelName : LevelNames)
+	FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Prefetch, [&OutLoadedHeaders, &LevelNames]()
 	{
-		// Decide the directory and file pattern to search for
-		const FString SearchDirectory = BloodStainFileUtils_Internal::GetSaveDirectory() / LevelName;
-
-		// Find all files in the specified directory that match the pattern
-		TArray<FString> FoundFileNamesWithExt;
-		FileManager.FindFiles(FoundFileNamesWithExt, *SearchDirectory, *FilePattern);
-
-		UE_LOG(LogBloodStain, Log, TEXT("Found %d recording files in %s."), FoundFileNamesWithExt.Num(), *SearchDirectory);
-
-		// Load each found file
-		for (const FString& FileNameWithExt : FoundFileNamesWithExt)
+		for (const FString& LevelName : LevelNames)
 		{
-			FString BaseFileName = FileNameWithExt;
-			BaseFileName.RemoveFromEnd(BloodStainFileUtils_Internal::FILE_EXTENSION);
-
-			FRecordHeaderData LoadedData;
-			if (LoadHeaderFromFile(BaseFileName, LevelName, LoadedData))
-			{
-				const FString RelativeFilePath = GetRelativeFilePath(BaseFileName, LevelName);
-				// If loading was successful, add to the map
-				OutLoadedHeaders.Add(RelativeFilePath, LoadedData);
-			}
+			BloodStainFileUtils_Internal::ScanHeadersInLevel(LevelName, OutLoadedHeaders);
 		}
-	}
+		return true;
+	});
 	return OutLoadedHeaders.Num();
 }
 
 int32 BloodStainFileUtils::LoadHeadersForAllFilesInLevel(TMap<FString, FRecordHeaderData>& OutLoadedHeaders, const FString& LevelName)
 {
-	// Initialize existing map data
-	OutLoadedHeaders.Empty();
-
-	IFileManager& FileManager = IFileManager::Get();
-
-	// Decide the directory and file pattern to search for
-	const FString SearchDirectory = BloodStainFileUtils_Internal::GetSaveDirectory() / LevelName;
-	const FString FilePattern = FString(TEXT("*")) + BloodStainFileUtils_Internal::FILE_EXTENSION; // "*.bin"
-
-	// Find all files in the specified directory that match the pattern
-	TArray<FString> FoundFileNamesWithExt;
-	FileManager.FindFiles(FoundFileNamesWithExt, *SearchDirectory, *FilePattern);
-
-	UE_LOG(LogBloodStain, Log, TEXT("Found %d recording files in %s."), FoundFileNamesWithExt.Num(), *SearchDirectory);
-
-	// Load each found file
-	for (const FString& FileNameWithExt : FoundFileNamesWithExt)
-	{
-		FString BaseFileName = FileNameWithExt;
-		BaseFileName.RemoveFromEnd(BloodStainFileUtils_Internal::FILE_EXTENSION);
-
-		FRecordHeaderData LoadedData;
-		if (LoadHeaderFromFile(BaseFileName, LevelName, LoadedData))
-		{
-			const FString RelativeFilePath = GetRelativeFilePath(BaseFileName, LevelName);
-			// If loading was successful, add to the map
-			OutLoadedHeaders.Add(RelativeFilePath, LoadedData);
-		}
-	}
-
-	return OutLoadedHeaders.Num();
+	return LoadHeadersForAllFilesInLevel(OutLoadedHeaders, TArray<FString>{ LevelName });
 }
 
 int32 BloodStainFileUtils::LoadHeadersForAllFiles(TMap<FString, FRecordHeaderData>& OutLoadedHeaders)
@@ -369,96 +1264,50 @@ int32 BloodStainFileUtils::LoadHeadersForAllFiles(TMap<FString, FRecordHeaderDat
 	// Initialize existing map data
 	OutLoadedHeaders.Empty();
 
-	IFileManager& FileManager = IFileManager::Get();
-
-	// Decide the directory and file pattern to search for
-	const FString SearchDirectory = BloodStainFileUtils_Internal::GetSaveDirectory();
-	const FString FilePattern = FString(TEXT("*")) + BloodStainFileUtils_Internal::FILE_EXTENSION; // "*.bin"
-
-	// Find all files in the specified directory that match the pattern
-	TArray<FString> FoundFileNamesWithExt;
-	FileManager.FindFilesRecursive(FoundFileNamesWithExt, *SearchDirectory, *FilePattern, true, false);
-
-	UE_LOG(LogBloodStain, Log, TEXT("Found %d recording files in %s."), FoundFileNamesWithExt.Num(), *SearchDirectory);
-
-	// Load each found file
-	for (const FString& FileNameWithExt : FoundFileNamesWithExt)
+	FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Prefetch, [&OutLoadedHeaders]()
 	{
-		const FString RelativeFilePathWithExt = FileNameWithExt.Replace(*SearchDirectory, TEXT(""));
-		
-		FString RelativeFilePathWithoutExt = RelativeFilePathWithExt;
-		RelativeFilePathWithoutExt.RemoveFromStart(TEXT("/"));
-		RelativeFilePathWithoutExt.RemoveFromEnd(BloodStainFileUtils_Internal::FILE_EXTENSION);
-
-		FRecordHeaderData LoadedData;
-		if (LoadHeaderFromFile(RelativeFilePathWithoutExt, LoadedData))
-		{
-			// If loading was successful, add to the map
-			OutLoadedHeaders.Add(RelativeFilePathWithExt, LoadedData);
-		}
-	}
-
+		BloodStainFileUtils_Internal::ScanAllHeaders(OutLoadedHeaders);
+		return true;
+	});
 	return OutLoadedHeaders.Num();
 }
 
-int32 BloodStainFileUtils::LoadAllFilesInLevel(TMap<FString, FRecordSaveData>& OutLoadedDataMap, const FString& LevelName)
+void BloodStainFileUtils::LoadHeadersForAllFilesInLevelAsync(const TArray<FString>& LevelNames, TUniqueFunction<void(TMap<FString, FRecordHeaderData>&& LoadedHeaders)>&& OnLoaded)
 {
-	OutLoadedDataMap.Empty();
-
-	IFileManager& FileManager = IFileManager::Get();
-
-	const FString SearchDirectory = BloodStainFileUtils_Internal::GetSaveDirectory() / LevelName;
-	const FString FilePattern = FString(TEXT("*")) + BloodStainFileUtils_Internal::FILE_EXTENSION; // "*.bin"
-
-	TArray<FString> FoundFileNamesWithExt;
-	FileManager.FindFiles(FoundFileNamesWithExt, *SearchDirectory, *FilePattern);
-
-	UE_LOG(LogBloodStain, Log, TEXT("Found %d recording files in %s."), FoundFileNamesWithExt.Num(), *SearchDirectory);
-
-	for (const FString& FileNameWithExt : FoundFileNamesWithExt)
+	BloodStainFileUtils_Internal::LaunchScan<TMap<FString, FRecordHeaderData>>(EBloodStainIOPriority::Prefetch, [LevelNames](TMap<FString, FRecordHeaderData>& LoadedHeaders)
 	{
-		FString BaseFileName = FileNameWithExt;
-		BaseFileName.RemoveFromEnd(BloodStainFileUtils_Internal::FILE_EXTENSION);
-
-		FRecordSaveData LoadedData;
-		if (LoadFromFile(BaseFileName, LevelName, LoadedData))
+		for (const FString& LevelName : LevelNames)
 		{
-			OutLoadedDataMap.Add(BaseFileName, LoadedData);
+			BloodStainFileUtils_Internal::ScanHeadersInLevel(LevelName, LoadedHeaders);
 		}
-	}
+	}, MoveTemp(OnLoaded));
+}
 
-	return OutLoadedDataMap.Num();
+void BloodStainFileUtils::LoadHeadersForAllFilesAsync(TUniqueFunction<void(TMap<FString, FRecordHeaderData>&& LoadedHeaders)>&& OnLoaded)
+{
+	BloodStainFileUtils_Internal::LaunchScan<TMap<FString, FRecordHeaderData>>(EBloodStainIOPriority::Prefetch, [](TMap<FString, FRecordHeaderData>& LoadedHeaders)
+	{
+		BloodStainFileUtils_Internal::ScanAllHeaders(LoadedHeaders);
+	}, MoveTemp(OnLoaded));
+}
+
+int32 BloodStainFileUtils::LoadAllFilesInLevel(TMap<FString, FRecordSaveData>& OutLoadedDataMap, const FString& LevelName)
+{
+	return LoadAllFilesInLevel(OutLoadedDataMap, TArray<FString>{ LevelName });
 }
 
 int32 BloodStainFileUtils::LoadAllFilesInLevel(TMap<FString, FRecordSaveData>& OutLoadedDataMap, const TArray<FString>& LevelNames)
 {
 	OutLoadedDataMap.Empty();
 
-	IFileManager& FileManager = IFileManager::Get();
-	const FString FilePattern = FString(TEXT("*")) + BloodStainFileUtils_Internal::FILE_EXTENSION; // "*.bin"
-
-	for (const FString& LevelName : LevelNames)
+	FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Interactive, [&OutLoadedDataMap, &LevelNames]()
 	{
-		const FString SearchDirectory = BloodStainFileUtils_Internal::GetSaveDirectory() / LevelName;
-
-		TArray<FString> FoundFileNamesWithExt;
-		FileManager.FindFiles(FoundFileNamesWithExt, *SearchDirectory, *FilePattern);
-
-		UE_LOG(LogBloodStain, Log, TEXT("Found %d recording files in %s."), FoundFileNamesWithExt.Num(), *SearchDirectory);
-
-		for (const FString& FileNameWithExt : FoundFileNamesWithExt)
+		for (const FString& LevelName : LevelNames)
 		{
-			FString BaseFileName = FileNameWithExt;
-			BaseFileName.RemoveFromEnd(BloodStainFileUtils_Internal::FILE_EXTENSION);
-
-			FRecordSaveData LoadedData;
-			if (LoadFromFile(BaseFileName, LevelName, LoadedData))
-			{
-				OutLoadedDataMap.Add(BaseFileName, LoadedData);
-			}
+			BloodStainFileUtils_Internal::ScanAllFilesInLevel(LevelName, OutLoadedDataMap);
 		}
-	}
-
+		return true;
+	});
 	return OutLoadedDataMap.Num();
 }
 
@@ -466,31 +1315,11 @@ int32 BloodStainFileUtils::LoadAllFiles(TMap<FString, FRecordSaveData>& OutLoade
 {
 	OutLoadedDataMap.Empty();
 
-	IFileManager& FileManager = IFileManager::Get();
-
-	const FString SearchDirectory = BloodStainFileUtils_Internal::GetSaveDirectory();
-	const FString FilePattern = FString(TEXT("*")) + BloodStainFileUtils_Internal::FILE_EXTENSION; // "*.bin"
-
-	TArray<FString> FoundFileNamesWithExt;
-	FileManager.FindFilesRecursive(FoundFileNamesWithExt, *SearchDirectory, *FilePattern, true, false);
-
-	UE_LOG(LogBloodStain, Log, TEXT("Found %d recording files in %s."), FoundFileNamesWithExt.Num(), *SearchDirectory);
-
-	for (const FString& FileNameWithExt : FoundFileNamesWithExt)
+	FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Interactive, [&OutLoadedDataMap]()
 	{
-		const FString RelativeFilePathWithExt = FileNameWithExt.Replace(*SearchDirectory, TEXT(""));
-		
-		FString RelativeFilePathWithoutExt = RelativeFilePathWithExt;
-		RelativeFilePathWithoutExt.RemoveFromStart(TEXT("/"));
-		RelativeFilePathWithoutExt.RemoveFromEnd(BloodStainFileUtils_Internal::FILE_EXTENSION);
-
-		FRecordSaveData LoadedData;
-		if (LoadFromFile(RelativeFilePathWithoutExt, LoadedData))
-		{
-			OutLoadedDataMap.Add(RelativeFilePathWithoutExt, LoadedData);
-		}
-	}
-
+		BloodStainFileUtils_Internal::ScanAllFiles(OutLoadedDataMap);
+		return true;
+	});
 	return OutLoadedDataMap.Num();
 }
 
@@ -501,74 +1330,95 @@ bool BloodStainFileUtils::DeleteFile(const FString& FileName, const FString& Lev
 	
 	if (FPaths::FileExists(Path))
 	{
-		const bool bSuccess = IFileManager::Get().Delete(*Path);
+		const bool bSuccess = FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Maintenance, [&Path]()
+		{
+			return IFileManager::Get().Delete(*Path);
+		});
 		if (!bSuccess)
 		{
 			UE_LOG(LogTemp, Warning, TEXT("[Delete File] Failed to delete file: %s"), *Path);
 		}
 		return bSuccess;
 	}
-	else
+
+	// Packed recordings are removed from the directory; their bytes are reclaimed by a background compaction
+	const FString LevelDir = BloodStainFileUtils_Internal::GetSaveDirectory(LevelName);
+	const bool bRemoved = FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Maintenance, [&LevelDir, &FileName]()
+	{
+		return BloodStainPackUtils::RemoveEntry(LevelDir, FileName);
+	});
+	if (!bRemoved)
 	{
 		UE_LOG(LogBloodStain, Warning, TEXT("[Delete File] File does not exist: %s"), *Path);
 		return false;
 	}
+
+	BloodStainFileUtils_Internal::ScheduleCompaction(LevelDir);
+	return true;
+}
+
+bool BloodStainFileUtils::CompactLevelPack(const FString& LevelName)
+{
+	const FString LevelDir = BloodStainFileUtils_Internal::GetSaveDirectory(LevelName);
+	return FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Maintenance, [&LevelDir]()
+	{
+		return BloodStainPackUtils::HasPack(LevelDir) && BloodStainPackUtils::Compact(LevelDir);
+	});
 }
 
 bool BloodStainFileUtils::FileExists(const FString& FileName, const FString& LevelName)
 {
 	const FString Path = BloodStainFileUtils_Internal::GetFullFilePath(FileName, LevelName);
-	return FPaths::FileExists(Path);
+	const FString LevelDir = BloodStainFileUtils_Internal::GetSaveDirectory(LevelName);
+	return FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Interactive, [&Path, &LevelDir, &FileName]()
+	{
+		if (FPaths::FileExists(Path))
+		{
+			return true;
+		}
+
+		return BloodStainPackUtils::HasEntry(LevelDir, FileName);
+	});
 }
 
 TArray<FString> BloodStainFileUtils::GetSavedLevelNames()
 {
-	IFileManager& FileManager = IFileManager::Get();
-
-	const FString SearchDirectory = BloodStainFileUtils_Internal::GetSaveDirectory();
-
-	TArray<FString> SubDirectories;
-	FileManager.FindFiles(SubDirectories, *(SearchDirectory / TEXT("*")), false, true);
-
 	TArray<FString> LevelNames;
-	
-	for (const FString& SubDirName : SubDirectories)
+	FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Prefetch, [&LevelNames]()
 	{
-		const FString FullSubDirPath = SearchDirectory / SubDirName;
-
-		TArray<FString> FilesInSubDir;
-		FileManager.FindFiles(FilesInSubDir, *(FullSubDirPath / TEXT("*.*")), true, false);
-
-		if (FilesInSubDir.Num() > 0)
-		{
-			LevelNames.Add(SubDirName);
-		}
-	}
-
+		LevelNames = BloodStainFileUtils_Internal::ScanSavedLevelNames();
+		return true;
+	});
 	return LevelNames;
 }
 
 TArray<FString> BloodStainFileUtils::GetSavedFileNames(const FString& LevelName)
 {
-	IFileManager& FileManager = IFileManager::Get();
-	
-	const FString SearchDirectory = BloodStainFileUtils_Internal::GetSaveDirectory();
-	const FString LevelDirectory = SearchDirectory / LevelName;
-	
-	TArray<FString> FileNamesWithExt;
-	FileManager.FindFiles(FileNamesWithExt, *(LevelDirectory / TEXT("*.*")), true, false);
-
 	TArray<FString> FileNames;
-
-	for (const FString& FileNameWithExt : FileNamesWithExt)
+	FBloodStainIOScheduler::Get().SubmitAndWait(EBloodStainIOPriority::Prefetch, [&FileNames, &LevelName]()
 	{
-		const FString FileName = FPaths::GetBaseFilename(FileNameWithExt);
-		FileNames.Add(FileName);
-	}
-	
+		FileNames = BloodStainFileUtils_Internal::ScanSavedFileNames(LevelName);
+		return true;
+	});
 	return FileNames;
 }
 
+void BloodStainFileUtils::GetSavedLevelNamesAsync(TUniqueFunction<void(TArray<FString>&& LevelNames)>&& OnFound)
+{
+	BloodStainFileUtils_Internal::LaunchScan<TArray<FString>>(EBloodStainIOPriority::Prefetch, [](TArray<FString>& LevelNames)
+	{
+		LevelNames = BloodStainFileUtils_Internal::ScanSavedLevelNames();
+	}, MoveTemp(OnFound));
+}
+
+void BloodStainFileUtils::GetSavedFileNamesAsync(const FString& LevelName, TUniqueFunction<void(TArray<FString>&& FileNames)>&& OnFound)
+{
+	BloodStainFileUtils_Internal::LaunchScan<TArray<FString>>(EBloodStainIOPriority::Prefetch, [LevelName](TArray<FString>& FileNames)
+	{
+		FileNames = BloodStainFileUtils_Internal::ScanSavedFileNames(LevelName);
+	}, MoveTemp(OnFound));
+}
+
 FString BloodStainFileUtils::GetFullFilePath(const FString& FileName, const FString& LevelName)
 {
 	return BloodStainFileUtils_Internal::GetFullFilePath(FileName, LevelName);
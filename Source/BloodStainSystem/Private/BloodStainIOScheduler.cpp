@@ -0,0 +1,197 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#include "BloodStainIOScheduler.h"
+#include "BloodStainSystem.h"
+#include "Async/Async.h"
+#include "Misc/QueuedThreadPool.h"
+#include "Tasks/Task.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("IOScheduler QueueDepth"), STAT_IOScheduler_QueueDepth, STATGROUP_BloodStain);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("IOScheduler Running"), STAT_IOScheduler_Running, STATGROUP_BloodStain);
+DECLARE_DWORD_COUNTER_STAT(TEXT("IOScheduler Coalesced"), STAT_IOScheduler_Coalesced, STATGROUP_BloodStain);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("IOScheduler Last Queue Latency (ms)"), STAT_IOScheduler_QueueLatency, STATGROUP_BloodStain);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("IOScheduler Last Execute Time (ms)"), STAT_IOScheduler_ExecuteTime, STATGROUP_BloodStain);
+
+namespace BloodStainIOScheduler_Internal
+{
+	/** Set while a worker runs a request, so nested requests run inline instead of waiting on a slot they hold */
+	thread_local bool bIsIOWorker = false;
+
+	bool IsBackgroundClass(EBloodStainIOPriority Priority)
+	{
+		return Priority == EBloodStainIOPriority::Save || Priority == EBloodStainIOPriority::Maintenance;
+	}
+}
+
+FBloodStainIOScheduler& FBloodStainIOScheduler::Get()
+{
+	static FBloodStainIOScheduler Instance;
+	return Instance;
+}
+
+FBloodStainIOScheduler::FBloodStainIOScheduler()
+{
+	if (FPlatformProcess::SupportsMultithreading())
+	{
+		ThreadPool.Reset(FQueuedThreadPool::Allocate());
+		if (!ThreadPool->Create(MaxConcurrentRequests + ReservedInteractiveRequests, 128 * 1024, TPri_BelowNormal, TEXT("BloodStainIOThreadPool")))
+		{
+			UE_LOG(LogBloodStain, Warning, TEXT("[BS] IOScheduler: Failed to create the I/O thread pool, running requests as tasks"));
+			ThreadPool.Reset();
+		}
+	}
+}
+
+FBloodStainIOScheduler::~FBloodStainIOScheduler()
+{
+	if (ThreadPool)
+	{
+		ThreadPool->Destroy();
+	}
+}
+
+TFuture<bool> FBloodStainIOScheduler::Submit(EBloodStainIOPriority Priority, TUniqueFunction<bool()>&& Work, const FString& CoalesceKey)
+{
+	const int32 ClassIndex = static_cast<int32>(Priority);
+
+	// Backpressure: hold background producers until their class has room. The game thread is never blocked
+	if (BloodStainIOScheduler_Internal::IsBackgroundClass(Priority) && !IsInGameThread() && !BloodStainIOScheduler_Internal::bIsIOWorker)
+	{
+		while (GetQueueDepth(Priority) >= MaxQueuedBackgroundRequests)
+		{
+			QueueDrainedEvent->Wait(10);
+		}
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	TArray<TUniquePtr<FRequest>>& Queue = Queues[ClassIndex];
+
+	if (Priority == EBloodStainIOPriority::Save && !CoalesceKey.IsEmpty())
+	{
+		for (TUniquePtr<FRequest>& Queued : Queue)
+		{
+			if (Queued->CoalesceKey == CoalesceKey)
+			{
+				// The older write would be overwritten anyway; keep its slot in line but run the newer work.
+				// Its callers learn that their data was never written rather than inheriting the newer result
+				UE_LOG(LogBloodStain, Log, TEXT("[BS] IOScheduler: queued save to %s superseded by a newer one"), *CoalesceKey);
+				TArray<TPromise<bool>> Superseded = MoveTemp(Queued->Promises);
+				Queued->Promises.Reset();
+				Queued->Work = MoveTemp(Work);
+				TFuture<bool> Future = Queued->Promises.AddDefaulted_GetRef().GetFuture();
+				INC_DWORD_STAT(STAT_IOScheduler_Coalesced);
+
+				// Continuations run inside SetValue; never run them under the lock
+				ScopeLock.Unlock();
+				for (TPromise<bool>& Promise : Superseded)
+				{
+					Promise.SetValue(false);
+				}
+				return Future;
+			}
+		}
+	}
+
+	if (BloodStainIOScheduler_Internal::IsBackgroundClass(Priority) && Queue.Num() >= MaxQueuedBackgroundRequests)
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BS] IOScheduler: background queue %d is full (%d requests)"), ClassIndex, Queue.Num());
+	}
+
+	TUniquePtr<FRequest> Request = MakeUnique<FRequest>();
+	Request->Work = MoveTemp(Work);
+	Request->CoalesceKey = CoalesceKey;
+	Request->QueuedTime = FPlatformTime::Seconds();
+	TFuture<bool> Future = Request->Promises.AddDefaulted_GetRef().GetFuture();
+
+	Queue.Add(MoveTemp(Request));
+	INC_DWORD_STAT(STAT_IOScheduler_QueueDepth);
+
+	Pump_Locked();
+	return Future;
+}
+
+bool FBloodStainIOScheduler::SubmitAndWait(EBloodStainIOPriority Priority, TUniqueFunction<bool()>&& Work, const FString& CoalesceKey)
+{
+	if (BloodStainIOScheduler_Internal::bIsIOWorker)
+	{
+		return Work();
+	}
+
+	TFuture<bool> Future = Submit(Priority, MoveTemp(Work), CoalesceKey);
+	return Future.Get();
+}
+
+int32 FBloodStainIOScheduler::GetQueueDepth(EBloodStainIOPriority Priority) const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Queues[static_cast<int32>(Priority)].Num();
+}
+
+void FBloodStainIOScheduler::Pump_Locked()
+{
+	while (NumRunning < MaxConcurrentRequests + ReservedInteractiveRequests)
+	{
+		constexpr int32 NumClasses = static_cast<int32>(EBloodStainIOPriority::Num);
+		int32 ClassIndex = 0;
+		while (ClassIndex < NumClasses && Queues[ClassIndex].Num() == 0)
+		{
+			++ClassIndex;
+		}
+
+		// The reserved slots stay free for Interactive requests
+		if (ClassIndex == NumClasses
+			|| (ClassIndex != static_cast<int32>(EBloodStainIOPriority::Interactive) && NumRunning >= MaxConcurrentRequests))
+		{
+			return;
+		}
+
+		TUniquePtr<FRequest> Request = MoveTemp(Queues[ClassIndex][0]);
+		Queues[ClassIndex].RemoveAt(0);
+
+		++NumRunning;
+		DEC_DWORD_STAT(STAT_IOScheduler_QueueDepth);
+		INC_DWORD_STAT(STAT_IOScheduler_Running);
+		QueueDrainedEvent->Trigger();
+
+		if (ThreadPool)
+		{
+			AsyncPool(*ThreadPool, [this, Request = MoveTemp(Request)]() mutable
+			{
+				Execute(MoveTemp(Request));
+			});
+		}
+		else
+		{
+			UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, Request = MoveTemp(Request)]() mutable
+			{
+				Execute(MoveTemp(Request));
+			});
+		}
+	}
+}
+
+void FBloodStainIOScheduler::Execute(TUniquePtr<FRequest> Request)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	SET_FLOAT_STAT(STAT_IOScheduler_QueueLatency, (StartTime - Request->QueuedTime) * 1000.0);
+
+	BloodStainIOScheduler_Internal::bIsIOWorker = true;
+	const bool bResult = Request->Work();
+	BloodStainIOScheduler_Internal::bIsIOWorker = false;
+
+	SET_FLOAT_STAT(STAT_IOScheduler_ExecuteTime, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	for (TPromise<bool>& Promise : Request->Promises)
+	{
+		Promise.SetValue(bResult);
+	}
+
+	FScopeLock ScopeLock(&Lock);
+	--NumRunning;
+	DEC_DWORD_STAT(STAT_IOScheduler_Running);
+	Pump_Locked();
+}
@@ -0,0 +1,629 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#include "BloodStainPackUtils.h"
+#include "BloodStainSystem.h"
+#include "HAL/FileManager.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryReaderView.h"
+#include "Serialization/MemoryWriter.h"
+
+DECLARE_CYCLE_STAT(TEXT("PackUtils ReadDirectory"), STAT_PackUtils_ReadDirectory, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("PackUtils Compact"), STAT_PackUtils_Compact, STATGROUP_BloodStain);
+
+namespace BloodStainPackUtils_Internal
+{
+	/** 'BSPD' */
+	constexpr uint32 DirectoryMagic = 0x42535044;
+
+	/** 2: every journal record is framed by its size and CRC32 */
+	constexpr uint32 PackVersion = 2;
+
+	/** Size and CRC32 of the body in front of every journal record */
+	constexpr int64 RecordFrameSize = sizeof(int32) + sizeof(uint32);
+
+	/** Bytes moved per read/write while compacting */
+	constexpr int64 CopyChunkSize = 1024 * 1024;
+
+	enum class EPackRecord : uint8
+	{
+		Add,
+		Remove
+	};
+
+	/** Serializes appends and compactions of every pack in the process */
+	FCriticalSection WriterLock;
+
+	/** State of a directory journal file when it was parsed */
+	struct FJournalState
+	{
+		int64 Size = 0;
+		FDateTime TimeStamp;
+
+		/** Offset just past the last complete record; a journal larger than this has a torn tail */
+		int64 End = 0;
+	};
+
+	struct FCachedDirectory
+	{
+		FBloodStainPackDirectory Directory;
+		FJournalState Journal;
+	};
+
+	/** Parsed directories by journal path, so lookups do not replay the journal. Guarded by CacheLock; take it after WriterLock */
+	FCriticalSection CacheLock;
+	TMap<FString, FCachedDirectory> DirectoryCache;
+
+	void SerializeDirectoryHeader(FArchive& Ar, int32& Generation)
+	{
+		uint32 Magic = DirectoryMagic;
+		uint32 Version = PackVersion;
+		Ar << Magic;
+		Ar << Version;
+		Ar << Generation;
+		if (Ar.IsLoading() && (Magic != DirectoryMagic || Version != PackVersion))
+		{
+			Ar.SetError();
+		}
+	}
+
+	/** Serializes the fields of an Add record that follow its name */
+	void SerializeEntry(FArchive& Ar, FBloodStainPackEntry& Entry)
+	{
+		Ar << Entry.HeaderOffset;
+		Ar << Entry.HeaderSize;
+		Ar << Entry.PayloadSize;
+		FGameplayTagContainer::StaticStruct()->SerializeItem(Ar, &Entry.Tags, nullptr);
+
+		int32 NumHeaderBytes = Entry.HeaderBytes.Num();
+		Ar << NumHeaderBytes;
+		if (Ar.IsLoading())
+		{
+			if (Ar.IsError() || NumHeaderBytes < 0 || NumHeaderBytes > Ar.TotalSize() - Ar.Tell()
+				|| Entry.HeaderOffset < 0 || Entry.HeaderSize <= 0 || Entry.PayloadSize < 0)
+			{
+				Ar.SetError();
+				return;
+			}
+			Entry.HeaderBytes.SetNumUninitialized(NumHeaderBytes);
+		}
+		Ar.Serialize(Entry.HeaderBytes.GetData(), NumHeaderBytes);
+	}
+
+	/** Appends one record to Out: body size, CRC32 of the body, then the body WriteBody writes */
+	void WriteFramedRecord(TArray<uint8>& Out, TFunctionRef<void(FArchive&)> WriteBody)
+	{
+		TArray<uint8> Body;
+		FMemoryWriter BodyAr(Body);
+		WriteBody(BodyAr);
+
+		int32 BodySize = Body.Num();
+		uint32 Crc = FCrc::MemCrc32(Body.GetData(), Body.Num());
+		FMemoryWriter FrameAr(Out, false, /*bSetOffset*/true);
+		FrameAr << BodySize;
+		FrameAr << Crc;
+		FrameAr.Serialize(Body.GetData(), Body.Num());
+	}
+
+	void WriteAddRecord(TArray<uint8>& Out, FBloodStainPackEntry& Entry)
+	{
+		WriteFramedRecord(Out, [&Entry](FArchive& Ar)
+		{
+			uint8 Op = static_cast<uint8>(EPackRecord::Add);
+			Ar << Op;
+			Ar << Entry.Name;
+			SerializeEntry(Ar, Entry);
+		});
+	}
+
+	void WriteRemoveRecord(TArray<uint8>& Out, const FString& Name)
+	{
+		WriteFramedRecord(Out, [&Name](FArchive& Ar)
+		{
+			uint8 Op = static_cast<uint8>(EPackRecord::Remove);
+			FString EntryName = Name;
+			Ar << Op;
+			Ar << EntryName;
+		});
+	}
+
+	/**
+	 * Walks the framed records after the journal header.
+	 * @param Visit Called with the body of every record whose checksum matches; records that fail it are skipped
+	 * @return Offset just past the last complete frame. Anything after it is the torn tail of an interrupted append
+	 */
+	int64 ScanRecords(const TArray<uint8>& Journal, int64 Offset, const FString& DirectoryPath, TFunctionRef<void(TConstArrayView<uint8>)> Visit)
+	{
+		while (Journal.Num() - Offset >= RecordFrameSize)
+		{
+			int32 BodySize = 0;
+			uint32 Crc = 0;
+			FMemory::Memcpy(&BodySize, Journal.GetData() + Offset, sizeof(BodySize));
+			FMemory::Memcpy(&Crc, Journal.GetData() + Offset + sizeof(BodySize), sizeof(Crc));
+			if (BodySize < 0 || BodySize > Journal.Num() - Offset - RecordFrameSize)
+			{
+				break;
+			}
+
+			const TConstArrayView<uint8> Body(Journal.GetData() + Offset + RecordFrameSize, BodySize);
+			if (FCrc::MemCrc32(Body.GetData(), Body.Num()) == Crc)
+			{
+				Visit(Body);
+			}
+			else
+			{
+				UE_LOG(LogBloodStain, Warning, TEXT("[BS] Pack: Skipping directory record at %lld with a bad checksum: %s"), Offset, *DirectoryPath);
+			}
+			Offset += RecordFrameSize + BodySize;
+		}
+		return Offset;
+	}
+
+	/** Replays a journal read into memory. DeadBytes is left for the caller, which knows the data segment */
+	bool ParseDirectory(const TArray<uint8>& Bytes, const FString& DirectoryPath, FBloodStainPackDirectory& OutDirectory, int64& OutJournalEnd)
+	{
+		FMemoryReader Ar(Bytes, true);
+		SerializeDirectoryHeader(Ar, OutDirectory.Generation);
+		if (Ar.IsError())
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] Pack: Invalid directory header: %s"), *DirectoryPath);
+			return false;
+		}
+
+		int32 NumRecords = 0;
+		OutJournalEnd = ScanRecords(Bytes, Ar.Tell(), DirectoryPath, [&OutDirectory, &NumRecords, &DirectoryPath](TConstArrayView<uint8> Body)
+		{
+			FMemoryReaderView RecordAr(Body, true);
+			uint8 Op = 0;
+			FBloodStainPackEntry Entry;
+			RecordAr << Op;
+			RecordAr << Entry.Name;
+			if (Op == static_cast<uint8>(EPackRecord::Add))
+			{
+				SerializeEntry(RecordAr, Entry);
+			}
+			else if (Op != static_cast<uint8>(EPackRecord::Remove))
+			{
+				RecordAr.SetError();
+			}
+
+			if (RecordAr.IsError())
+			{
+				UE_LOG(LogBloodStain, Warning, TEXT("[BS] Pack: Skipping malformed directory record: %s"), *DirectoryPath);
+				return;
+			}
+
+			++NumRecords;
+			if (Op == static_cast<uint8>(EPackRecord::Add))
+			{
+				const FString Name = Entry.Name;
+				OutDirectory.Entries.Add(Name, MoveTemp(Entry));
+			}
+			else
+			{
+				OutDirectory.Entries.Remove(Entry.Name);
+			}
+		});
+
+		if (OutJournalEnd < Bytes.Num())
+		{
+			// An append interrupted by a crash; the next writer cuts it off
+			UE_LOG(LogBloodStain, Warning, TEXT("[BS] Pack: Ignoring torn directory tail at %lld: %s"), OutJournalEnd, *DirectoryPath);
+		}
+
+		for (const TPair<FString, FBloodStainPackEntry>& Pair : OutDirectory.Entries)
+		{
+			OutDirectory.LiveBytes += Pair.Value.GetTotalSize();
+		}
+		OutDirectory.NumStaleRecords = NumRecords - OutDirectory.Entries.Num();
+		return true;
+	}
+
+	bool IsCurrent(const FJournalState& Journal, const FFileStatData& Stat)
+	{
+		return Stat.bIsValid && Journal.Size == Stat.FileSize && Journal.TimeStamp == Stat.ModificationTime;
+	}
+
+	void ForgetDirectory(const FString& DirectoryPath)
+	{
+		FScopeLock CacheScopeLock(&CacheLock);
+		DirectoryCache.Remove(DirectoryPath);
+	}
+
+	/**
+	 * Calls Visit with the parsed directory of LevelDir's pack, with CacheLock held.
+	 * The journal is only read and replayed again once its size or timestamp differs from the cached parse.
+	 * @return false if there is no pack or its directory is not readable
+	 */
+	bool VisitDirectory(const FString& LevelDir, TFunctionRef<void(const FCachedDirectory&)> Visit)
+	{
+		const FString DirectoryPath = BloodStainPackUtils::GetDirectoryPath(LevelDir);
+		const FFileStatData Stat = IFileManager::Get().GetStatData(*DirectoryPath);
+		if (!Stat.bIsValid)
+		{
+			ForgetDirectory(DirectoryPath);
+			return false;
+		}
+
+		{
+			FScopeLock CacheScopeLock(&CacheLock);
+			if (const FCachedDirectory* Cached = DirectoryCache.Find(DirectoryPath))
+			{
+				if (IsCurrent(Cached->Journal, Stat))
+				{
+					Visit(*Cached);
+					return true;
+				}
+			}
+		}
+
+		SCOPE_CYCLE_COUNTER(STAT_PackUtils_ReadDirectory);
+
+		TArray<uint8> Bytes;
+		FCachedDirectory Parsed;
+		if (!FFileHelper::LoadFileToArray(Bytes, *DirectoryPath, FILEREAD_Silent)
+			|| !ParseDirectory(Bytes, DirectoryPath, Parsed.Directory, Parsed.Journal.End))
+		{
+			ForgetDirectory(DirectoryPath);
+			return false;
+		}
+
+		// A journal that changed while it was read gets a newer timestamp, so the next lookup parses it again
+		Parsed.Journal.Size = Bytes.Num();
+		Parsed.Journal.TimeStamp = Stat.ModificationTime;
+
+		const int64 DataSize = IFileManager::Get().FileSize(*BloodStainPackUtils::GetDataPath(LevelDir, Parsed.Directory.Generation));
+		Parsed.Directory.DeadBytes = FMath::Max<int64>(DataSize - Parsed.Directory.LiveBytes, 0);
+
+		FScopeLock CacheScopeLock(&CacheLock);
+		Visit(DirectoryCache.Add(DirectoryPath, MoveTemp(Parsed)));
+		return true;
+	}
+
+	/** @return State of the journal of LevelDir's pack, and its data generation */
+	bool GetJournalState(const FString& LevelDir, FJournalState& OutJournal, int32& OutGeneration)
+	{
+		return VisitDirectory(LevelDir, [&OutJournal, &OutGeneration](const FCachedDirectory& Cached)
+		{
+			OutJournal = Cached.Journal;
+			OutGeneration = Cached.Directory.Generation;
+		});
+	}
+
+	/**
+	 * Appends whole records to the journal in a single write. Call with WriterLock held.
+	 * A torn tail left by an interrupted append is cut off first, so new records never end up behind it; whether there is one
+	 * is known from where the last complete record of the cached parse ends, so a clean journal is never read back.
+	 * @param Before State of the journal the records follow, null for a new pack
+	 * @param ApplyRecords Applies the records to the cached directory, which is updated in place instead of being parsed again
+	 */
+	bool AppendToDirectory(const FString& DirectoryPath, const FJournalState* Before, TArray<uint8>& Records, TFunctionRef<void(FBloodStainPackDirectory&)> ApplyRecords)
+	{
+		bool bWritten = false;
+		if (Before && Before->End < Before->Size)
+		{
+			UE_LOG(LogBloodStain, Warning, TEXT("[BS] Pack: Truncating torn directory tail at %lld: %s"), Before->End, *DirectoryPath);
+
+			TArray<uint8> Journal;
+			if (!FFileHelper::LoadFileToArray(Journal, *DirectoryPath, FILEREAD_Silent) || Journal.Num() < Before->End)
+			{
+				UE_LOG(LogBloodStain, Error, TEXT("[BS] Pack: Failed to read directory: %s"), *DirectoryPath);
+				ForgetDirectory(DirectoryPath);
+				return false;
+			}
+			Journal.SetNum(static_cast<int32>(Before->End));
+			Journal.Append(Records);
+
+			const FString TempDirectoryPath = DirectoryPath + TEXT(".tmp");
+			bWritten = FFileHelper::SaveArrayToFile(Journal, *TempDirectoryPath) && IFileManager::Get().Move(*DirectoryPath, *TempDirectoryPath, /*Replace*/true);
+			if (!bWritten)
+			{
+				UE_LOG(LogBloodStain, Error, TEXT("[BS] Pack: Failed to rewrite directory: %s"), *DirectoryPath);
+				IFileManager::Get().Delete(*TempDirectoryPath, false, false, true);
+			}
+		}
+		else
+		{
+			TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileWriter(*DirectoryPath, FILEWRITE_Append));
+			if (!Ar)
+			{
+				UE_LOG(LogBloodStain, Error, TEXT("[BS] Pack: Failed to open directory for append: %s"), *DirectoryPath);
+				return false;
+			}
+			Ar->Serialize(Records.GetData(), Records.Num());
+			bWritten = Ar->Close() && !Ar->IsError();
+		}
+
+		const FFileStatData Stat = IFileManager::Get().GetStatData(*DirectoryPath);
+		FScopeLock CacheScopeLock(&CacheLock);
+		FCachedDirectory* Cached = DirectoryCache.Find(DirectoryPath);
+		if (!Cached || IsCurrent(Cached->Journal, Stat))
+		{
+			// Nothing cached yet, or a reader already parsed the new journal
+			return bWritten;
+		}
+
+		const bool bCacheWasCurrent = Before && Cached->Journal.Size == Before->Size && Cached->Journal.TimeStamp == Before->TimeStamp;
+		if (!bWritten || !bCacheWasCurrent || !Stat.bIsValid || Stat.FileSize != Before->End + Records.Num())
+		{
+			DirectoryCache.Remove(DirectoryPath);
+			return bWritten;
+		}
+
+		ApplyRecords(Cached->Directory);
+		Cached->Journal.Size = Stat.FileSize;
+		Cached->Journal.End = Stat.FileSize;
+		Cached->Journal.TimeStamp = Stat.ModificationTime;
+		return true;
+	}
+}
+
+FString BloodStainPackUtils::GetDirectoryPath(const FString& LevelDir)
+{
+	return LevelDir / TEXT("Recordings.bspackdir");
+}
+
+FString BloodStainPackUtils::GetDataPath(const FString& LevelDir, int32 Generation)
+{
+	return LevelDir / FString::Printf(TEXT("Recordings.%d.bspack"), Generation);
+}
+
+bool BloodStainPackUtils::HasPack(const FString& LevelDir)
+{
+	return IFileManager::Get().FileExists(*GetDirectoryPath(LevelDir));
+}
+
+bool BloodStainPackUtils::ReadDirectory(const FString& LevelDir, FBloodStainPackDirectory& OutDirectory)
+{
+	OutDirectory = FBloodStainPackDirectory();
+	return BloodStainPackUtils_Internal::VisitDirectory(LevelDir, [&OutDirectory](const BloodStainPackUtils_Internal::FCachedDirectory& Cached)
+	{
+		OutDirectory = Cached.Directory;
+	});
+}
+
+bool BloodStainPackUtils::FindEntry(const FString& LevelDir, const FString& Name, FBloodStainPackEntry& OutEntry, int32& OutGeneration)
+{
+	bool bFound = false;
+	BloodStainPackUtils_Internal::VisitDirectory(LevelDir, [&](const BloodStainPackUtils_Internal::FCachedDirectory& Cached)
+	{
+		if (const FBloodStainPackEntry* Entry = Cached.Directory.Entries.Find(Name))
+		{
+			OutEntry = *Entry;
+			OutGeneration = Cached.Directory.Generation;
+			bFound = true;
+		}
+	});
+	return bFound;
+}
+
+bool BloodStainPackUtils::HasEntry(const FString& LevelDir, const FString& Name)
+{
+	bool bFound = false;
+	BloodStainPackUtils_Internal::VisitDirectory(LevelDir, [&Name, &bFound](const BloodStainPackUtils_Internal::FCachedDirectory& Cached)
+	{
+		bFound = Cached.Directory.Entries.Contains(Name);
+	});
+	return bFound;
+}
+
+bool BloodStainPackUtils::ShouldCompact(const FString& LevelDir)
+{
+	bool bShouldCompact = false;
+	BloodStainPackUtils_Internal::VisitDirectory(LevelDir, [&bShouldCompact](const BloodStainPackUtils_Internal::FCachedDirectory& Cached)
+	{
+		bShouldCompact = BloodStainPackUtils::ShouldCompact(Cached.Directory);
+	});
+	return bShouldCompact;
+}
+
+bool BloodStainPackUtils::AppendEntry(const FString& LevelDir, const FString& Name, TConstArrayView<uint8> HeaderBytes, const FGameplayTagContainer& Tags, TFunctionRef<bool(FArchive&)> WritePayload)
+{
+	FScopeLock ScopeLock(&BloodStainPackUtils_Internal::WriterLock);
+
+	const FString DirectoryPath = GetDirectoryPath(LevelDir);
+	const bool bNewPack = !IFileManager::Get().FileExists(*DirectoryPath);
+
+	int32 Generation = 0;
+	BloodStainPackUtils_Internal::FJournalState Journal;
+	if (!bNewPack && !BloodStainPackUtils_Internal::GetJournalState(LevelDir, Journal, Generation))
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] Pack: Invalid directory header: %s"), *DirectoryPath);
+		return false;
+	}
+
+	IFileManager::Get().MakeDirectory(*LevelDir, /*Tree*/true);
+
+	FBloodStainPackEntry Entry;
+	Entry.Name = Name;
+	Entry.HeaderSize = HeaderBytes.Num();
+	Entry.Tags = Tags;
+	Entry.HeaderBytes = TArray<uint8>(HeaderBytes);
+
+	// The data goes in first; the entry only becomes visible once its directory record is written
+	int64 DataSize = 0;
+	{
+		const FString DataPath = GetDataPath(LevelDir, Generation);
+		TUniquePtr<FArchive> DataAr(IFileManager::Get().CreateFileWriter(*DataPath, FILEWRITE_Append));
+		if (!DataAr)
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] Pack: Failed to open data segment for append: %s"), *DataPath);
+			return false;
+		}
+
+		Entry.HeaderOffset = DataAr->Tell();
+		DataAr->Serialize(Entry.HeaderBytes.GetData(), Entry.HeaderBytes.Num());
+		const bool bPayloadWritten = WritePayload(*DataAr);
+		Entry.PayloadSize = DataAr->Tell() - Entry.GetPayloadOffset();
+		DataSize = DataAr->Tell();
+
+		if (!DataAr->Close() || DataAr->IsError() || !bPayloadWritten)
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] Pack: Failed to append %s to %s"), *Name, *DataPath);
+			// The cached dead byte count does not cover what the failed append left behind
+			BloodStainPackUtils_Internal::ForgetDirectory(DirectoryPath);
+			return false;
+		}
+	}
+
+	TArray<uint8> Records;
+	if (bNewPack)
+	{
+		FMemoryWriter HeaderAr(Records);
+		BloodStainPackUtils_Internal::SerializeDirectoryHeader(HeaderAr, Generation);
+	}
+	BloodStainPackUtils_Internal::WriteAddRecord(Records, Entry);
+	return BloodStainPackUtils_Internal::AppendToDirectory(DirectoryPath, bNewPack ? nullptr : &Journal, Records, [&Entry, DataSize](FBloodStainPackDirectory& Directory)
+	{
+		if (const FBloodStainPackEntry* Replaced = Directory.Entries.Find(Entry.Name))
+		{
+			Directory.LiveBytes -= Replaced->GetTotalSize();
+			++Directory.NumStaleRecords;
+		}
+		Directory.LiveBytes += Entry.GetTotalSize();
+		Directory.DeadBytes = FMath::Max<int64>(DataSize - Directory.LiveBytes, 0);
+		Directory.Entries.Add(Entry.Name, Entry);
+	});
+}
+
+bool BloodStainPackUtils::RemoveEntry(const FString& LevelDir, const FString& Name)
+{
+	FScopeLock ScopeLock(&BloodStainPackUtils_Internal::WriterLock);
+
+	bool bFound = false;
+	BloodStainPackUtils_Internal::FJournalState Journal;
+	BloodStainPackUtils_Internal::VisitDirectory(LevelDir, [&Name, &bFound, &Journal](const BloodStainPackUtils_Internal::FCachedDirectory& Cached)
+	{
+		bFound = Cached.Directory.Entries.Contains(Name);
+		Journal = Cached.Journal;
+	});
+	if (!bFound)
+	{
+		return false;
+	}
+
+	TArray<uint8> Records;
+	BloodStainPackUtils_Internal::WriteRemoveRecord(Records, Name);
+	return BloodStainPackUtils_Internal::AppendToDirectory(GetDirectoryPath(LevelDir), &Journal, Records, [&Name](FBloodStainPackDirectory& Directory)
+	{
+		// Both the removed entry's add record and the removal record are stale now
+		FBloodStainPackEntry Removed;
+		if (Directory.Entries.RemoveAndCopyValue(Name, Removed))
+		{
+			Directory.LiveBytes -= Removed.GetTotalSize();
+			Directory.DeadBytes += Removed.GetTotalSize();
+			Directory.NumStaleRecords += 2;
+		}
+	});
+}
+
+bool BloodStainPackUtils::ShouldCompact(const FBloodStainPackDirectory& Directory)
+{
+	const int64 DataSize = Directory.LiveBytes + Directory.DeadBytes;
+	const bool bManyDeadBytes = Directory.DeadBytes >= CompactionMinDeadBytes && Directory.DeadBytes * 4 >= DataSize;
+	const bool bManyStaleRecords = Directory.NumStaleRecords >= CompactionMinStaleRecords && Directory.NumStaleRecords > Directory.Entries.Num();
+	return bManyDeadBytes || bManyStaleRecords;
+}
+
+bool BloodStainPackUtils::Compact(const FString& LevelDir)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PackUtils_Compact);
+
+	FScopeLock ScopeLock(&BloodStainPackUtils_Internal::WriterLock);
+
+	FBloodStainPackDirectory Directory;
+	if (!ReadDirectory(LevelDir, Directory))
+	{
+		return false;
+	}
+
+	const FString DirectoryPath = GetDirectoryPath(LevelDir);
+	const FString OldDataPath = GetDataPath(LevelDir, Directory.Generation);
+	const int32 NewGeneration = Directory.Generation + 1;
+	const FString NewDataPath = GetDataPath(LevelDir, NewGeneration);
+
+	// Copy in data order so the old segment is read sequentially
+	TArray<FBloodStainPackEntry*> Entries;
+	Entries.Reserve(Directory.Entries.Num());
+	for (TPair<FString, FBloodStainPackEntry>& Pair : Directory.Entries)
+	{
+		Entries.Add(&Pair.Value);
+	}
+	Entries.Sort([](const FBloodStainPackEntry& A, const FBloodStainPackEntry& B)
+	{
+		return A.HeaderOffset < B.HeaderOffset;
+	});
+
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*OldDataPath));
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*NewDataPath));
+	if ((!Reader && Entries.Num() > 0) || !Writer)
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] Pack: Compaction failed to open data segments in %s"), *LevelDir);
+		return false;
+	}
+
+	TArray<uint8> Records;
+	{
+		FMemoryWriter HeaderAr(Records);
+		int32 Generation = NewGeneration;
+		BloodStainPackUtils_Internal::SerializeDirectoryHeader(HeaderAr, Generation);
+	}
+
+	TArray<uint8> CopyBuffer;
+	for (FBloodStainPackEntry* Entry : Entries)
+	{
+		if (Entry->HeaderOffset + Entry->GetTotalSize() > Reader->TotalSize())
+		{
+			UE_LOG(LogBloodStain, Warning, TEXT("[BS] Pack: Dropping %s, its data lies beyond the segment end"), *Entry->Name);
+			continue;
+		}
+
+		Reader->Seek(Entry->HeaderOffset);
+		const int64 NewOffset = Writer->Tell();
+		for (int64 Remaining = Entry->GetTotalSize(); Remaining > 0;)
+		{
+			const int64 ChunkSize = FMath::Min(Remaining, BloodStainPackUtils_Internal::CopyChunkSize);
+			CopyBuffer.SetNumUninitialized(static_cast<int32>(ChunkSize), EAllowShrinking::No);
+			Reader->Serialize(CopyBuffer.GetData(), ChunkSize);
+			Writer->Serialize(CopyBuffer.GetData(), ChunkSize);
+			Remaining -= ChunkSize;
+		}
+
+		Entry->HeaderOffset = NewOffset;
+		BloodStainPackUtils_Internal::WriteAddRecord(Records, *Entry);
+	}
+
+	const bool bReadOK = !Reader || !Reader->IsError();
+	Reader.Reset();
+	if (!bReadOK || !Writer->Close() || Writer->IsError())
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] Pack: Compaction failed to copy entries in %s"), *LevelDir);
+		Writer.Reset();
+		IFileManager::Get().Delete(*NewDataPath, false, false, true);
+		return false;
+	}
+	Writer.Reset();
+
+	// Swapping the directory switches readers to the new generation in one step
+	const FString TempDirectoryPath = DirectoryPath + TEXT(".tmp");
+	if (!FFileHelper::SaveArrayToFile(Records, *TempDirectoryPath) || !IFileManager::Get().Move(*DirectoryPath, *TempDirectoryPath, /*Replace*/true))
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] Pack: Compaction failed to replace the directory in %s"), *LevelDir);
+		IFileManager::Get().Delete(*TempDirectoryPath, false, false, true);
+		IFileManager::Get().Delete(*NewDataPath, false, false, true);
+		return false;
+	}
+
+	BloodStainPackUtils_Internal::ForgetDirectory(DirectoryPath);
+
+	// The replaced segment stays for readers that resolved an entry just before the swap
+	IFileManager::Get().Delete(*GetDataPath(LevelDir, Directory.Generation - 1), false, false, true);
+
+	UE_LOG(LogBloodStain, Log, TEXT("[BS] Pack: Compacted %s (%d entries, %lld bytes reclaimed)"), *LevelDir, Entries.Num(), Directory.DeadBytes);
+	return true;
+}
@@ -0,0 +1,278 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#include "BloodStainQuantizationKernels.h"
+#include "QuantizationTypes.h"
+#include "BloodStainSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("QuantizationKernels SnapToGrid"), STAT_QuantizationKernels_SnapToGrid, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("QuantizationKernels SnapToGrid Reference"), STAT_QuantizationKernels_SnapToGrid_Reference, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("QuantizationKernels GridValuesToCounts"), STAT_QuantizationKernels_GridValuesToCounts, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("QuantizationKernels GridValuesToCounts Reference"), STAT_QuantizationKernels_GridValuesToCounts_Reference, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("QuantizationKernels GridCountsToValues"), STAT_QuantizationKernels_GridCountsToValues, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("QuantizationKernels GridCountsToValues Reference"), STAT_QuantizationKernels_GridCountsToValues_Reference, STATGROUP_BloodStain);
+
+static_assert(sizeof(FVector) == 3 * sizeof(double), "Batch grid kernels walk FVector arrays as flat doubles");
+
+namespace BloodStainQuantizationKernels_Internal
+{
+	/** Quaternions decoded per iteration of the vector kernel */
+	constexpr int32 LaneCount = 4;
+
+	/**
+	 * Stored components of a rotation as raw counts in X, Y, Z, W order. The dropped slot gets the count that maps
+	 * exactly to zero, so every lane can go through the same arithmetic and the slot is filled in afterwards.
+	 */
+	FORCEINLINE void GetRawLanes(const FQuatSmallestThree& Rotation, double& OutMaxValue, double* OutLanes)
+	{
+		OutMaxValue = static_cast<double>((1 << Rotation.BitsPerComponent) - 1);
+
+		int32 In = 0;
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			OutLanes[Index] = Index == Rotation.LargestIndex ? OutMaxValue * 0.5 : static_cast<double>(Rotation.Components[In++]);
+		}
+	}
+
+	/** Pairwise, in the same order as the vector kernel */
+	FORCEINLINE double SumLanes(const double* Lanes)
+	{
+		const double Low = Lanes[0] + Lanes[1];
+		const double High = Lanes[2] + Lanes[3];
+		return Low + High;
+	}
+
+	FORCEINLINE TConstArrayView<double> AsDoubles(TConstArrayView<FVector> Vectors)
+	{
+		return TConstArrayView<double>(reinterpret_cast<const double*>(Vectors.GetData()), Vectors.Num() * 3);
+	}
+
+	FORCEINLINE TArrayView<double> AsDoubles(TArrayView<FVector> Vectors)
+	{
+		return TArrayView<double>(reinterpret_cast<double*>(Vectors.GetData()), Vectors.Num() * 3);
+	}
+
+	/** Scalar tails of the batch kernels, also their references */
+	void SnapValues(const double* In, double StepsPerUnit, double* Out, int32 Num)
+	{
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			Out[Index] = BloodStainQuantizationKernels::SnapToGrid_Reference(In[Index], StepsPerUnit);
+		}
+	}
+
+	void ValuesToCounts(const double* Values, double StepsPerUnit, int64* OutCounts, int32 Num)
+	{
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			OutCounts[Index] = FMath::RoundToInt64(Values[Index] * StepsPerUnit);
+		}
+	}
+
+	void CountsToValues(const int64* Counts, double StepsPerUnit, double* OutValues, int32 Num)
+	{
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			OutValues[Index] = Counts[Index] / StepsPerUnit;
+		}
+	}
+}
+
+namespace BloodStainQuantizationKernels
+{
+	using namespace BloodStainQuantizationKernels_Internal;
+
+	void SnapToGrid(TConstArrayView<FVector> In, double StepsPerUnit, TArrayView<FVector> Out)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_QuantizationKernels_SnapToGrid);
+		check(In.Num() == Out.Num());
+
+		const TConstArrayView<double> Values = AsDoubles(In);
+		const TArrayView<double> OutValues = AsDoubles(Out);
+		const int32 Num = Values.Num();
+		const VectorRegister4Double Steps = VectorSetFloat1(StepsPerUnit);
+		const VectorRegister4Double Half = VectorSetFloat1(0.5);
+
+		int32 First = 0;
+		for (; First + LaneCount <= Num; First += LaneCount)
+		{
+			const VectorRegister4Double Scaled = VectorMultiply(VectorLoad(Values.GetData() + First), Steps);
+			const VectorRegister4Double Rounded = VectorFloor(VectorAdd(Scaled, Half));
+			VectorStore(VectorDivide(Rounded, Steps), OutValues.GetData() + First);
+		}
+		SnapValues(Values.GetData() + First, StepsPerUnit, OutValues.GetData() + First, Num - First);
+	}
+
+	void SnapToGrid_Reference(TConstArrayView<FVector> In, double StepsPerUnit, TArrayView<FVector> Out)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_QuantizationKernels_SnapToGrid_Reference);
+		check(In.Num() == Out.Num());
+
+		SnapValues(AsDoubles(In).GetData(), StepsPerUnit, AsDoubles(Out).GetData(), In.Num() * 3);
+	}
+
+	void GridValuesToCounts(TConstArrayView<double> Values, double StepsPerUnit, TArrayView<int64> OutCounts)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_QuantizationKernels_GridValuesToCounts);
+		check(Values.Num() == OutCounts.Num());
+
+		const int32 Num = Values.Num();
+		const VectorRegister4Double Steps = VectorSetFloat1(StepsPerUnit);
+		const VectorRegister4Double Half = VectorSetFloat1(0.5);
+
+		int32 First = 0;
+		for (; First + LaneCount <= Num; First += LaneCount)
+		{
+			// Same multiply, add and floor as FMath::RoundToInt64; the floored values are integral, so the casts are exact
+			double Rounded[LaneCount];
+			VectorStore(VectorFloor(VectorAdd(VectorMultiply(VectorLoad(Values.GetData() + First), Steps), Half)), Rounded);
+			for (int32 Lane = 0; Lane < LaneCount; ++Lane)
+			{
+				OutCounts[First + Lane] = static_cast<int64>(Rounded[Lane]);
+			}
+		}
+		ValuesToCounts(Values.GetData() + First, StepsPerUnit, OutCounts.GetData() + First, Num - First);
+	}
+
+	void GridValuesToCounts_Reference(TConstArrayView<double> Values, double StepsPerUnit, TArrayView<int64> OutCounts)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_QuantizationKernels_GridValuesToCounts_Reference);
+		check(Values.Num() == OutCounts.Num());
+
+		ValuesToCounts(Values.GetData(), StepsPerUnit, OutCounts.GetData(), Values.Num());
+	}
+
+	void GridCountsToValues(TConstArrayView<int64> Counts, double StepsPerUnit, TArrayView<double> OutValues)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_QuantizationKernels_GridCountsToValues);
+		check(Counts.Num() == OutValues.Num());
+
+		const int32 Num = Counts.Num();
+		const VectorRegister4Double Steps = VectorSetFloat1(StepsPerUnit);
+
+		int32 First = 0;
+		for (; First + LaneCount <= Num; First += LaneCount)
+		{
+			// There is no int64 -> double lane conversion in the abstraction; the conversion is exact either way
+			double Converted[LaneCount];
+			for (int32 Lane = 0; Lane < LaneCount; ++Lane)
+			{
+				Converted[Lane] = static_cast<double>(Counts[First + Lane]);
+			}
+			VectorStore(VectorDivide(VectorLoad(Converted), Steps), OutValues.GetData() + First);
+		}
+		CountsToValues(Counts.GetData() + First, StepsPerUnit, OutValues.GetData() + First, Num - First);
+	}
+
+	void GridCountsToValues_Reference(TConstArrayView<int64> Counts, double StepsPerUnit, TArrayView<double> OutValues)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_QuantizationKernels_GridCountsToValues_Reference);
+		check(Counts.Num() == OutValues.Num());
+
+		CountsToValues(Counts.GetData(), StepsPerUnit, OutValues.GetData(), Counts.Num());
+	}
+
+	FQuat DequantizeSmallestThree_Reference(const FQuatSmallestThree& Rotation)
+	{
+		double MaxValue = 0.0;
+		double Raw[4];
+		GetRawLanes(Rotation, MaxValue, Raw);
+
+		double Values[4];
+		double Squares[4];
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			const double Normalized = Raw[Index] / MaxValue;
+			const double Signed = Normalized * 2.0 - 1.0;
+			Values[Index] = Signed * UE_DOUBLE_INV_SQRT_2;
+			Squares[Index] = Values[Index] * Values[Index];
+		}
+
+		const double Dropped = 1.0 - SumLanes(Squares);
+		Values[Rotation.LargestIndex] = FMath::Sqrt(FMath::Max(0.0, Dropped));
+		Squares[Rotation.LargestIndex] = Values[Rotation.LargestIndex] * Values[Rotation.LargestIndex];
+
+		const double Scale = 1.0 / FMath::Sqrt(SumLanes(Squares));
+		return FQuat(Values[0] * Scale, Values[1] * Scale, Values[2] * Scale, Values[3] * Scale);
+	}
+
+	void DequantizeTransforms(TConstArrayView<FQuantizedTransform_SmallestThree> Quantized, TArray<FTransform>& OutTransforms)
+	{
+		const int32 Num = Quantized.Num();
+		OutTransforms.Reserve(OutTransforms.Num() + Num);
+
+		const VectorRegister4Double Zero = VectorSetFloat1(0.0);
+		const VectorRegister4Double One = VectorSetFloat1(1.0);
+		const VectorRegister4Double Two = VectorSetFloat1(2.0);
+		const VectorRegister4Double InvSqrt2 = VectorSetFloat1(UE_DOUBLE_INV_SQRT_2);
+
+		int32 First = 0;
+		for (; First + LaneCount <= Num; First += LaneCount)
+		{
+			// Transposed: Raw[c][k] is component c of rotation k
+			double Raw[4][LaneCount];
+			double MaxValues[LaneCount];
+			double IsDropped[4][LaneCount];
+			for (int32 Lane = 0; Lane < LaneCount; ++Lane)
+			{
+				const FQuatSmallestThree& Rotation = Quantized[First + Lane].Rotation;
+				double Lanes[4];
+				GetRawLanes(Rotation, MaxValues[Lane], Lanes);
+				for (int32 Component = 0; Component < 4; ++Component)
+				{
+					Raw[Component][Lane] = Lanes[Component];
+					IsDropped[Component][Lane] = Component == Rotation.LargestIndex ? 1.0 : 0.0;
+				}
+			}
+
+			const VectorRegister4Double MaxValue = VectorLoad(MaxValues);
+			VectorRegister4Double Values[4];
+			VectorRegister4Double Squares[4];
+			for (int32 Component = 0; Component < 4; ++Component)
+			{
+				const VectorRegister4Double Normalized = VectorDivide(VectorLoad(Raw[Component]), MaxValue);
+				const VectorRegister4Double Signed = VectorSubtract(VectorMultiply(Normalized, Two), One);
+				Values[Component] = VectorMultiply(Signed, InvSqrt2);
+				Squares[Component] = VectorMultiply(Values[Component], Values[Component]);
+			}
+
+			const VectorRegister4Double SumSquares = VectorAdd(VectorAdd(Squares[0], Squares[1]), VectorAdd(Squares[2], Squares[3]));
+			const VectorRegister4Double DroppedValue = VectorSqrt(VectorMax(Zero, VectorSubtract(One, SumSquares)));
+
+			// The dropped lane holds an exact zero, so adding DroppedValue there (and zero elsewhere) fills it without rounding
+			for (int32 Component = 0; Component < 4; ++Component)
+			{
+				Values[Component] = VectorAdd(Values[Component], VectorMultiply(VectorLoad(IsDropped[Component]), DroppedValue));
+				Squares[Component] = VectorMultiply(Values[Component], Values[Component]);
+			}
+
+			const VectorRegister4Double Total = VectorAdd(VectorAdd(Squares[0], Squares[1]), VectorAdd(Squares[2], Squares[3]));
+			const VectorRegister4Double Scale = VectorDivide(One, VectorSqrt(Total));
+
+			double Out[4][LaneCount];
+			for (int32 Component = 0; Component < 4; ++Component)
+			{
+				VectorStore(VectorMultiply(Values[Component], Scale), Out[Component]);
+			}
+
+			for (int32 Lane = 0; Lane < LaneCount; ++Lane)
+			{
+				const FQuantizedTransform_SmallestThree& Q = Quantized[First + Lane];
+				OutTransforms.Emplace(FQuat(Out[0][Lane], Out[1][Lane], Out[2][Lane], Out[3][Lane]), Q.Location, Q.Scale);
+			}
+		}
+
+		DequantizeTransforms_Reference(Quantized.RightChop(First), OutTransforms);
+	}
+
+	void DequantizeTransforms_Reference(TConstArrayView<FQuantizedTransform_SmallestThree> Quantized, TArray<FTransform>& OutTransforms)
+	{
+		OutTransforms.Reserve(OutTransforms.Num() + Quantized.Num());
+		for (const FQuantizedTransform_SmallestThree& Q : Quantized)
+		{
+			OutTransforms.Emplace(DequantizeSmallestThree_Reference(Q.Rotation), Q.Location, Q.Scale);
+		}
+	}
+}
@@ -6,13 +6,13 @@
 #include "BloodStainRecordDataUtils.h"
 #include "BloodStainSystem.h"
 #include "GhostData.h"
+#include "Algo/BinarySearch.h"
 
 namespace BloodStainRecordDataUtils
 {
 	bool CookQueuedFrames(float SamplingInterval, const float& ClipStartTime, TCircularQueue<FRecordFrame>* FrameQueuePtr, FRecordActorSaveData& OutGhostSaveData, TArray<FComponentActiveInterval>& OutComponentIntervals)
 	{
-		FRecordFrame First;
-		if (!FrameQueuePtr->Peek(First))
+		if (FrameQueuePtr->IsEmpty())
 		{
 			UE_LOG(LogBloodStain, Warning, TEXT("No frames to save"));
 			return false;
@@ -20,33 +20,39 @@ namespace BloodStainRecordDataUtils
 
 		int32 FirstIndex = -1;
 
-		// Copy original frame datas and do normalize timestamps [0, duration)
-		TArray<FRecordFrame> RawFrames;
-		FRecordFrame Tmp;
-		while (FrameQueuePtr->Dequeue(Tmp))
+		// Dequeue frames straight into the save data and normalize timestamps [0, duration).
+		// Frames are moved out of the queue, so bone arrays are never deep-copied here.
+		TArray<FRecordFrame>& RecordedFrames = OutGhostSaveData.RecordedFrames;
+		RecordedFrames.Reset(FrameQueuePtr->Count());
+		while (true)
 		{
-			Tmp.TimeStamp -= ClipStartTime;
-			if (Tmp.TimeStamp < 0)
+			FRecordFrame& Frame = RecordedFrames.AddDefaulted_GetRef();
+			if (!FrameQueuePtr->Dequeue(Frame))
 			{
+				RecordedFrames.Pop(EAllowShrinking::No);
+				break;
+			}
+
+			Frame.TimeStamp -= ClipStartTime;
+			if (Frame.TimeStamp < 0)
+			{
+				RecordedFrames.Pop(EAllowShrinking::No);
 				continue;
 			}
 
-			if (RawFrames.Num() == 0)
+			if (RecordedFrames.Num() == 1)
 			{
-				FirstIndex = Tmp.FrameIndex;
+				FirstIndex = Frame.FrameIndex;
 			}
-			
-			RawFrames.Add(MoveTemp(Tmp));
 		}
 		
-		if (RawFrames.Num() < 2)
+		if (RecordedFrames.Num() < 2)
 		{
 			UE_LOG(LogBloodStain, Warning, TEXT("Not enough raw frames to interpolate."));
+			RecordedFrames.Empty();
 			return false;
 		}
 		
-		OutGhostSaveData.RecordedFrames = RawFrames;
-		
 		/* Construct Initial Component Structure based on Total Component event Data */
 		BuildInitialComponentStructure(FirstIndex, OutGhostSaveData, OutComponentIntervals);
 	
@@ -55,7 +61,11 @@ namespace BloodStainRecordDataUtils
 
 	void BuildInitialComponentStructure(int32 FirstFrameIndex, FRecordActorSaveData& OutGhostSaveData, TArray<FComponentActiveInterval>& OutComponentIntervals)
 	{
-		int32 NumSavedFrames = OutGhostSaveData.RecordedFrames.Num();
+		BuildInitialComponentStructure(FirstFrameIndex, OutGhostSaveData.RecordedFrames.Num(), OutComponentIntervals, OutGhostSaveData.ComponentIntervals);
+	}
+
+	void BuildInitialComponentStructure(int32 FirstFrameIndex, int32 NumSavedFrames, TArray<FComponentActiveInterval>& OutComponentIntervals, TArray<FComponentActiveInterval>& OutSavedIntervals)
+	{
 		OutComponentIntervals.Sort([](auto& A, auto& B) {
 			return A.EndFrame < B.EndFrame;
 		});
@@ -78,12 +88,172 @@ namespace BloodStainRecordDataUtils
 				Interval.EndFrame = FMath::Min(Interval.EndFrame - FirstFrameIndex, NumSavedFrames);
 			}
 
-			OutGhostSaveData.ComponentIntervals.Add(Interval);
+			OutSavedIntervals.Add(Interval);
 			UE_LOG(LogBloodStain, Log, TEXT("BuildInitialComponentStructure: %s added to initial structure"),
 				   *Interval.Meta.ComponentName);
 		}
 	}
 
+	namespace
+	{
+		/** Frames a removed frame may be interpolated across, bounds the cost of the greedy search */
+		constexpr int32 MaxKeyframeGap = 32;
+
+		constexpr float MaxScaleError = 0.01f;
+
+		bool IsTransformWithinError(const FTransform& Prev, const FTransform& Next, const FTransform& Actual, float Alpha, bool bFastLerpRotation, float MaxPositionErrorSq, float MinRotationDot)
+		{
+			if (FVector::DistSquared(FMath::Lerp(Prev.GetLocation(), Next.GetLocation(), Alpha), Actual.GetLocation()) > MaxPositionErrorSq)
+			{
+				return false;
+			}
+			if (FVector::DistSquared(FMath::Lerp(Prev.GetScale3D(), Next.GetScale3D(), Alpha), Actual.GetScale3D()) > MaxScaleError * MaxScaleError)
+			{
+				return false;
+			}
+
+			const FQuat Rotation = bFastLerpRotation
+				? FQuat::FastLerp(Prev.GetRotation(), Next.GetRotation(), Alpha).GetNormalized()
+				: FQuat::Slerp(Prev.GetRotation(), Next.GetRotation(), Alpha);
+			return FMath::Abs(Rotation | Actual.GetRotation()) >= MinRotationDot;
+		}
+
+		/** @return true if Frames[Middle] is reproduced by interpolating Frames[First] and Frames[Last] */
+		bool IsFrameWithinError(const FRecordFrame& First, const FRecordFrame& Last, const FRecordFrame& Middle, float MaxPositionErrorSq, float MinRotationDot)
+		{
+			const float Duration = Last.TimeStamp - First.TimeStamp;
+			const float Alpha = Duration > KINDA_SMALL_NUMBER ? (Middle.TimeStamp - First.TimeStamp) / Duration : 1.0f;
+
+			if (Middle.ComponentTransforms.Num() != First.ComponentTransforms.Num() || Middle.ComponentTransforms.Num() != Last.ComponentTransforms.Num())
+			{
+				return false;
+			}
+			for (const auto& [ComponentName, Actual] : Middle.ComponentTransforms)
+			{
+				const FTransform* Prev = First.ComponentTransforms.Find(ComponentName);
+				const FTransform* Next = Last.ComponentTransforms.Find(ComponentName);
+				if (!Prev || !Next || !IsTransformWithinError(*Prev, *Next, Actual, Alpha, false, MaxPositionErrorSq, MinRotationDot))
+				{
+					return false;
+				}
+			}
+
+			if (Middle.SkeletalMeshBoneTransforms.Num() != First.SkeletalMeshBoneTransforms.Num() || Middle.SkeletalMeshBoneTransforms.Num() != Last.SkeletalMeshBoneTransforms.Num())
+			{
+				return false;
+			}
+			for (const auto& [ComponentName, Actual] : Middle.SkeletalMeshBoneTransforms)
+			{
+				const FBoneComponentSpace* Prev = First.SkeletalMeshBoneTransforms.Find(ComponentName);
+				const FBoneComponentSpace* Next = Last.SkeletalMeshBoneTransforms.Find(ComponentName);
+				const int32 NumBones = Actual.BoneTransforms.Num();
+				if (!Prev || !Next || Prev->BoneTransforms.Num() != NumBones || Next->BoneTransforms.Num() != NumBones)
+				{
+					return false;
+				}
+				for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+				{
+					if (!IsTransformWithinError(Prev->BoneTransforms[BoneIndex], Next->BoneTransforms[BoneIndex], Actual.BoneTransforms[BoneIndex], Alpha, true, MaxPositionErrorSq, MinRotationDot))
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+	}
+
+	int32 ReduceKeyframes(FRecordActorSaveData& ActorData, float MaxPositionError, float MaxRotationError)
+	{
+		TArray<FRecordFrame>& Frames = ActorData.RecordedFrames;
+		const int32 NumFrames = Frames.Num();
+		if (NumFrames < 3)
+		{
+			return 0;
+		}
+
+		const float MaxPositionErrorSq = FMath::Square(FMath::Max(MaxPositionError, 0.f));
+		// |q1 . q2| = cos(angle / 2)
+		const float MinRotationDot = FMath::Cos(FMath::DegreesToRadians(FMath::Max(MaxRotationError, 0.f)) * 0.5f);
+
+		// Frames next to an attach/detach must survive so the interval boundaries stay exact
+		TBitArray<> bForcedKey(false, NumFrames);
+		bForcedKey[0] = true;
+		bForcedKey[NumFrames - 1] = true;
+		for (const FComponentActiveInterval& Interval : ActorData.ComponentIntervals)
+		{
+			for (const int32 Boundary : { Interval.StartFrame - 1, Interval.StartFrame, Interval.EndFrame - 1, Interval.EndFrame })
+			{
+				if (Boundary >= 0 && Boundary < NumFrames)
+				{
+					bForcedKey[Boundary] = true;
+				}
+			}
+		}
+
+		// Greedy: extend each segment from the last key while every skipped frame stays within the error
+		TArray<int32> KeptIndices;
+		KeptIndices.Reserve(NumFrames);
+		KeptIndices.Add(0);
+
+		int32 Anchor = 0;
+		while (Anchor < NumFrames - 1)
+		{
+			int32 End = Anchor + 1;
+			while (!bForcedKey[End] && End + 1 < NumFrames && End + 1 - Anchor <= MaxKeyframeGap)
+			{
+				const int32 Candidate = End + 1;
+				bool bCanSkip = true;
+				for (int32 Middle = Anchor + 1; Middle < Candidate && bCanSkip; ++Middle)
+				{
+					bCanSkip = IsFrameWithinError(Frames[Anchor], Frames[Candidate], Frames[Middle], MaxPositionErrorSq, MinRotationDot);
+				}
+				if (!bCanSkip)
+				{
+					break;
+				}
+				End = Candidate;
+			}
+
+			KeptIndices.Add(End);
+			Anchor = End;
+		}
+
+		const int32 NumRemoved = NumFrames - KeptIndices.Num();
+		if (NumRemoved == 0)
+		{
+			return 0;
+		}
+
+		// Intervals are [StartFrame, EndFrame); a kept frame stays inside iff its old index did
+		for (FComponentActiveInterval& Interval : ActorData.ComponentIntervals)
+		{
+			if (Interval.StartFrame < NumFrames)
+			{
+				Interval.StartFrame = Algo::LowerBound(KeptIndices, Interval.StartFrame);
+			}
+			if (Interval.EndFrame <= NumFrames)
+			{
+				Interval.EndFrame = Algo::LowerBound(KeptIndices, Interval.EndFrame);
+			}
+			else if (Interval.EndFrame != INT32_MAX)
+			{
+				Interval.EndFrame = KeptIndices.Num();
+			}
+		}
+
+		for (int32 NewIndex = 0; NewIndex < KeptIndices.Num(); ++NewIndex)
+		{
+			if (KeptIndices[NewIndex] != NewIndex)
+			{
+				Frames[NewIndex] = MoveTemp(Frames[KeptIndices[NewIndex]]);
+			}
+		}
+		Frames.SetNum(KeptIndices.Num(), EAllowShrinking::No);
+
+		return NumRemoved;
+	}
+
 	void ClipActorSaveDataByGroup(TArray<FRecordActorSaveData>& Actors, float MaxGroupRecordTime, float SamplingInterval)
 	{
 		if (Actors.Num() == 0)
@@ -97,122 +267,187 @@ namespace BloodStainRecordDataUtils
 
 		for (const FRecordActorSaveData& D : Actors)
 		{
+			if (D.RecordedFrames.Num() == 0)
+			{
+				continue;
+			}
 			GroupStartTime = FMath::Min(GroupStartTime, D.RecordedFrames[0].TimeStamp);
 			GroupEndTime   = FMath::Max(GroupEndTime,   D.RecordedFrames.Last().TimeStamp);
 		}
 
-		const float& WindowEnd = GroupEndTime;
-		float WindowStart = FMath::Max(GroupStartTime, WindowEnd - MaxGroupRecordTime);
+		if (GroupStartTime > GroupEndTime)
+		{
+			return;
+		}
+
+		const float WindowEnd = GroupEndTime;
+		const float WindowStart = FMath::Max(GroupStartTime, WindowEnd - MaxGroupRecordTime);
 
-		
 		for (FRecordActorSaveData& Actor : Actors)
 		{
-			if (Actor.RecordedFrames.Last().TimeStamp < WindowStart || Actor.RecordedFrames[0].TimeStamp > WindowEnd)
-			{
-				Actor.RecordedFrames.Empty();
-				Actor.ComponentIntervals.Empty();
-				
-				continue;
-			}
-
-			auto& Frames = Actor.RecordedFrames;
+			TArray<FRecordFrame>& Frames = Actor.RecordedFrames;
 			const int32 Length = Frames.Num();
-			
-			float LocalStart = WindowStart - Actor.RecordedFrames[0].TimeStamp;
-			float LocalEnd   = WindowEnd   - Actor.RecordedFrames[0].TimeStamp;
-			
-			int32 StartIdx = Algo::LowerBoundBy(Frames, LocalStart, [](const FRecordFrame& Frame) {;
-				return Frame.TimeStamp;
-			});
 
-			int32 EndIdx = Algo::UpperBoundBy(Frames, LocalEnd, [](const FRecordFrame& Frame) {
-				return Frame.TimeStamp;
-			}) - 1;
+			// [StartIdx, EndIdx) is the slice of frames that falls inside the group window
+			const int32 StartIdx = Algo::LowerBoundBy(Frames, WindowStart, &FRecordFrame::TimeStamp);
+			const int32 EndIdx = Algo::UpperBoundBy(Frames, WindowEnd, &FRecordFrame::TimeStamp);
 
-			StartIdx = FMath::Clamp(StartIdx, 0, Length - 1);
-			EndIdx = FMath::Clamp(EndIdx, 0, Length - 1);
-			
-			if (StartIdx > EndIdx)
+			if (StartIdx >= EndIdx)
 			{
 				Frames.Empty();
 				Actor.ComponentIntervals.Empty();
 				continue;
 			}
 
-			float NewFirstWorldTime = Actor.RecordedFrames[0].TimeStamp + Frames[StartIdx].TimeStamp;
-
-			TArray<int32> OldToNew;
-			OldToNew.Init(-1, Length);
-			int32 NewCount = EndIdx - StartIdx + 1;
-			for (int32 i = StartIdx; i <= EndIdx; ++i)
+			// Trim the tail first so the head removal shifts as few elements as possible
+			if (EndIdx < Length)
 			{
-				OldToNew[i] = i - StartIdx;
+				Frames.RemoveAt(EndIdx, Length - EndIdx, EAllowShrinking::No);
 			}
-			
-			TArray<FRecordFrame> NewFrames;
-			NewFrames.Reserve(EndIdx - StartIdx + 1);
-			for (int32 i = StartIdx; i <= EndIdx; ++i)
+			if (StartIdx > 0)
 			{
-				const FRecordFrame& O = Frames[i];
-				FRecordFrame G = O;
-
-				float WorldTime = Actor.RecordedFrames[0].TimeStamp + O.TimeStamp;
-				G.TimeStamp = WorldTime - NewFirstWorldTime;
-
-				NewFrames.Add(MoveTemp(G));
+				Frames.RemoveAt(0, StartIdx, EAllowShrinking::No);
 			}
-			Actor.RecordedFrames = MoveTemp(NewFrames);
 
-			Actor.RecordedFrames[0].TimeStamp = NewFirstWorldTime;
-			if (!Actor.RecordedFrames.IsEmpty())
+			// Rebase onto the group window so every actor keeps the same time origin
+			if (WindowStart > 0.f)
 			{
-				Actor.RecordedFrames.Last().TimeStamp = NewFirstWorldTime + Actor.RecordedFrames.Last().TimeStamp;
+				for (FRecordFrame& Frame : Frames)
+				{
+					Frame.TimeStamp -= WindowStart;
+				}
 			}
-			else
+
+			SliceComponentIntervals(Actor.ComponentIntervals, StartIdx, Frames.Num());
+		}
+	}
+
+	void SliceComponentIntervals(TArray<FComponentActiveInterval>& Intervals, int32 FirstFrame, int32 NumFrames)
+	{
+		// Intervals are [StartFrame, EndFrame) in saved frame indices; shift by FirstFrame and clamp to the slice
+		for (int32 Index = Intervals.Num() - 1; Index >= 0; --Index)
+		{
+			FComponentActiveInterval& Interval = Intervals[Index];
+			const int32 NewStart = FMath::Max(Interval.StartFrame - FirstFrame, 0);
+			const int32 NewEnd = Interval.EndFrame == INT32_MAX ? NumFrames : FMath::Min(Interval.EndFrame - FirstFrame, NumFrames);
+			if (NewEnd <= NewStart)
 			{
-				Actor.RecordedFrames.Last().TimeStamp = NewFirstWorldTime;
+				Intervals.RemoveAt(Index, 1, EAllowShrinking::No);
+				continue;
 			}
+			Interval.StartFrame = NewStart;
+			Interval.EndFrame = NewEnd;
+		}
+	}
+
+	void TrimToTimeRange(FRecordActorSaveData& ActorData, float StartTime, float EndTime, int32 FirstSavedFrame)
+	{
+		TArray<FRecordFrame>& Frames = ActorData.RecordedFrames;
+
+		// Keep the frames bracketing the range so playback can interpolate up to both ends
+		const int32 KeepEnd = FMath::Min(Algo::LowerBoundBy(Frames, EndTime, &FRecordFrame::TimeStamp) + 1, Frames.Num());
+		const int32 KeepFirst = FMath::Clamp(Algo::UpperBoundBy(Frames, StartTime, &FRecordFrame::TimeStamp) - 1, 0, FMath::Max(KeepEnd - 1, 0));
+		Frames.RemoveAt(KeepEnd, Frames.Num() - KeepEnd, EAllowShrinking::No);
+		Frames.RemoveAt(0, KeepFirst, EAllowShrinking::No);
+
+		SliceComponentIntervals(ActorData.ComponentIntervals, FirstSavedFrame + KeepFirst, Frames.Num());
+	}
 
-			TArray<FComponentActiveInterval> NewIntervals;
-			NewIntervals.Reserve(Actor.ComponentIntervals.Num());
+	void BuildLowResolutionTier(const FRecordActorSaveData& ActorData, int32 FrameStep, int32 MaxBones, FRecordActorSaveData& OutTier)
+	{
+		const TArray<FRecordFrame>& Frames = ActorData.RecordedFrames;
+		FrameStep = FMath::Max(FrameStep, 1);
+		MaxBones = FMath::Max(MaxBones, 0);
+
+		OutTier.PrimaryComponentName = ActorData.PrimaryComponentName;
+		OutTier.RecordedFrames.Reset(FMath::DivideAndRoundUp(Frames.Num(), FrameStep) + 1);
 
-			for (auto const& I : Actor.ComponentIntervals)
+		TArray<int32> KeptIndices;
+		for (int32 Index = 0; Index < Frames.Num(); ++Index)
+		{
+			if (Index % FrameStep != 0 && Index != Frames.Num() - 1)
 			{
-				// 원본 [I.StartFrame, I.EndFrame)
-				int32 s = INDEX_NONE, e = INDEX_NONE;
+				continue;
+			}
+			KeptIndices.Add(Index);
 
-				// newStart 찾기
-				for (int32 o = I.StartFrame; o < I.EndFrame && o < Length; ++o)
+			FRecordFrame& Frame = OutTier.RecordedFrames.Add_GetRef(Frames[Index]);
+			for (auto It = Frame.SkeletalMeshBoneTransforms.CreateIterator(); It; ++It)
+			{
+				TArray<FTransform>& Bones = It->Value.BoneTransforms;
+				if (MaxBones == 0)
 				{
-					if (OldToNew[o] != -1)
-					{
-						s = OldToNew[o];
-						break;
-					}
+					It.RemoveCurrent();
 				}
-				if (s == INDEX_NONE) 
-					continue;
-
-				// newEnd 찾기 (inclusive → exclusive)
-				for (int32 o = FMath::Min(I.EndFrame - 1, Length - 1); o >= I.StartFrame; --o)
+				else if (Bones.Num() > MaxBones)
 				{
-					if (OldToNew[o] != -1)
-					{
-						e = OldToNew[o] + 1;
-						break;
-					}
+					Bones.SetNum(MaxBones);
 				}
-				if (e <= s) 
-					continue;
+			}
+		}
+
+		// Saved frame i maps to the first kept frame at or after it; every interval keeps at least one frame
+		const int32 NumKept = KeptIndices.Num();
+		OutTier.ComponentIntervals = ActorData.ComponentIntervals;
+		for (FComponentActiveInterval& Interval : OutTier.ComponentIntervals)
+		{
+			const int32 NewStart = FMath::Min(Algo::LowerBound(KeptIndices, Interval.StartFrame), FMath::Max(NumKept - 1, 0));
+			const int32 NewEnd = Interval.EndFrame == INT32_MAX ? NumKept : Algo::LowerBound(KeptIndices, Interval.EndFrame);
+			Interval.StartFrame = NewStart;
+			Interval.EndFrame = FMath::Max(NewEnd, NewStart + 1);
+		}
+	}
+
+	float FindUniformFrameInterval(TConstArrayView<FRecordFrame> Frames)
+	{
+		if (Frames.Num() < 2)
+		{
+			return 0.f;
+		}
 
-				FComponentActiveInterval NI = I;
-				NI.StartFrame = FMath::Clamp(s, 0, NewCount);
-				NI.EndFrame   = FMath::Clamp(e, 0, NewCount);
-				NewIntervals.Add(MoveTemp(NI));
+		const float StartTime = Frames[0].TimeStamp;
+		const float Interval = (Frames.Last().TimeStamp - StartTime) / (Frames.Num() - 1);
+		if (Interval <= KINDA_SMALL_NUMBER)
+		{
+			return 0.f;
+		}
+
+		for (int32 Index = 1; Index < Frames.Num(); ++Index)
+		{
+			if (FMath::Abs(Frames[Index].TimeStamp - (StartTime + Index * Interval)) > UniformTimelineTolerance)
+			{
+				return 0.f;
 			}
+		}
+		return Interval;
+	}
 
-			Actor.ComponentIntervals = MoveTemp(NewIntervals);
-			
+	void BuildHeaderSummary(TConstArrayView<FRecordActorSaveData> Actors, FRecordHeaderSummary& OutSummary)
+	{
+		OutSummary.NumActors = Actors.Num();
+		OutSummary.NumFrames = 0;
+		OutSummary.Bounds.Init();
+		for (const FRecordActorSaveData& ActorData : Actors)
+		{
+			OutSummary.NumFrames += ActorData.RecordedFrames.Num();
+			for (const FRecordFrame& Frame : ActorData.RecordedFrames)
+			{
+				for (const TPair<FString, FTransform>& Pair : Frame.ComponentTransforms)
+				{
+					OutSummary.Bounds += Pair.Value.GetLocation();
+				}
+			}
+		}
+
+		OutSummary.PreviewComponentNames.Reset();
+		OutSummary.PreviewTransforms.Reset();
+		if (Actors.IsValidIndex(OutSummary.MainActorIndex) && Actors[OutSummary.MainActorIndex].IsValid())
+		{
+			for (const TPair<FString, FTransform>& Pair : Actors[OutSummary.MainActorIndex].RecordedFrames[0].ComponentTransforms)
+			{
+				OutSummary.PreviewComponentNames.Add(Pair.Key);
+				OutSummary.PreviewTransforms.Add(Pair.Value);
+			}
 		}
 	}
 }
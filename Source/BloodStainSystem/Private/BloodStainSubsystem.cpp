@@ -20,8 +20,9 @@
 #include "Kismet/GameplayStatics.h"
 #include "Algo/BinarySearch.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Tasks/Task.h"
+#include "Async/Async.h"
 
-class FSaveRecordingTask;
 
 float UBloodStainSubsystem::LineTraceLength = 500.f;
 
@@ -69,6 +70,7 @@ bool UBloodStainSubsystem::StartRecording(AActor* TargetActor, FBloodStainRecord
 	{
 		FBloodStainRecordGroup RecordGroup;
 		RecordGroup.RecordOptions = RecordOptions;
+		RecordGroup.FileOptions = FileSaveOptions;
 		if (const UWorld* World = GetWorld())
 		{
 			RecordGroup.WorldBaseGroupStartTime = World->GetTimeSeconds();
@@ -95,7 +97,7 @@ bool UBloodStainSubsystem::StartRecording(AActor* TargetActor, FBloodStainRecord
 	
 	TargetActor->AddInstanceComponent(Recorder);
 	Recorder->RegisterComponent();
-	Recorder->Initialize(RecordGroup.RecordOptions, RecordGroup.WorldBaseGroupStartTime);
+	Recorder->Initialize(RecordGroup.RecordOptions, RecordGroup.WorldBaseGroupStartTime, RecordGroup.FileOptions);
 
 	RecordGroup.ActiveRecorders.Add(TargetActor, Recorder);
 	
@@ -140,31 +142,10 @@ void UBloodStainSubsystem::StopRecording(FName GroupName, bool bSaveRecordingDat
 		const float EffectiveStartTime = FrameBaseEndTime - BloodStainRecordGroup.RecordOptions.MaxRecordTime;
 		const float FrameBaseStartTime = EffectiveStartTime > 0 ? EffectiveStartTime : 0;
 
-		TMap<FName, int32> ActorNameToRecordDataIndexMap;
-		TArray<FRecordActorSaveData> RecordActorSaveDataArray;
-		TArray<FInstancedStruct> ActorHeaderDataArray;
-		
-		TArray<FName> TerminateActorNameArray;
-		TArray<FInstancedStruct> TerminateRecordActorUserDataArray;
-		TArray<FRecordActorSaveData> TerminatedActorSaveDataArray = ReplayTerminatedActorManager->CookQueuedFrames(GroupName, FrameBaseStartTime, TerminateActorNameArray, TerminateRecordActorUserDataArray);		
-		for (int32 Index = 0; Index < TerminatedActorSaveDataArray.Num(); Index++)
-		{
-			const FRecordActorSaveData& RecordActorSaveData = TerminatedActorSaveDataArray[Index];
-			const FName& ActorName = TerminateActorNameArray[Index];
-			const FInstancedStruct& RecordActorUserData = TerminateRecordActorUserDataArray[Index];
-
-			if (!RecordActorSaveData.IsValid())
-			{
-				UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Warning: Frame num is 0"));
-				continue;
-			}
-
-			ActorHeaderDataArray.Add(RecordActorUserData);
-			
-			RecordActorSaveDataArray.Add(RecordActorSaveData);
-			int32 RecordDataIndex = RecordActorSaveDataArray.Num() - 1;
-			ActorNameToRecordDataIndexMap.Add(ActorName, RecordDataIndex);
-		}
+		// Only buffer ownership changes hands here; cooking, clipping and saving run on the task graph
+		TSharedRef<FSaveRecordingTask> SaveTask = MakeShared<FSaveRecordingTask>();
+		ReplayTerminatedActorManager->TakeRecordGroupSnapshots(GroupName, SaveTask->Snapshots);
+		SaveTask->Snapshots.Reserve(SaveTask->Snapshots.Num() + BloodStainRecordGroup.ActiveRecorders.Num());
 		for (const auto& [Actor, RecordComponent] : BloodStainRecordGroup.ActiveRecorders)
 		{
 			if (!Actor)
@@ -179,23 +160,10 @@ void UBloodStainSubsystem::StopRecording(FName GroupName, bool bSaveRecordingDat
 				continue;
 			}
 
-			FRecordActorSaveData RecordSaveData = RecordComponent->CookQueuedFrames(FrameBaseStartTime);
-			if (RecordSaveData.RecordedFrames.Num() == 0)
-			{
-				UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Warning: Frame is 0: %s"), *Actor->GetName());
-				continue;
-			}
-
-			FInstancedStruct RecordActorUserData = RecordComponent->GetRecordActorUserData();
-			ActorHeaderDataArray.Add(RecordActorUserData);
-			
-			RecordActorSaveDataArray.Add(RecordSaveData);
-			int32 RecordDataIndex = RecordActorSaveDataArray.Num() - 1;
-			ActorNameToRecordDataIndexMap.Add(Actor->GetFName(), RecordDataIndex);
+			RecordComponent->TakeRecordSnapshot(SaveTask->Snapshots.AddDefaulted_GetRef());
 		}
-
 		
-		if (RecordActorSaveDataArray.Num() == 0)
+		if (SaveTask->Snapshots.Num() == 0)
 		{
 			UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Failed: There is no Valid Recorder Group[%s]"), GetData(GroupName.ToString()));
 			return;
@@ -209,19 +177,6 @@ void UBloodStainSubsystem::StopRecording(FName GroupName, bool bSaveRecordingDat
 		{
 			GroupNameString = DefaultGroupName.ToString();
 		}
-
-		if (BloodStainRecordGroup.RecordingMainActor.Get() != nullptr && ActorNameToRecordDataIndexMap.Contains(BloodStainRecordGroup.RecordingMainActor->GetFName()))
-		{
-			const int32 Index = ActorNameToRecordDataIndexMap[BloodStainRecordGroup.RecordingMainActor->GetFName()];
-			const FRecordActorSaveData& SaveData = RecordActorSaveDataArray[Index];
-			
-			BloodStainRecordGroup.SpawnPointTransform = SaveData.RecordedFrames[0].ComponentTransforms[SaveData.PrimaryComponentName.ToString()];
-		}
-		else
-		{
-			const FRecordActorSaveData& SaveData = RecordActorSaveDataArray[0];
-			BloodStainRecordGroup.SpawnPointTransform = SaveData.RecordedFrames[0].ComponentTransforms[SaveData.PrimaryComponentName.ToString()];
-		}
 	
 		if (BloodStainRecordGroup.RecordOptions.FileName == NAME_None)
 		{
@@ -232,40 +187,62 @@ void UBloodStainSubsystem::StopRecording(FName GroupName, bool bSaveRecordingDat
 			BloodStainRecordGroup.RecordOptions.FileName = FName(BloodStainRecordGroup.RecordOptions.FileName.ToString().Replace(TEXT("\\"), TEXT(" ")).Replace(TEXT("/"), TEXT(" ")));
 		}
 		
-		FRecordSaveData RecordSaveData = ConvertToSaveData(FrameBaseEndTime, GroupName, BloodStainRecordGroup.RecordOptions.FileName, FName(MapName), RecordActorSaveDataArray);
-		
-		RecordSaveData.Header.RecordGroupUserData = GetReplayUserHeaderData(GroupName);
-		RecordSaveData.Header.RecordActorUserData = ActorHeaderDataArray;
-		
+		SaveTask->SavedData = ConvertToSaveData(FrameBaseEndTime, GroupName, BloodStainRecordGroup.RecordOptions.FileName, FName(MapName));
+		SaveTask->SavedData.Header.RecordGroupUserData = GetReplayUserHeaderData(GroupName);
 
 		const FString FinalFileName = FString::Printf(TEXT("BloodStainReplay-%s"), *UniqueTimestamp); 
-		const FString FinalFilePath = BloodStainFileUtils::GetFullFilePath(FinalFileName, MapName);
 
-		RecordSaveData.Header.FileName = FName(FinalFileName);
-		RecordSaveData.Header.LevelName = FName(MapName);
+		SaveTask->SavedData.Header.FileName = FName(FinalFileName);
+		SaveTask->SavedData.Header.LevelName = FName(MapName);
+
+		SaveTask->ClipStartTime = FrameBaseStartTime;
+		SaveTask->SamplingInterval = BloodStainRecordGroup.RecordOptions.SamplingInterval;
+		SaveTask->MainActorName = BloodStainRecordGroup.RecordingMainActor.Get() != nullptr ? BloodStainRecordGroup.RecordingMainActor->GetFName() : NAME_None;
+		SaveTask->LevelName = MapName;
+		SaveTask->FileName = BloodStainRecordGroup.RecordOptions.FileName.ToString();
+		SaveTask->FileOptions = BloodStainRecordGroup.RecordOptions.bPrecookInBackground ? BloodStainRecordGroup.FileOptions : FileSaveOptions;
 		
-		auto OnSaveCompleted = [this, FinalFilePath, Header = RecordSaveData.Header]()
+		SaveTask->OnTaskCompleted.BindLambda([WeakThis = TWeakObjectPtr<UBloodStainSubsystem>(this), GroupName, SavedFileName = SaveTask->FileName, MapName](bool bSuccess, const FRecordHeaderData& Header)
 		{
-			if (GetWorld())
+			UBloodStainSubsystem* This = WeakThis.Get();
+			if (!This)
 			{
-				if (AGhostPlayerController* PC = Cast<AGhostPlayerController>(GetWorld()->GetFirstPlayerController()))
+				return;
+			}
+
+			if (bSuccess && This->GetWorld())
+			{
+				if (AGhostPlayerController* PC = Cast<AGhostPlayerController>(This->GetWorld()->GetFirstPlayerController()))
 				{
 					if (PC->IsLocalController())
 					{
-						UE_LOG(LogBloodStain, Log, TEXT("Async save completed. Starting upload for: %s"), *FinalFilePath);
-						PC->StartFileUpload(FinalFilePath, Header);
+						// Read back through the file utils: with bStoreInLevelPack there is no loose file to stream
+						UE_LOG(LogBloodStain, Log, TEXT("Async save completed. Starting upload for: %s"), *SavedFileName);
+						BloodStainFileUtils::LoadFileBytesAsync(SavedFileName, MapName, [WeakPC = TWeakObjectPtr<AGhostPlayerController>(PC), Header, SavedFileName](bool bLoaded, TArray<uint8>&& FileBytes)
+						{
+							if (!bLoaded)
+							{
+								UE_LOG(LogBloodStain, Error, TEXT("Failed to read saved recording for upload: %s"), *SavedFileName);
+								return;
+							}
+							if (AGhostPlayerController* UploadPC = WeakPC.Get())
+							{
+								UploadPC->StartFileUpload(MoveTemp(FileBytes), Header);
+							}
+						});
 					}
 				}
 			}
-		};
+			This->OnRecordingFinalized.Broadcast(GroupName, bSuccess, Header);
+		});
 		
 		OnCompleteBuildRecordingHeader.Broadcast(GroupName);
 		ClearReplayUserHeaderData(GroupName);
 		
-		(new FAutoDeleteAsyncTask<FSaveRecordingTask>(
-			MoveTemp(RecordSaveData), MapName, BloodStainRecordGroup.RecordOptions.FileName.ToString(), FileSaveOptions
-			, FSimpleDelegateGraphTask::FDelegate::CreateLambda(MoveTemp(OnSaveCompleted))
-		))->StartBackgroundTask();
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [SaveTask]()
+		{
+			SaveTask->DoWork();
+		});
 	}
 
 	TMap<TObjectPtr<AActor>, TObjectPtr<URecordComponent>> Temp = BloodStainRecordGroup.ActiveRecorders;
@@ -348,13 +325,35 @@ bool UBloodStainSubsystem::StartReplayFromFile(APlayerController* RequestingCont
 	if (NetMode == ENetMode::NM_Standalone)
 	{
 		FRecordSaveData Data;
-		if (!FindOrLoadRecordBodyData(FileName, LevelName, Data))
+
+		// The tier is only worth it while the full data is not in memory yet
+		const bool bLowResolution = PlaybackOptions.bStartWithLowResolution
+			&& !CachedRecordings.Contains(GetRelativeFilePath(FileName, LevelName))
+			&& BloodStainFileUtils::LoadLowResolutionFromFile(FileName, LevelName, Data);
+
+		if (!bLowResolution && !FindOrLoadRecordBodyData(FileName, LevelName, Data))
 		{
 			UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] File: Cannot Load File [%s]"), *FileName);
 			return false;
 		}
 
-		return StartReplay_Standalone(Data, PlaybackOptions, OutGuid);
+		if (!StartReplay_Standalone(Data, PlaybackOptions, OutGuid))
+		{
+			return false;
+		}
+
+		FBloodStainPlaybackGroup& PlaybackGroup = BloodStainPlaybackGroups[OutGuid];
+		PlaybackGroup.FileName = FileName;
+		PlaybackGroup.LevelName = LevelName;
+		PlaybackGroup.bIsLowResolution = bLowResolution;
+		for (AReplayActor* GhostActor : PlaybackGroup.ActiveReplayers)
+		{
+			if (UPlayComponent* Replayer = GhostActor->GetPlayComponent())
+			{
+				Replayer->SetLowResolution(bLowResolution);
+			}
+		}
+		return true;
 	}
 	else // NM_ListenServer or NM_DedicatedServer
 	{
@@ -373,6 +372,74 @@ bool UBloodStainSubsystem::StartReplayFromFile(APlayerController* RequestingCont
 	
 }
 
+bool UBloodStainSubsystem::UpgradeReplayToFullResolution(FGuid PlaybackKey)
+{
+	FBloodStainPlaybackGroup* PlaybackGroup = BloodStainPlaybackGroups.Find(PlaybackKey);
+	if (!PlaybackGroup)
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] UpgradeReplayToFullResolution failed: Group [%s] is not exist"), *PlaybackKey.ToString());
+		return false;
+	}
+	if (!PlaybackGroup->bIsLowResolution || PlaybackGroup->bFullResolutionLoading)
+	{
+		return true;
+	}
+
+	const FString RelativeFilePath = GetRelativeFilePath(PlaybackGroup->FileName, PlaybackGroup->LevelName);
+	if (const FRecordSaveData* Cached = CachedRecordings.Find(RelativeFilePath))
+	{
+		ApplyFullResolutionData(PlaybackKey, *Cached);
+		return true;
+	}
+
+	// Load and decode off the game thread; the group keeps playing the tier until the data is swapped in
+	PlaybackGroup->bFullResolutionLoading = true;
+	BloodStainFileUtils::LoadFromFileAsync(PlaybackGroup->FileName, PlaybackGroup->LevelName, [WeakThis = TWeakObjectPtr<UBloodStainSubsystem>(this), PlaybackKey, FileName = PlaybackGroup->FileName, RelativeFilePath](bool bLoaded, FRecordSaveData&& FullData)
+	{
+		UBloodStainSubsystem* This = WeakThis.Get();
+		if (!This)
+		{
+			return;
+		}
+		if (FBloodStainPlaybackGroup* Group = This->BloodStainPlaybackGroups.Find(PlaybackKey))
+		{
+			Group->bFullResolutionLoading = false;
+		}
+		if (!bLoaded)
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BloodStain] Failed to load file %s"), *FileName);
+			return;
+		}
+
+		This->CachedRecordings.Add(RelativeFilePath, MoveTemp(FullData));
+		This->ApplyFullResolutionData(PlaybackKey, This->CachedRecordings[RelativeFilePath]);
+	});
+	return true;
+}
+
+void UBloodStainSubsystem::ApplyFullResolutionData(FGuid PlaybackKey, const FRecordSaveData& FullData)
+{
+	FBloodStainPlaybackGroup* PlaybackGroup = BloodStainPlaybackGroups.Find(PlaybackKey);
+	if (!PlaybackGroup || !PlaybackGroup->bIsLowResolution)
+	{
+		return;
+	}
+
+	for (int32 Index = 0; Index < PlaybackGroup->ActiveReplayers.Num(); ++Index)
+	{
+		const int32 ActorIndex = PlaybackGroup->ReplayerActorIndices.IsValidIndex(Index) ? PlaybackGroup->ReplayerActorIndices[Index] : INDEX_NONE;
+		AReplayActor* GhostActor = PlaybackGroup->ActiveReplayers[Index];
+		UPlayComponent* Replayer = GhostActor ? GhostActor->GetPlayComponent() : nullptr;
+		if (Replayer && FullData.RecordActorDataArray.IsValidIndex(ActorIndex))
+		{
+			Replayer->UpgradeReplayData(FullData.RecordActorDataArray[ActorIndex]);
+		}
+	}
+
+	PlaybackGroup->bIsLowResolution = false;
+	UE_LOG(LogBloodStain, Log, TEXT("[BloodStain] Replay [%s] upgraded to full resolution"), *PlaybackKey.ToString());
+}
+
 void UBloodStainSubsystem::StopReplay(FGuid PlaybackKey)
 {
 	if (!BloodStainPlaybackGroups.Contains(PlaybackKey))
@@ -429,7 +496,12 @@ void UBloodStainSubsystem::StopReplayPlayComponent(AReplayActor* GhostActor)
 	GhostActor->RemoveInstanceComponent(PlayComponent);
 	PlayComponent->DestroyComponent();
 	
-	BloodStainPlaybackGroup.ActiveReplayers.Remove(GhostActor);
+	const int32 ReplayerIndex = BloodStainPlaybackGroup.ActiveReplayers.Find(GhostActor);
+	BloodStainPlaybackGroup.ActiveReplayers.RemoveAt(ReplayerIndex);
+	if (BloodStainPlaybackGroup.ReplayerActorIndices.IsValidIndex(ReplayerIndex))
+	{
+		BloodStainPlaybackGroup.ReplayerActorIndices.RemoveAt(ReplayerIndex);
+	}
 	
 	GhostActor->Destroy();
 	
@@ -598,6 +670,39 @@ void UBloodStainSubsystem::LoadAllHeaders()
 	BloodStainFileUtils::LoadHeadersForAllFiles(CachedHeaders);
 }
 
+void UBloodStainSubsystem::LoadAllHeadersInLevelsAsync(const TArray<FString>& LevelNames)
+{
+	TArray<FString> LevelStrs = LevelNames;
+	for (FString& LevelStr : LevelStrs)
+	{
+		if (LevelStr.IsEmpty())
+		{
+			LevelStr = UGameplayStatics::GetCurrentLevelName(GetWorld());
+		}
+	}
+
+	BloodStainFileUtils::LoadHeadersForAllFilesInLevelAsync(LevelStrs, [WeakThis = TWeakObjectPtr<UBloodStainSubsystem>(this)](TMap<FString, FRecordHeaderData>&& LoadedHeaders)
+	{
+		if (UBloodStainSubsystem* This = WeakThis.Get())
+		{
+			This->CachedHeaders = MoveTemp(LoadedHeaders);
+			This->OnHeadersLoaded.Broadcast(This->CachedHeaders.Num());
+		}
+	});
+}
+
+void UBloodStainSubsystem::LoadAllHeadersAsync()
+{
+	BloodStainFileUtils::LoadHeadersForAllFilesAsync([WeakThis = TWeakObjectPtr<UBloodStainSubsystem>(this)](TMap<FString, FRecordHeaderData>&& LoadedHeaders)
+	{
+		if (UBloodStainSubsystem* This = WeakThis.Get())
+		{
+			This->CachedHeaders = MoveTemp(LoadedHeaders);
+			This->OnHeadersLoaded.Broadcast(This->CachedHeaders.Num());
+		}
+	});
+}
+
 void UBloodStainSubsystem::ClearCachedBodyData(const FString& FileName, const FString& LevelName)
 {
 	const FString RelativeFilePath = GetRelativeFilePath(FileName, LevelName);
@@ -711,7 +816,7 @@ bool UBloodStainSubsystem::IsPlaying(const FGuid& InPlaybackKey) const
 	return BloodStainPlaybackGroups.Contains(InPlaybackKey);
 }
 
-FRecordSaveData UBloodStainSubsystem::ConvertToSaveData(float EndTime, const FName& GroupName, const FName& FileName, const FName& LevelName, TArray<FRecordActorSaveData>& RecordActorDataArray)
+FRecordSaveData UBloodStainSubsystem::ConvertToSaveData(float EndTime, const FName& GroupName, const FName& FileName, const FName& LevelName)
 {
 	FRecordSaveData RecordSaveData;
 
@@ -722,7 +827,6 @@ FRecordSaveData UBloodStainSubsystem::ConvertToSaveData(float EndTime, const FNa
 	RecordSaveData.Header.MaxRecordTime = BloodStainRecordGroups[GroupName].RecordOptions.MaxRecordTime;
 	RecordSaveData.Header.SamplingInterval = BloodStainRecordGroups[GroupName].RecordOptions.SamplingInterval;
 	RecordSaveData.Header.TotalLength = FMath::Min(EndTime, BloodStainRecordGroups[GroupName].RecordOptions.MaxRecordTime);
-	RecordSaveData.RecordActorDataArray = MoveTemp(RecordActorDataArray);
 	
 	return RecordSaveData;
 }
@@ -766,8 +870,10 @@ bool UBloodStainSubsystem::StartReplay_Standalone(const FRecordSaveData& RecordS
 	
 	FBloodStainPlaybackGroup BloodStainPlaybackGroup;
 
-	for (const FRecordActorSaveData& ActorData : ActorDataArray)
+	for (int32 ActorIndex = 0; ActorIndex < ActorDataArray.Num(); ++ActorIndex)
 	{
+		const FRecordActorSaveData& ActorData = ActorDataArray[ActorIndex];
+
 		// TODO : to separate all SpawnPoint data per Actors
 		FTransform StartTransform = Header.SpawnPointTransform;
 		AReplayActor* GhostActor = GetWorld()->SpawnActor<AReplayActor>(AReplayActor::StaticClass(), StartTransform);
@@ -786,6 +892,7 @@ bool UBloodStainSubsystem::StartReplay_Standalone(const FRecordSaveData& RecordS
 		
 		GhostActor->InitializeReplayLocal(UniqueID, Header, ActorData, PlaybackOptions);
 		BloodStainPlaybackGroup.ActiveReplayers.Add(GhostActor);
+		BloodStainPlaybackGroup.ReplayerActorIndices.Add(ActorIndex);
 	}
 
 	if (BloodStainPlaybackGroup.ActiveReplayers.Num() == 0)
@@ -1041,7 +1148,7 @@ void UBloodStainSubsystem::HandleEndFileUpload(AGhostPlayerController* Uploader)
 			const FString FinalFileName = TransferData->Header.FileName.ToString();
 			
 			const FString FinalPath = BloodStainFileUtils::GetFullFilePath(FinalFileName, FinalLevelName);
-			if (FFileHelper::SaveArrayToFile(TransferData->FileBuffer, *FinalPath))
+			if (BloodStainFileUtils::SaveFileBytes(TransferData->FileBuffer, FinalLevelName, FinalFileName, FileSaveOptions))
 			{
 				UE_LOG(LogBloodStain, Log, TEXT("Server successfully saved client replay to: %s"), *FinalPath);
 			}
@@ -0,0 +1,1446 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#include "BloodStainTrackUtils.h"
+#include "BloodStainBitStream.h"
+#include "BloodStainRecordDataUtils.h"
+#include "BloodStainSystem.h"
+#include "QuantizationHelper.h"
+#include "Serialization/MemoryWriter.h"
+
+DECLARE_CYCLE_STAT(TEXT("TrackUtils SerializeTracks"), STAT_TrackUtils_SerializeTracks, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("TrackUtils DeserializeTracks"), STAT_TrackUtils_DeserializeTracks, STATGROUP_BloodStain);
+
+namespace BloodStainTrackUtils_Internal
+{
+	using BloodStainFileUtils_Internal::FTrackQuantizationParams;
+	using BloodStainFileUtils_Internal::QuantizeTrack;
+	using BloodStainFileUtils_Internal::DequantizeTrack;
+
+	/** Unquantized sample, split into the same three fields as the quantized transform types */
+	struct FRawTransformSample
+	{
+		FVector Location = FVector::ZeroVector;
+		FQuat Rotation = FQuat::Identity;
+		FVector Scale = FVector::OneVector;
+
+		FRawTransformSample() = default;
+
+		explicit FRawTransformSample(const FTransform& T)
+			: Location(T.GetLocation())
+			, Rotation(T.GetRotation())
+			, Scale(T.GetScale3D())
+		{}
+
+		FTransform ToTransform() const
+		{
+			return FTransform(Rotation, Location, Scale);
+		}
+	};
+
+	/** Bits of the per-track mask marking channel groups that hold one value for the whole run */
+	enum EConstantChannel : uint8
+	{
+		ConstantTranslation = 1 << 0,
+		ConstantRotation    = 1 << 1,
+		ConstantScale       = 1 << 2
+	};
+
+	/** Largest deviation from the first sample for a channel group to be stored once */
+	constexpr float ConstantTranslationTolerance = 0.001f;
+	constexpr float ConstantRotationToleranceDegrees = 0.01f;
+	constexpr float ConstantScaleTolerance = 0.0001f;
+
+	/** @return EConstantChannel bits of the channel groups that stay within tolerance of the first sample */
+	uint8 FindConstantChannels(TConstArrayView<const FTransform*> Samples)
+	{
+		if (Samples.Num() < 2)
+		{
+			return 0;
+		}
+
+		// |q1 . q2| = cos(angle / 2)
+		static const float MinRotationDot = FMath::Cos(FMath::DegreesToRadians(ConstantRotationToleranceDegrees) * 0.5f);
+
+		const FTransform& First = *Samples[0];
+		uint8 Mask = ConstantTranslation | ConstantRotation | ConstantScale;
+		for (const FTransform* Sample : Samples)
+		{
+			if ((Mask & ConstantTranslation) && FVector::DistSquared(Sample->GetLocation(), First.GetLocation()) > FMath::Square(ConstantTranslationTolerance))
+			{
+				Mask &= ~ConstantTranslation;
+			}
+			if ((Mask & ConstantRotation) && FMath::Abs(Sample->GetRotation() | First.GetRotation()) < MinRotationDot)
+			{
+				Mask &= ~ConstantRotation;
+			}
+			if ((Mask & ConstantScale) && FVector::DistSquared(Sample->GetScale3D(), First.GetScale3D()) > FMath::Square(ConstantScaleTolerance))
+			{
+				Mask &= ~ConstantScale;
+			}
+			if (Mask == 0)
+			{
+				break;
+			}
+		}
+		return Mask;
+	}
+
+	/** Writes or reads one field of every sample; a constant field is stored once and copied to every sample on load */
+	template<typename SampleType, typename FieldType>
+	void SerializeColumn(FArchive& Ar, TArray<SampleType>& Samples, FieldType SampleType::* Field, bool bConstant)
+	{
+		if (bConstant && Samples.Num() > 0)
+		{
+			Ar << (Samples[0].*Field);
+			for (int32 Index = 1; Index < Samples.Num(); ++Index)
+			{
+				Samples[Index].*Field = Samples[0].*Field;
+			}
+			return;
+		}
+
+		for (SampleType& Sample : Samples)
+		{
+			Ar << (Sample.*Field);
+		}
+	}
+
+	/** Writes or reads the translation column, then the rotation column, then the scale column of a track */
+	template<typename SampleType, typename LocType, typename RotType, typename ScaleType>
+	void SerializeColumns(FArchive& Ar, TArray<SampleType>& Samples, uint8 ConstantMask, LocType SampleType::* Loc, RotType SampleType::* Rot, ScaleType SampleType::* Scale)
+	{
+		SerializeColumn(Ar, Samples, Loc, (ConstantMask & ConstantTranslation) != 0);
+		SerializeColumn(Ar, Samples, Rot, (ConstantMask & ConstantRotation) != 0);
+		SerializeColumn(Ar, Samples, Scale, (ConstantMask & ConstantScale) != 0);
+	}
+
+	/** Temporal predictors a channel can be coded against */
+	enum class EChannelPredictor : uint8
+	{
+		/** Residual from the previous sample */
+		Previous,
+
+		/** Residual from the line through the previous two samples */
+		Linear,
+
+		Num
+	};
+
+	/** Integer channels per quantized transform: 3 translation, then the rotation channels, then 3 scale */
+	template<typename QuantType>
+	struct TChannelLayout
+	{
+		static constexpr int32 NumRotationChannels = 3;
+		static constexpr int32 NumChannels = 6 + NumRotationChannels;
+
+		/** Channel holding an index rather than a coordinate, which curves must not interpolate */
+		static constexpr int32 DiscreteChannel = INDEX_NONE;
+
+		/** Translation and scale channels are grid counts, converted for the whole track in batch */
+		static constexpr bool bGridLanes = true;
+	};
+
+	/** Largest component index plus the three stored components */
+	template<>
+	struct TChannelLayout<FQuantizedTransform_SmallestThree>
+	{
+		static constexpr int32 NumRotationChannels = 4;
+		static constexpr int32 NumChannels = 6 + NumRotationChannels;
+		static constexpr int32 DiscreteChannel = 3;
+		static constexpr bool bGridLanes = true;
+	};
+
+	/** Every channel is a field of an engine fixed-point word */
+	template<>
+	struct TChannelLayout<FQuantizedTransform_Lowest>
+	{
+		static constexpr int32 NumRotationChannels = 3;
+		static constexpr int32 NumChannels = 6 + NumRotationChannels;
+		static constexpr int32 DiscreteChannel = INDEX_NONE;
+		static constexpr bool bGridLanes = false;
+	};
+
+	FORCEINLINE uint64 ZigZagEncode(int64 Value)
+	{
+		return (static_cast<uint64>(Value) << 1) ^ static_cast<uint64>(Value >> 63);
+	}
+
+	FORCEINLINE int64 ZigZagDecode(uint64 Value)
+	{
+		return static_cast<int64>(Value >> 1) ^ -static_cast<int64>(Value & 1);
+	}
+
+	FORCEINLINE int64 Predict(EChannelPredictor Predictor, const int64* Values, int32 Index)
+	{
+		if (Index == 0)
+		{
+			return 0;
+		}
+		if (Predictor == EChannelPredictor::Linear && Index >= 2)
+		{
+			return 2 * Values[Index - 1] - Values[Index - 2];
+		}
+		return Values[Index - 1];
+	}
+
+	FORCEINLINE int64 RoundedDivide(int64 Numerator, int64 Denominator)
+	{
+		return (Numerator >= 0 ? Numerator + Denominator / 2 : Numerator - Denominator / 2) / Denominator;
+	}
+
+	/** Channel width value marking varint residuals instead of fixed-width bit-packed ones */
+	constexpr uint8 VarintWidth = 0xFF;
+
+	void ComputeResiduals(TConstArrayView<int64> Values, EChannelPredictor Predictor, TArray<uint64>& OutResiduals)
+	{
+		OutResiduals.SetNumUninitialized(Values.Num());
+		for (int32 Index = 0; Index < Values.Num(); ++Index)
+		{
+			OutResiduals[Index] = ZigZagEncode(Values[Index] - Predict(Predictor, Values.GetData(), Index));
+		}
+	}
+
+	void EncodeVarints(TConstArrayView<uint64> Residuals, TArray<uint8>& OutBytes)
+	{
+		OutBytes.Reset();
+		for (uint64 Residual : Residuals)
+		{
+			while (Residual >= 0x80)
+			{
+				OutBytes.Add(static_cast<uint8>(Residual) | 0x80);
+				Residual >>= 7;
+			}
+			OutBytes.Add(static_cast<uint8>(Residual));
+		}
+	}
+
+	int64 GetVarintSize(TConstArrayView<uint64> Residuals)
+	{
+		int64 Size = 0;
+		for (const uint64 Residual : Residuals)
+		{
+			Size += FMath::Max(1, (BloodStainBitStream::GetBitWidth(Residual) + 6) / 7);
+		}
+		return Size;
+	}
+
+	bool DecodeVarints(const uint8* Cursor, const uint8* End, TArrayView<uint64> OutResiduals)
+	{
+		for (uint64& Residual : OutResiduals)
+		{
+			Residual = 0;
+			uint32 Shift = 0;
+			uint8 Byte = 0;
+			do
+			{
+				if (Cursor == End || Shift > 63)
+				{
+					return false;
+				}
+				Byte = *Cursor++;
+				Residual |= static_cast<uint64>(Byte & 0x7F) << Shift;
+				Shift += 7;
+			}
+			while (Byte & 0x80);
+		}
+		return Cursor == End;
+	}
+
+	/**
+	 * Finds the predictor and residual encoding that yield the fewest bytes for Values:
+	 * either every residual bit-packed with the channel's widest residual width, or zig-zag varints.
+	 * @return Size of the residual bytes
+	 */
+	int64 FindResidualEncoding(TConstArrayView<int64> Values, uint8& OutPredictor, uint8& OutWidth)
+	{
+		TArray<uint64> Residuals;
+		int64 BestSize = MAX_int64;
+		for (uint8 Predictor = 0; Predictor < static_cast<uint8>(EChannelPredictor::Num); ++Predictor)
+		{
+			ComputeResiduals(Values, static_cast<EChannelPredictor>(Predictor), Residuals);
+
+			uint64 Combined = 0;
+			for (const uint64 Residual : Residuals)
+			{
+				Combined |= Residual;
+			}
+			const int32 Width = BloodStainBitStream::GetBitWidth(Combined);
+			const int64 PackedSize = BloodStainBitStream::GetPackedSize(Residuals.Num(), Width);
+			const int64 VarintSize = GetVarintSize(Residuals);
+
+			if (PackedSize < BestSize)
+			{
+				BestSize = PackedSize;
+				OutPredictor = Predictor;
+				OutWidth = static_cast<uint8>(Width);
+			}
+			if (VarintSize < BestSize)
+			{
+				BestSize = VarintSize;
+				OutPredictor = Predictor;
+				OutWidth = VarintWidth;
+			}
+		}
+		return BestSize;
+	}
+
+	/** Predictor byte flag of a residual channel stored at reduced precision; its FChannelPrecision follows the predictor */
+	constexpr uint8 ReducedPrecisionFlag = 0x80;
+
+	/** Limits of reduced precision channels; keep Code * Range within 64 bits */
+	constexpr int64 MaxReducedPrecisionRange = int64(1) << 40;
+	constexpr uint8 MaxReducedPrecisionBits = 22;
+
+	/**
+	 * Precision of a channel stored with fewer bits than its quantization grid: the range [Min, Min + Range]
+	 * is split into 2^Bits - 1 equal steps and every value is stored as the index of its nearest step
+	 */
+	struct FChannelPrecision
+	{
+		int64 Min = 0;
+		int64 Range = 0;
+		uint8 Bits = 0;
+
+		FORCEINLINE int64 GetMaxCode() const
+		{
+			return (int64(1) << Bits) - 1;
+		}
+
+		FORCEINLINE int64 ToCode(int64 Value) const
+		{
+			return RoundedDivide((Value - Min) * GetMaxCode(), Range);
+		}
+
+		FORCEINLINE int64 FromCode(int64 Code) const
+		{
+			return Min + RoundedDivide(Code * Range, GetMaxCode());
+		}
+
+		friend FArchive& operator<<(FArchive& Ar, FChannelPrecision& Precision)
+		{
+			Ar << Precision.Min;
+			Ar << Precision.Range;
+			Ar << Precision.Bits;
+			return Ar;
+		}
+
+		bool IsValid() const
+		{
+			return Range > 0 && Range <= MaxReducedPrecisionRange && Bits > 0 && Bits <= MaxReducedPrecisionBits
+				&& Min <= MAX_int64 - Range;
+		}
+	};
+
+	/**
+	 * Picks the fewest bits per value that keep every value of the channel within Tolerance steps:
+	 * the encode and decode roundings add up to half a code step plus half a grid step.
+	 * @return false if the channel gains nothing from fewer bits (no budget, constant, or already as coarse as the budget allows)
+	 */
+	bool FindChannelPrecision(TConstArrayView<int64> Values, int64 Tolerance, FChannelPrecision& OutPrecision)
+	{
+		if (Tolerance <= 0 || Values.Num() == 0)
+		{
+			return false;
+		}
+
+		int64 MinValue = MAX_int64;
+		int64 MaxValue = MIN_int64;
+		for (const int64 Value : Values)
+		{
+			MinValue = FMath::Min(MinValue, Value);
+			MaxValue = FMath::Max(MaxValue, Value);
+		}
+		if (MinValue < -MaxReducedPrecisionRange || MaxValue > MaxReducedPrecisionRange)
+		{
+			return false;
+		}
+
+		const int64 Range = MaxValue - MinValue;
+		if (Range <= 0 || Range > MaxReducedPrecisionRange)
+		{
+			return false;
+		}
+
+		// Range / MaxCode <= 2 * Tolerance - 1
+		const int64 MaxStep = 2 * Tolerance - 1;
+		const int32 Bits = BloodStainBitStream::GetBitWidth(static_cast<uint64>((Range + MaxStep - 1) / MaxStep));
+		if (Bits >= BloodStainBitStream::GetBitWidth(static_cast<uint64>(Range)) || Bits > MaxReducedPrecisionBits)
+		{
+			return false;
+		}
+
+		OutPrecision.Min = MinValue;
+		OutPrecision.Range = Range;
+		OutPrecision.Bits = static_cast<uint8>(Bits);
+		return true;
+	}
+
+	/**
+	 * Writes the predictor and residual encoding that yield the fewest bytes (FindResidualEncoding).
+	 * With a positive Tolerance the channel may instead be stored at the coarsest precision that stays within Tolerance steps
+	 * of every value (FindChannelPrecision), its range and bit count recorded in the channel header, when that is smaller.
+	 */
+	void EncodeResidualChannel(FArchive& Ar, TConstArrayView<int64> Values, int64 Tolerance = 0)
+	{
+		uint8 BestPredictor = 0;
+		uint8 BestWidth = VarintWidth;
+		const int64 FullSize = FindResidualEncoding(Values, BestPredictor, BestWidth);
+
+		FChannelPrecision Precision;
+		TArray<int64> Codes;
+		bool bReduced = false;
+		if (FindChannelPrecision(Values, Tolerance, Precision))
+		{
+			Codes.SetNumUninitialized(Values.Num());
+			for (int32 Index = 0; Index < Values.Num(); ++Index)
+			{
+				Codes[Index] = Precision.ToCode(Values[Index]);
+			}
+
+			uint8 ReducedPredictor = 0;
+			uint8 ReducedWidth = VarintWidth;
+			const int64 ReducedSize = FindResidualEncoding(Codes, ReducedPredictor, ReducedWidth)
+				+ sizeof(Precision.Min) + sizeof(Precision.Range) + sizeof(Precision.Bits);
+			if (ReducedSize < FullSize)
+			{
+				bReduced = true;
+				BestPredictor = ReducedPredictor;
+				BestWidth = ReducedWidth;
+			}
+		}
+
+		TArray<uint64> Residuals;
+		ComputeResiduals(bReduced ? TConstArrayView<int64>(Codes) : Values, static_cast<EChannelPredictor>(BestPredictor), Residuals);
+		TArray<uint8> Bytes;
+		if (BestWidth == VarintWidth)
+		{
+			EncodeVarints(Residuals, Bytes);
+		}
+		else
+		{
+			BloodStainBitStream::PackFixedWidth(Residuals, BestWidth, Bytes);
+		}
+
+		uint8 PredictorByte = bReduced ? (BestPredictor | ReducedPrecisionFlag) : BestPredictor;
+		Ar << PredictorByte;
+		if (bReduced)
+		{
+			Ar << Precision;
+		}
+		Ar << BestWidth;
+		Ar << Bytes;
+	}
+
+	/** Channel predictor value marking a channel stored as a piecewise cubic curve */
+	constexpr uint8 CurveChannel = 0xFE;
+
+	/** Channels shorter than this always store per-sample residuals */
+	constexpr int32 MinCurveSamples = 8;
+
+	/** Longest curve segment, in samples. Keeps the integer evaluation below within 64 bits */
+	constexpr int64 MaxCurveSegmentLength = 64;
+
+	/** Largest control point offset from the start value of a segment with inner samples, and largest knot value */
+	constexpr int64 MaxCurveOffset = int64(1) << 40;
+	constexpr int64 MaxCurveValue = int64(1) << 52;
+
+	/**
+	 * Evaluates a cubic Bezier segment at sample Step of Length, in integers so encoder and decoder agree on every platform.
+	 * D1, D2 and D3 are the control points after the start value P0, as offsets from it.
+	 */
+	FORCEINLINE int64 EvaluateCurveSegment(int64 P0, int64 D1, int64 D2, int64 D3, int64 Step, int64 Length)
+	{
+		const int64 Rest = Length - Step;
+		const int64 Numerator = 3 * Rest * Rest * Step * D1 + 3 * Rest * Step * Step * D2 + Step * Step * Step * D3;
+		return P0 + RoundedDivide(Numerator, Length * Length * Length);
+	}
+
+	/** Inner control points are stored relative to the chord, so straight motion leaves zeros */
+	FORCEINLINE int64 ChordThird(int64 D3) { return D3 / 3; }
+	FORCEINLINE int64 ChordTwoThirds(int64 D3) { return 2 * D3 / 3; }
+
+	/**
+	 * Least-squares fits the inner control points of the segment Values[0..Length] with its end values fixed.
+	 * @return true if every sample of the segment decodes within Tolerance and within [MinValue, MaxValue]
+	 */
+	bool FitCurveSegment(const int64* Values, int64 Length, int64 Tolerance, int64 MinValue, int64 MaxValue, int64& OutD1, int64& OutD2)
+	{
+		const int64 P0 = Values[0];
+		const int64 D3 = Values[Length] - P0;
+		if (FMath::Abs(D3) > MaxCurveOffset)
+		{
+			return false;
+		}
+
+		double A11 = 0.0, A12 = 0.0, A22 = 0.0, R1 = 0.0, R2 = 0.0;
+		for (int64 Step = 1; Step < Length; ++Step)
+		{
+			const double T = static_cast<double>(Step) / Length;
+			const double S = 1.0 - T;
+			const double B1 = 3.0 * S * S * T;
+			const double B2 = 3.0 * S * T * T;
+			const double Residual = static_cast<double>(Values[Step] - P0) - T * T * T * D3;
+			A11 += B1 * B1;
+			A12 += B1 * B2;
+			A22 += B2 * B2;
+			R1 += B1 * Residual;
+			R2 += B2 * Residual;
+		}
+
+		const double Determinant = A11 * A22 - A12 * A12;
+		if (Determinant > UE_DOUBLE_SMALL_NUMBER)
+		{
+			const double D1 = (R1 * A22 - R2 * A12) / Determinant;
+			const double D2 = (R2 * A11 - R1 * A12) / Determinant;
+			if (FMath::Abs(D1) > MaxCurveOffset || FMath::Abs(D2) > MaxCurveOffset)
+			{
+				return false;
+			}
+			OutD1 = FMath::RoundToInt64(D1);
+			OutD2 = FMath::RoundToInt64(D2);
+		}
+		else
+		{
+			OutD1 = ChordThird(D3);
+			OutD2 = ChordTwoThirds(D3);
+		}
+
+		for (int64 Step = 1; Step < Length; ++Step)
+		{
+			const int64 Value = EvaluateCurveSegment(P0, OutD1, OutD2, D3, Step, Length);
+			if (FMath::Abs(Value - Values[Step]) > Tolerance || Value < MinValue || Value > MaxValue)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Writes Values as piecewise cubic Bezier segments: segment count, then segment lengths, knot values
+	 * and both inner control points (relative to the chord) as residual channels.
+	 * Segments grow greedily until the fit leaves the tolerance; a one-sample segment is always exact.
+	 * @return false if the values are out of the curve range
+	 */
+	bool EncodeCurveChannel(FArchive& Ar, TConstArrayView<int64> Values, int64 Tolerance)
+	{
+		int64 MinValue = MAX_int64;
+		int64 MaxValue = MIN_int64;
+		for (const int64 Value : Values)
+		{
+			MinValue = FMath::Min(MinValue, Value);
+			MaxValue = FMath::Max(MaxValue, Value);
+		}
+		if (MinValue < -MaxCurveValue || MaxValue > MaxCurveValue)
+		{
+			return false;
+		}
+
+		TArray<int64> Lengths;
+		TArray<int64> Knots;
+		TArray<int64> Inner1;
+		TArray<int64> Inner2;
+		Knots.Add(Values[0]);
+
+		const int64 LastIndex = Values.Num() - 1;
+		int64 Start = 0;
+		while (Start < LastIndex)
+		{
+			int64 BestLength = 1;
+			int64 BestD1 = ChordThird(Values[Start + 1] - Values[Start]);
+			int64 BestD2 = ChordTwoThirds(Values[Start + 1] - Values[Start]);
+
+			const int64 MaxLength = FMath::Min(MaxCurveSegmentLength, LastIndex - Start);
+			for (int64 Length = 2; Length <= MaxLength; ++Length)
+			{
+				int64 D1 = 0;
+				int64 D2 = 0;
+				if (!FitCurveSegment(Values.GetData() + Start, Length, Tolerance, MinValue, MaxValue, D1, D2))
+				{
+					break;
+				}
+				BestLength = Length;
+				BestD1 = D1;
+				BestD2 = D2;
+			}
+
+			const int64 D3 = Values[Start + BestLength] - Values[Start];
+			Lengths.Add(BestLength);
+			Knots.Add(Values[Start + BestLength]);
+			Inner1.Add(BestD1 - ChordThird(D3));
+			Inner2.Add(BestD2 - ChordTwoThirds(D3));
+			Start += BestLength;
+		}
+
+		uint8 Predictor = CurveChannel;
+		int32 NumSegments = Lengths.Num();
+		Ar << Predictor;
+		Ar << NumSegments;
+		EncodeResidualChannel(Ar, Lengths);
+		EncodeResidualChannel(Ar, Knots);
+		EncodeResidualChannel(Ar, Inner1);
+		EncodeResidualChannel(Ar, Inner2);
+		return true;
+	}
+
+	/**
+	 * Writes Values with the per-sample residual encoding that yields the fewest bytes (EncodeResidualChannel).
+	 * With a positive CurveTolerance, the residuals may be stored at reduced precision, and a piecewise cubic curve
+	 * that stays within that many steps of every value is written instead when it is smaller.
+	 */
+	void EncodeChannel(FArchive& Ar, TConstArrayView<int64> Values, int64 CurveTolerance = 0)
+	{
+		if (CurveTolerance <= 0 || Values.Num() < MinCurveSamples)
+		{
+			EncodeResidualChannel(Ar, Values, CurveTolerance);
+			return;
+		}
+
+		TArray<uint8> ResidualBytes;
+		FMemoryWriter ResidualAr(ResidualBytes);
+		EncodeResidualChannel(ResidualAr, Values, CurveTolerance);
+
+		TArray<uint8> CurveBytes;
+		FMemoryWriter CurveAr(CurveBytes);
+		TArray<uint8>& Bytes = EncodeCurveChannel(CurveAr, Values, CurveTolerance) && CurveBytes.Num() < ResidualBytes.Num() ? CurveBytes : ResidualBytes;
+		Ar.Serialize(Bytes.GetData(), Bytes.Num());
+	}
+
+	void DecodeChannel(FArchive& Ar, TArrayView<int64> OutValues, bool bAllowCurve = true);
+
+	void DecodeCurveChannel(FArchive& Ar, TArrayView<int64> OutValues)
+	{
+		int32 NumSegments = 0;
+		Ar << NumSegments;
+		if (Ar.IsError() || NumSegments <= 0 || NumSegments >= OutValues.Num())
+		{
+			Ar.SetError();
+			return;
+		}
+
+		TArray<int64> Lengths;
+		TArray<int64> Knots;
+		TArray<int64> Inner1;
+		TArray<int64> Inner2;
+		Lengths.SetNumUninitialized(NumSegments);
+		Knots.SetNumUninitialized(NumSegments + 1);
+		Inner1.SetNumUninitialized(NumSegments);
+		Inner2.SetNumUninitialized(NumSegments);
+		DecodeChannel(Ar, Lengths, false);
+		DecodeChannel(Ar, Knots, false);
+		DecodeChannel(Ar, Inner1, false);
+		DecodeChannel(Ar, Inner2, false);
+		if (Ar.IsError())
+		{
+			return;
+		}
+
+		int64* const Values = OutValues.GetData();
+		int64 Start = 0;
+		for (int32 Segment = 0; Segment < NumSegments; ++Segment)
+		{
+			const int64 Length = Lengths[Segment];
+			const int64 P0 = Knots[Segment];
+			const int64 P3 = Knots[Segment + 1];
+			if (Length < 1 || Length > MaxCurveSegmentLength || Start + Length >= OutValues.Num()
+				|| FMath::Abs(P0) > MaxCurveValue || FMath::Abs(P3) > MaxCurveValue
+				|| FMath::Abs(Inner1[Segment]) > MaxCurveOffset || FMath::Abs(Inner2[Segment]) > MaxCurveOffset)
+			{
+				Ar.SetError();
+				return;
+			}
+
+			const int64 D3 = P3 - P0;
+			const int64 D1 = Inner1[Segment] + ChordThird(D3);
+			const int64 D2 = Inner2[Segment] + ChordTwoThirds(D3);
+			if (Length > 1 && (FMath::Abs(D1) > MaxCurveOffset || FMath::Abs(D2) > MaxCurveOffset || FMath::Abs(D3) > MaxCurveOffset))
+			{
+				Ar.SetError();
+				return;
+			}
+
+			Values[Start] = P0;
+			for (int64 Step = 1; Step < Length; ++Step)
+			{
+				Values[Start + Step] = EvaluateCurveSegment(P0, D1, D2, D3, Step, Length);
+			}
+			Start += Length;
+		}
+
+		if (Start != OutValues.Num() - 1)
+		{
+			Ar.SetError();
+			return;
+		}
+		Values[Start] = Knots[NumSegments];
+	}
+
+	void DecodeChannel(FArchive& Ar, TArrayView<int64> OutValues, bool bAllowCurve)
+	{
+		uint8 PredictorByte = 0;
+		Ar << PredictorByte;
+		if (bAllowCurve && PredictorByte == CurveChannel && !Ar.IsError())
+		{
+			DecodeCurveChannel(Ar, OutValues);
+			return;
+		}
+
+		FChannelPrecision Precision;
+		const bool bReduced = (PredictorByte & ReducedPrecisionFlag) != 0;
+		if (bReduced)
+		{
+			PredictorByte &= ~ReducedPrecisionFlag;
+			Ar << Precision;
+		}
+
+		uint8 Width = 0;
+		TArray<uint8> Bytes;
+		Ar << Width;
+		Ar << Bytes;
+		if (Ar.IsError() || PredictorByte >= static_cast<uint8>(EChannelPredictor::Num) || (Width > 64 && Width != VarintWidth)
+			|| (bReduced && !Precision.IsValid()))
+		{
+			Ar.SetError();
+			return;
+		}
+
+		TArray<uint64> Residuals;
+		Residuals.SetNumUninitialized(OutValues.Num());
+		const bool bDecoded = Width == VarintWidth
+			? DecodeVarints(Bytes.GetData(), Bytes.GetData() + Bytes.Num(), Residuals)
+			: Bytes.Num() == BloodStainBitStream::GetPackedSize(Residuals.Num(), Width) && BloodStainBitStream::UnpackFixedWidth(Bytes.GetData(), Bytes.Num(), Width, Residuals);
+		if (!bDecoded)
+		{
+			Ar.SetError();
+			return;
+		}
+
+		const EChannelPredictor Predictor = static_cast<EChannelPredictor>(PredictorByte);
+		int64* const Values = OutValues.GetData();
+		for (int32 Index = 0; Index < OutValues.Num(); ++Index)
+		{
+			Values[Index] = Predict(Predictor, Values, Index) + ZigZagDecode(Residuals[Index]);
+		}
+
+		if (bReduced)
+		{
+			const int64 MaxCode = Precision.GetMaxCode();
+			for (int64& Value : OutValues)
+			{
+				if (Value < 0 || Value > MaxCode)
+				{
+					Ar.SetError();
+					return;
+				}
+				Value = Precision.FromCode(Value);
+			}
+		}
+	}
+
+	/** FQuatFixed32NoW and FVectorIntervalFixed32NoW pack three fields as 11 / 11 / 10 bits */
+	FORCEINLINE void UnpackFixed32(uint32 Packed, int64* Out)
+	{
+		Out[0] = (Packed >> 21) & 0x7FF;
+		Out[1] = (Packed >> 10) & 0x7FF;
+		Out[2] = Packed & 0x3FF;
+	}
+
+	FORCEINLINE uint32 PackFixed32(const int64* In)
+	{
+		return (static_cast<uint32>(In[0] & 0x7FF) << 21) | (static_cast<uint32>(In[1] & 0x7FF) << 10) | static_cast<uint32>(In[2] & 0x3FF);
+	}
+
+	/*
+	 * ToChannels / FromChannels convert the channels of one transform. For layouts with bGridLanes only the rotation
+	 * channels are touched; the translation and scale channels of the whole track go through GridLanesToChannels /
+	 * ChannelsToGridLanes.
+	 */
+
+	void ToChannels(const FQuantizedTransform_High& Q, int64* Out)
+	{
+		Out[3] = Q.Rotation.X;
+		Out[4] = Q.Rotation.Y;
+		Out[5] = Q.Rotation.Z;
+	}
+
+	void FromChannels(const int64* In, FQuantizedTransform_High& Q)
+	{
+		Q.Rotation.X = static_cast<uint16>(In[3]);
+		Q.Rotation.Y = static_cast<uint16>(In[4]);
+		Q.Rotation.Z = static_cast<uint16>(In[5]);
+	}
+
+	void ToChannels(const FQuantizedTransform_Compact& Q, int64* Out)
+	{
+		UnpackFixed32(Q.Rotation.Packed, Out + 3);
+	}
+
+	void FromChannels(const int64* In, FQuantizedTransform_Compact& Q)
+	{
+		Q.Rotation.Packed = PackFixed32(In + 3);
+	}
+
+	void ToChannels(const FQuantizedTransform_Lowest& Q, int64* Out)
+	{
+		UnpackFixed32(Q.Translation.Packed, Out);
+		UnpackFixed32(Q.Rotation.Packed, Out + 3);
+		UnpackFixed32(Q.Scale.Packed, Out + 6);
+	}
+
+	void FromChannels(const int64* In, FQuantizedTransform_Lowest& Q)
+	{
+		Q.Translation.Packed = PackFixed32(In);
+		Q.Rotation.Packed = PackFixed32(In + 3);
+		Q.Scale.Packed = PackFixed32(In + 6);
+	}
+
+	/** The width is not a channel; it is stored once per track and set by the caller */
+	void ToChannels(const FQuantizedTransform_SmallestThree& Q, int64* Out)
+	{
+		Out[3] = Q.Rotation.LargestIndex;
+		Out[4] = Q.Rotation.Components[0];
+		Out[5] = Q.Rotation.Components[1];
+		Out[6] = Q.Rotation.Components[2];
+	}
+
+	void FromChannels(const int64* In, FQuantizedTransform_SmallestThree& Q)
+	{
+		Q.Rotation.LargestIndex = static_cast<uint8>(In[3] & 3);
+		Q.Rotation.Components[0] = static_cast<uint16>(In[4]);
+		Q.Rotation.Components[1] = static_cast<uint16>(In[5]);
+		Q.Rotation.Components[2] = static_cast<uint16>(In[6]);
+	}
+
+	/** Writes the grid counts of the translation and scale lanes of a whole track into their (channel-major) channels */
+	template<typename QuantType>
+	void GridLanesToChannels(const TArray<QuantType>& Quantized, int64* Channels)
+	{
+		constexpr int32 ScaleChannel = TChannelLayout<QuantType>::NumChannels - 3;
+		const int32 NumSamples = Quantized.Num();
+
+		TArray<double> Values;
+		Values.SetNumUninitialized(NumSamples * 3);
+		for (int32 Lane = 0; Lane < 2; ++Lane)
+		{
+			for (int32 Index = 0; Index < NumSamples; ++Index)
+			{
+				const FVector& V = Lane == 0 ? static_cast<const FVector&>(Quantized[Index].Location) : static_cast<const FVector&>(Quantized[Index].Scale);
+				Values[Index] = V.X;
+				Values[NumSamples + Index] = V.Y;
+				Values[NumSamples * 2 + Index] = V.Z;
+			}
+
+			const int32 FirstChannel = Lane == 0 ? 0 : ScaleChannel;
+			const double StepsPerUnit = Lane == 0 ? QuantizedLocationStepsPerUnit : QuantizedScaleStepsPerUnit;
+			BloodStainQuantizationKernels::GridValuesToCounts(Values, StepsPerUnit, TArrayView<int64>(Channels + FirstChannel * NumSamples, NumSamples * 3));
+		}
+	}
+
+	/** Rebuilds the translation and scale lanes of a whole track from their grid counts */
+	template<typename QuantType>
+	void ChannelsToGridLanes(const int64* Channels, int32 NumSamples, TArray<QuantType>& OutQuantized)
+	{
+		constexpr int32 ScaleChannel = TChannelLayout<QuantType>::NumChannels - 3;
+
+		TArray<double> Values;
+		Values.SetNumUninitialized(NumSamples * 3);
+		for (int32 Lane = 0; Lane < 2; ++Lane)
+		{
+			const int32 FirstChannel = Lane == 0 ? 0 : ScaleChannel;
+			const double StepsPerUnit = Lane == 0 ? QuantizedLocationStepsPerUnit : QuantizedScaleStepsPerUnit;
+			BloodStainQuantizationKernels::GridCountsToValues(TConstArrayView<int64>(Channels + FirstChannel * NumSamples, NumSamples * 3), StepsPerUnit, Values);
+
+			for (int32 Index = 0; Index < NumSamples; ++Index)
+			{
+				const FVector V(Values[Index], Values[NumSamples + Index], Values[NumSamples * 2 + Index]);
+				if (Lane == 0)
+				{
+					OutQuantized[Index].Location = V;
+				}
+				else
+				{
+					OutQuantized[Index].Scale = V;
+				}
+			}
+		}
+	}
+
+	/** Maps a channel to its translation / rotation / scale group */
+	FORCEINLINE bool IsConstantChannel(uint8 ConstantMask, int32 Channel, int32 NumRotationChannels)
+	{
+		const uint8 Group = Channel < 3 ? ConstantTranslation : (Channel < 3 + NumRotationChannels ? ConstantRotation : ConstantScale);
+		return (ConstantMask & Group) != 0;
+	}
+
+	/**
+	 * Splits quantized samples into integer channels and delta codes each channel over time.
+	 * Channels of constant groups are stored as the first sample's value only.
+	 * A positive CurveTolerance lets the other channels be stored as curves (EncodeChannel).
+	 */
+	template<typename QuantType>
+	void WriteQuantizedTrack(FArchive& Ar, const TArray<QuantType>& Quantized, uint8 ConstantMask, int32 CurveTolerance)
+	{
+		constexpr int32 NumChannels = TChannelLayout<QuantType>::NumChannels;
+		constexpr int32 NumRotationChannels = TChannelLayout<QuantType>::NumRotationChannels;
+
+		const int32 NumSamples = Quantized.Num();
+		TArray<int64> Channels;
+		Channels.SetNumUninitialized(NumSamples * NumChannels);
+		constexpr bool bGridLanes = TChannelLayout<QuantType>::bGridLanes;
+		constexpr int32 FirstChannel = bGridLanes ? 3 : 0;
+		constexpr int32 EndChannel = bGridLanes ? NumChannels - 3 : NumChannels;
+		for (int32 Index = 0; Index < NumSamples; ++Index)
+		{
+			int64 Sample[NumChannels];
+			ToChannels(Quantized[Index], Sample);
+			for (int32 Channel = FirstChannel; Channel < EndChannel; ++Channel)
+			{
+				Channels[Channel * NumSamples + Index] = Sample[Channel];
+			}
+		}
+		if constexpr (bGridLanes)
+		{
+			GridLanesToChannels(Quantized, Channels.GetData());
+		}
+
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			const int32 NumStored = IsConstantChannel(ConstantMask, Channel, NumRotationChannels) ? FMath::Min(NumSamples, 1) : NumSamples;
+			const int32 Tolerance = Channel == TChannelLayout<QuantType>::DiscreteChannel ? 0 : CurveTolerance;
+			EncodeChannel(Ar, TConstArrayView<int64>(Channels.GetData() + Channel * NumSamples, NumStored), Tolerance);
+		}
+	}
+
+	template<typename QuantType>
+	void ReadQuantizedTrack(FArchive& Ar, int32 NumSamples, uint8 ConstantMask, TArray<QuantType>& OutQuantized)
+	{
+		constexpr int32 NumChannels = TChannelLayout<QuantType>::NumChannels;
+		constexpr int32 NumRotationChannels = TChannelLayout<QuantType>::NumRotationChannels;
+
+		TArray<int64> Channels;
+		Channels.SetNumUninitialized(NumSamples * NumChannels);
+		for (int32 Channel = 0; Channel < NumChannels && !Ar.IsError(); ++Channel)
+		{
+			int64* const ChannelValues = Channels.GetData() + Channel * NumSamples;
+			if (IsConstantChannel(ConstantMask, Channel, NumRotationChannels) && NumSamples > 0)
+			{
+				DecodeChannel(Ar, TArrayView<int64>(ChannelValues, 1));
+				for (int32 Index = 1; Index < NumSamples; ++Index)
+				{
+					ChannelValues[Index] = ChannelValues[0];
+				}
+			}
+			else
+			{
+				DecodeChannel(Ar, TArrayView<int64>(ChannelValues, NumSamples));
+			}
+		}
+		if (Ar.IsError())
+		{
+			return;
+		}
+
+		constexpr bool bGridLanes = TChannelLayout<QuantType>::bGridLanes;
+		constexpr int32 FirstChannel = bGridLanes ? 3 : 0;
+		constexpr int32 EndChannel = bGridLanes ? NumChannels - 3 : NumChannels;
+		OutQuantized.SetNum(NumSamples);
+		for (int32 Index = 0; Index < NumSamples; ++Index)
+		{
+			int64 Sample[NumChannels];
+			for (int32 Channel = FirstChannel; Channel < EndChannel; ++Channel)
+			{
+				Sample[Channel] = Channels[Channel * NumSamples + Index];
+			}
+			FromChannels(Sample, OutQuantized[Index]);
+		}
+		if constexpr (bGridLanes)
+		{
+			ChannelsToGridLanes(Channels.GetData(), NumSamples, OutQuantized);
+		}
+	}
+
+	/**
+	 * Writes or reads the 'Standard_Low' range of one track as float bounds.
+	 * Constant groups store only their minimum; the range collapses onto it.
+	 */
+	void SerializeTrackRanges(FArchive& Ar, FLocRange& LocRange, FScaleRange& ScaleRange, uint8 ConstantMask)
+	{
+		FVector3f PosMin(LocRange.PosMin);
+		FVector3f PosMax(LocRange.PosMax);
+		Ar << PosMin;
+		if (ConstantMask & ConstantTranslation)
+		{
+			PosMax = PosMin;
+		}
+		else
+		{
+			Ar << PosMax;
+		}
+
+		FVector3f ScaleMin(ScaleRange.ScaleMin);
+		FVector3f ScaleMax(ScaleRange.ScaleMax);
+		Ar << ScaleMin;
+		if (ConstantMask & ConstantScale)
+		{
+			ScaleMax = ScaleMin;
+		}
+		else
+		{
+			Ar << ScaleMax;
+		}
+
+		LocRange.PosMin = FVector(PosMin);
+		LocRange.PosMax = FVector(PosMax);
+		ScaleRange.ScaleMin = FVector(ScaleMin);
+		ScaleRange.ScaleMax = FVector(ScaleMax);
+	}
+
+	/** Quantizes a track with one method dispatched by the caller and writes its channels */
+	template<typename QuantType>
+	void WriteQuantizedSamples(FArchive& Ar, TConstArrayView<const FTransform*> Samples, const FTrackQuantizationParams& Params, uint8 ConstantMask, int32 CurveTolerance)
+	{
+		TArray<QuantType> Quantized;
+		QuantizeTrack(Samples, Params, Quantized);
+		WriteQuantizedTrack(Ar, Quantized, ConstantMask, CurveTolerance);
+	}
+
+	template<typename QuantType>
+	void ReadQuantizedSamples(FArchive& Ar, int32 NumSamples, const FTrackQuantizationParams& Params, uint8 ConstantMask, TArray<FTransform>& OutTransforms)
+	{
+		TArray<QuantType> Quantized;
+		ReadQuantizedTrack(Ar, NumSamples, ConstantMask, Quantized);
+		DequantizeTrack<QuantType>(Quantized, Params, OutTransforms);
+	}
+
+	void WriteTrack(FArchive& Ar, TConstArrayView<const FTransform*> Samples, ETransformQuantizationMethod Method, int32 SmallestThreeBits, int32 CurveTolerance)
+	{
+		uint8 ConstantMask = FindConstantChannels(Samples);
+		Ar << ConstantMask;
+
+		switch (Method)
+		{
+		case ETransformQuantizationMethod::Standard_High:
+			WriteQuantizedSamples<FQuantizedTransform_High>(Ar, Samples, FTrackQuantizationParams(), ConstantMask, CurveTolerance);
+			break;
+		case ETransformQuantizationMethod::Standard_Medium:
+			WriteQuantizedSamples<FQuantizedTransform_Compact>(Ar, Samples, FTrackQuantizationParams(), ConstantMask, CurveTolerance);
+			break;
+		case ETransformQuantizationMethod::Standard_SmallestThree:
+			{
+				uint8 Bits = static_cast<uint8>(FMath::Clamp(SmallestThreeBits, FQuatSmallestThree::MinBits, FQuatSmallestThree::MaxBits));
+				Ar << Bits;
+
+				WriteQuantizedSamples<FQuantizedTransform_SmallestThree>(Ar, Samples, FTrackQuantizationParams(nullptr, nullptr, Bits), ConstantMask, CurveTolerance);
+				break;
+			}
+		case ETransformQuantizationMethod::Standard_Low:
+			{
+				FLocRange LocRange;
+				FScaleRange ScaleRange;
+				BloodStainFileUtils_Internal::ComputeTrackRanges(Samples, LocRange, ScaleRange);
+				SerializeTrackRanges(Ar, LocRange, ScaleRange, ConstantMask);
+
+				WriteQuantizedSamples<FQuantizedTransform_Lowest>(Ar, Samples, FTrackQuantizationParams(&LocRange, &ScaleRange), ConstantMask, CurveTolerance);
+				break;
+			}
+		case ETransformQuantizationMethod::None:
+		default:
+			{
+				TArray<FRawTransformSample> Raw;
+				Raw.Reserve(Samples.Num());
+				for (const FTransform* Sample : Samples)
+				{
+					Raw.Emplace(*Sample);
+				}
+				SerializeColumns(Ar, Raw, ConstantMask, &FRawTransformSample::Location, &FRawTransformSample::Rotation, &FRawTransformSample::Scale);
+				break;
+			}
+		}
+	}
+
+	void ReadTrack(FArchive& Ar, int32 NumSamples, ETransformQuantizationMethod Method, TArray<FTransform>& OutTransforms)
+	{
+		OutTransforms.Reset(NumSamples);
+
+		uint8 ConstantMask = 0;
+		Ar << ConstantMask;
+
+		switch (Method)
+		{
+		case ETransformQuantizationMethod::Standard_High:
+			ReadQuantizedSamples<FQuantizedTransform_High>(Ar, NumSamples, FTrackQuantizationParams(), ConstantMask, OutTransforms);
+			break;
+		case ETransformQuantizationMethod::Standard_Medium:
+			ReadQuantizedSamples<FQuantizedTransform_Compact>(Ar, NumSamples, FTrackQuantizationParams(), ConstantMask, OutTransforms);
+			break;
+		case ETransformQuantizationMethod::Standard_SmallestThree:
+			{
+				uint8 Bits = 0;
+				Ar << Bits;
+				if (Bits < FQuatSmallestThree::MinBits || Bits > FQuatSmallestThree::MaxBits)
+				{
+					Ar.SetError();
+					return;
+				}
+
+				TArray<FQuantizedTransform_SmallestThree> Quantized;
+				ReadQuantizedTrack(Ar, NumSamples, ConstantMask, Quantized);
+				for (FQuantizedTransform_SmallestThree& Q : Quantized)
+				{
+					Q.Rotation.BitsPerComponent = Bits;
+				}
+				DequantizeTrack<FQuantizedTransform_SmallestThree>(Quantized, FTrackQuantizationParams(), OutTransforms);
+				break;
+			}
+		case ETransformQuantizationMethod::Standard_Low:
+			{
+				FLocRange LocRange;
+				FScaleRange ScaleRange;
+				SerializeTrackRanges(Ar, LocRange, ScaleRange, ConstantMask);
+
+				ReadQuantizedSamples<FQuantizedTransform_Lowest>(Ar, NumSamples, FTrackQuantizationParams(&LocRange, &ScaleRange), ConstantMask, OutTransforms);
+				break;
+			}
+		case ETransformQuantizationMethod::None:
+		default:
+			{
+				TArray<FRawTransformSample> Raw;
+				Raw.SetNum(NumSamples);
+				SerializeColumns(Ar, Raw, ConstantMask, &FRawTransformSample::Location, &FRawTransformSample::Rotation, &FRawTransformSample::Scale);
+				for (const FRawTransformSample& Sample : Raw)
+				{
+					OutTransforms.Add(Sample.ToTransform());
+				}
+				break;
+			}
+		}
+	}
+
+	/** How the TimeStamp and FrameIndex of a run are stored */
+	enum class ETimelineEncoding : uint8
+	{
+		/** Evenly spaced, consecutively indexed frames: start time, interval and first frame index only */
+		Uniform,
+
+		/** Start time, then millisecond offsets from it and frame indices as predicted channels */
+		Milliseconds,
+
+		Num
+	};
+
+	void WriteTimeline(FArchive& Ar, TConstArrayView<FRecordFrame> Frames)
+	{
+		const int32 NumFrames = Frames.Num();
+		float StartTime = NumFrames > 0 ? Frames[0].TimeStamp : 0.f;
+		int32 FirstFrameIndex = NumFrames > 0 ? Frames[0].FrameIndex : 0;
+
+		bool bConsecutive = true;
+		for (int32 Index = 1; Index < NumFrames && bConsecutive; ++Index)
+		{
+			bConsecutive = Frames[Index].FrameIndex == FirstFrameIndex + Index;
+		}
+
+		float Interval = bConsecutive ? BloodStainRecordDataUtils::FindUniformFrameInterval(Frames) : 0.f;
+		if (Interval > 0.f)
+		{
+			uint8 Encoding = static_cast<uint8>(ETimelineEncoding::Uniform);
+			Ar << Encoding;
+			Ar << StartTime;
+			Ar << Interval;
+			Ar << FirstFrameIndex;
+			return;
+		}
+
+		TArray<int64> Offsets;
+		TArray<int64> FrameIndices;
+		Offsets.Reserve(NumFrames);
+		FrameIndices.Reserve(NumFrames);
+		for (const FRecordFrame& Frame : Frames)
+		{
+			Offsets.Add(FMath::RoundToInt64((static_cast<double>(Frame.TimeStamp) - StartTime) * 1000.0));
+			FrameIndices.Add(Frame.FrameIndex);
+		}
+
+		uint8 Encoding = static_cast<uint8>(ETimelineEncoding::Milliseconds);
+		Ar << Encoding;
+		Ar << StartTime;
+		EncodeChannel(Ar, Offsets);
+		EncodeChannel(Ar, FrameIndices);
+	}
+
+	void ReadTimeline(FArchive& Ar, TArrayView<FRecordFrame> OutFrames)
+	{
+		uint8 Encoding = 0;
+		float StartTime = 0.f;
+		Ar << Encoding;
+		Ar << StartTime;
+		if (Ar.IsError() || Encoding >= static_cast<uint8>(ETimelineEncoding::Num))
+		{
+			Ar.SetError();
+			return;
+		}
+
+		if (Encoding == static_cast<uint8>(ETimelineEncoding::Uniform))
+		{
+			float Interval = 0.f;
+			int32 FirstFrameIndex = 0;
+			Ar << Interval;
+			Ar << FirstFrameIndex;
+			for (int32 Index = 0; Index < OutFrames.Num(); ++Index)
+			{
+				OutFrames[Index].TimeStamp = StartTime + Index * Interval;
+				OutFrames[Index].FrameIndex = FirstFrameIndex + Index;
+			}
+			return;
+		}
+
+		TArray<int64> Offsets;
+		TArray<int64> FrameIndices;
+		Offsets.SetNumUninitialized(OutFrames.Num());
+		FrameIndices.SetNumUninitialized(OutFrames.Num());
+		DecodeChannel(Ar, Offsets);
+		DecodeChannel(Ar, FrameIndices);
+		if (Ar.IsError())
+		{
+			return;
+		}
+
+		for (int32 Index = 0; Index < OutFrames.Num(); ++Index)
+		{
+			OutFrames[Index].TimeStamp = static_cast<float>(StartTime + Offsets[Index] / 1000.0);
+			OutFrames[Index].FrameIndex = static_cast<int32>(FrameIndices[Index]);
+		}
+	}
+
+	/** Every sample takes at least one byte, so counts beyond the remaining archive size are corrupt */
+	bool IsPlausibleCount(FArchive& Ar, int64 Count)
+	{
+		return Count >= 0 && (Ar.TotalSize() < 0 || Count <= Ar.TotalSize() - Ar.Tell());
+	}
+}
+
+namespace BloodStainTrackUtils
+{
+	using namespace BloodStainTrackUtils_Internal;
+
+	void SerializeTracks(FArchive& Ar, TConstArrayView<FRecordFrame> Frames, ETransformQuantizationMethod QuantOpts, const FTrackQuantizationTable* TrackTable, int32 SmallestThreeBits, int32 CurveTolerance)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_TrackUtils_SerializeTracks);
+
+		const bool bPerTrack = QuantOpts == ETransformQuantizationMethod::Auto && ensure(TrackTable);
+		const int32 NumFrames = Frames.Num();
+
+		TArray<FString> ComponentNames;
+		TArray<FString> SkeletalNames;
+		for (const FRecordFrame& Frame : Frames)
+		{
+			for (const auto& Pair : Frame.ComponentTransforms)
+			{
+				ComponentNames.AddUnique(Pair.Key);
+			}
+			for (const auto& Pair : Frame.SkeletalMeshBoneTransforms)
+			{
+				SkeletalNames.AddUnique(Pair.Key);
+			}
+		}
+
+		int32 NumFramesToWrite = NumFrames;
+		Ar << NumFramesToWrite;
+		WriteTimeline(Ar, Frames);
+
+		TArray<const FTransform*> Samples;
+		Samples.Reserve(NumFrames);
+
+		Ar << ComponentNames;
+		for (const FString& ComponentName : ComponentNames)
+		{
+			TBitArray<> Present(false, NumFrames);
+			Samples.Reset();
+			for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+			{
+				if (const FTransform* Transform = Frames[FrameIndex].ComponentTransforms.Find(ComponentName))
+				{
+					Present[FrameIndex] = true;
+					Samples.Add(Transform);
+				}
+			}
+
+			Ar << Present;
+			const ETransformQuantizationMethod Method = bPerTrack ? TrackTable->GetComponentMethod(ComponentName) : QuantOpts;
+			WriteTrack(Ar, Samples, Method, SmallestThreeBits, CurveTolerance);
+		}
+
+		Ar << SkeletalNames;
+		for (const FString& SkeletalName : SkeletalNames)
+		{
+			TBitArray<> Present(false, NumFrames);
+			TArray<const FBoneComponentSpace*> Spaces;
+			TArray<int32> BoneCounts;
+			int32 MaxBoneCount = 0;
+			for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+			{
+				if (const FBoneComponentSpace* Space = Frames[FrameIndex].SkeletalMeshBoneTransforms.Find(SkeletalName))
+				{
+					Present[FrameIndex] = true;
+					Spaces.Add(Space);
+					BoneCounts.Add(Space->BoneTransforms.Num());
+					MaxBoneCount = FMath::Max(MaxBoneCount, Space->BoneTransforms.Num());
+				}
+			}
+
+			Ar << Present;
+			Ar << BoneCounts;
+
+			for (int32 BoneIndex = 0; BoneIndex < MaxBoneCount; ++BoneIndex)
+			{
+				Samples.Reset();
+				for (const FBoneComponentSpace* Space : Spaces)
+				{
+					if (Space->BoneTransforms.IsValidIndex(BoneIndex))
+					{
+						Samples.Add(&Space->BoneTransforms[BoneIndex]);
+					}
+				}
+
+				const ETransformQuantizationMethod Method = bPerTrack ? TrackTable->GetBoneMethod(SkeletalName, BoneIndex) : QuantOpts;
+				WriteTrack(Ar, Samples, Method, SmallestThreeBits, CurveTolerance);
+			}
+		}
+	}
+
+	void DeserializeTracks(FArchive& Ar, TArray<FRecordFrame>& OutFrames, ETransformQuantizationMethod QuantOpts, const FTrackQuantizationTable* TrackTable)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_TrackUtils_DeserializeTracks);
+
+		const bool bPerTrack = QuantOpts == ETransformQuantizationMethod::Auto;
+		const int32 FirstOutFrame = OutFrames.Num();
+
+		auto Fail = [&Ar, &OutFrames, FirstOutFrame]()
+		{
+			Ar.SetError();
+			OutFrames.SetNum(FirstOutFrame, EAllowShrinking::No);
+		};
+
+		if (bPerTrack && !TrackTable)
+		{
+			Fail();
+			return;
+		}
+
+		// A uniform timeline takes no bytes per frame, but every recorded frame has a presence bit in at least one track
+		int32 NumFrames = 0;
+		Ar << NumFrames;
+		if (Ar.IsError() || NumFrames < 0 || !IsPlausibleCount(Ar, NumFrames / 8))
+		{
+			Fail();
+			return;
+		}
+
+		OutFrames.AddDefaulted(NumFrames);
+		const TArrayView<FRecordFrame> Frames(OutFrames.GetData() + FirstOutFrame, NumFrames);
+		ReadTimeline(Ar, Frames);
+		if (Ar.IsError())
+		{
+			Fail();
+			return;
+		}
+
+		TArray<FTransform> Transforms;
+
+		TArray<FString> ComponentNames;
+		Ar << ComponentNames;
+		for (const FString& ComponentName : ComponentNames)
+		{
+			TBitArray<> Present;
+			Ar << Present;
+			if (Ar.IsError() || Present.Num() != NumFrames)
+			{
+				Fail();
+				return;
+			}
+
+			const ETransformQuantizationMethod Method = bPerTrack ? TrackTable->GetComponentMethod(ComponentName) : QuantOpts;
+			ReadTrack(Ar, Present.CountSetBits(), Method, Transforms);
+			if (Ar.IsError())
+			{
+				Fail();
+				return;
+			}
+
+			int32 SampleIndex = 0;
+			for (TConstSetBitIterator<> It(Present); It; ++It)
+			{
+				Frames[It.GetIndex()].ComponentTransforms.Add(ComponentName, Transforms[SampleIndex++]);
+			}
+		}
+
+		TArray<FString> SkeletalNames;
+		Ar << SkeletalNames;
+		for (const FString& SkeletalName : SkeletalNames)
+		{
+			TBitArray<> Present;
+			TArray<int32> BoneCounts;
+			Ar << Present;
+			Ar << BoneCounts;
+			if (Ar.IsError() || Present.Num() != NumFrames || BoneCounts.Num() != Present.CountSetBits())
+			{
+				Fail();
+				return;
+			}
+
+			// Every bone of this track is filled before the next track adds keys, so the space pointers stay valid
+			TArray<FBoneComponentSpace*> Spaces;
+			Spaces.Reserve(BoneCounts.Num());
+			int32 MaxBoneCount = 0;
+			int32 SpaceIndex = 0;
+			for (TConstSetBitIterator<> It(Present); It; ++It)
+			{
+				const int32 BoneCount = BoneCounts[SpaceIndex++];
+				if (!IsPlausibleCount(Ar, BoneCount))
+				{
+					Fail();
+					return;
+				}
+
+				FBoneComponentSpace& Space = Frames[It.GetIndex()].SkeletalMeshBoneTransforms.Add(SkeletalName);
+				Space.BoneTransforms.Reserve(BoneCount);
+				Spaces.Add(&Space);
+				MaxBoneCount = FMath::Max(MaxBoneCount, BoneCount);
+			}
+
+			for (int32 BoneIndex = 0; BoneIndex < MaxBoneCount; ++BoneIndex)
+			{
+				int32 NumSamples = 0;
+				for (const int32 BoneCount : BoneCounts)
+				{
+					NumSamples += BoneCount > BoneIndex ? 1 : 0;
+				}
+
+				const ETransformQuantizationMethod Method = bPerTrack ? TrackTable->GetBoneMethod(SkeletalName, BoneIndex) : QuantOpts;
+				ReadTrack(Ar, NumSamples, Method, Transforms);
+				if (Ar.IsError())
+				{
+					Fail();
+					return;
+				}
+
+				int32 SampleIndex = 0;
+				for (int32 Index = 0; Index < Spaces.Num(); ++Index)
+				{
+					if (BoneCounts[Index] > BoneIndex)
+					{
+						Spaces[Index]->BoneTransforms.Add(Transforms[SampleIndex++]);
+					}
+				}
+			}
+		}
+
+		if (Ar.IsError())
+		{
+			Fail();
+		}
+	}
+}
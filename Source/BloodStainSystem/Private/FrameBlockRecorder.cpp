@@ -0,0 +1,177 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#include "FrameBlockRecorder.h"
+#include "BloodStainSystem.h"
+#include "Algo/BinarySearch.h"
+
+DECLARE_CYCLE_STAT(TEXT("FrameBlockRecorder Finalize"), STAT_FrameBlockRecorder_Finalize, STATGROUP_BloodStain);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("FrameBlockRecorder InFlightBlocks"), STAT_FrameBlockRecorder_InFlightBlocks, STATGROUP_BloodStain);
+
+FFrameBlockRecorder::FFrameBlockRecorder(int32 InBlockFrameCount, const FBloodStainFileOptions& InFileOptions, const FName& InPrimaryComponentName)
+	: BlockFrameCount(FMath::Max(InBlockFrameCount, 2))
+	, FileOptions(InFileOptions)
+	, PrimaryComponentKey(InPrimaryComponentName.ToString())
+{
+	PendingFrames.Reserve(BlockFrameCount);
+}
+
+void FFrameBlockRecorder::AddFrame(FRecordFrame&& Frame)
+{
+	PendingFrames.Add(MoveTemp(Frame));
+	if (PendingFrames.Num() < BlockFrameCount)
+	{
+		return;
+	}
+
+	// The worker owns the frames from here on; nothing on the recorder is touched off the game thread
+	InFlightBlocks.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION,
+		[Frames = MoveTemp(PendingFrames), Options = FileOptions, Key = PrimaryComponentKey]() mutable
+		{
+			return EncodeFrames(MoveTemp(Frames), Options, Key);
+		}));
+	INC_DWORD_STAT(STAT_FrameBlockRecorder_InFlightBlocks);
+
+	PendingFrames.Reset();
+	PendingFrames.Reserve(BlockFrameCount);
+}
+
+void FFrameBlockRecorder::DiscardBlocksBefore(float MinTimeStamp)
+{
+	CollectFinishedBlocks(false);
+
+	int32 NumToDiscard = 0;
+	while (NumToDiscard < EncodedBlocks.Num() && EncodedBlocks[NumToDiscard].Block.EndTime < MinTimeStamp)
+	{
+		++NumToDiscard;
+	}
+	if (NumToDiscard > 0)
+	{
+		EncodedBlocks.RemoveAt(0, NumToDiscard, EAllowShrinking::No);
+	}
+
+	if (InFlightBlocks.IsEmpty() && EncodedBlocks.IsEmpty() && PendingFrames.Num() > 0 && PendingFrames.Last().TimeStamp < MinTimeStamp)
+	{
+		PendingFrames.Reset();
+	}
+}
+
+bool FFrameBlockRecorder::IsEmpty() const
+{
+	return PendingFrames.IsEmpty() && InFlightBlocks.IsEmpty() && EncodedBlocks.IsEmpty();
+}
+
+bool FFrameBlockRecorder::Finalize(float ClipStartTime, FEncodedActorData& OutActorData, int32& OutFirstFrameIndex)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FrameBlockRecorder_Finalize);
+
+	CollectFinishedBlocks(true);
+
+	// Only the partial tail block is encoded here; its size is bounded by BlockFrameCount
+	if (PendingFrames.Num() > 0)
+	{
+		EncodedBlocks.Add(EncodeFrames(MoveTemp(PendingFrames), FileOptions, PrimaryComponentKey));
+		PendingFrames.Reset();
+	}
+
+	int32 HeadBlockIndex = 0;
+	while (HeadBlockIndex < EncodedBlocks.Num() && EncodedBlocks[HeadBlockIndex].Block.EndTime < ClipStartTime)
+	{
+		++HeadBlockIndex;
+	}
+	if (HeadBlockIndex >= EncodedBlocks.Num())
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("No frames to save"));
+		return false;
+	}
+
+	// A failed background encode falls back to cooking the block now; the save fails only if that fails too
+	for (int32 Index = HeadBlockIndex; Index < EncodedBlocks.Num(); ++Index)
+	{
+		FRecordedBlock& Recorded = EncodedBlocks[Index];
+		if (Recorded.FailedFrames.Num() > 0)
+		{
+			if (!BloodStainBlockUtils::EncodeBlock(Recorded.FailedFrames, FileOptions, Recorded.Block))
+			{
+				UE_LOG(LogBloodStain, Error, TEXT("[BS] FrameBlockRecorder: Failed to encode frames [%.2f, %.2f]"), Recorded.Block.StartTime, Recorded.Block.EndTime);
+				return false;
+			}
+			Recorded.FailedFrames.Empty();
+		}
+	}
+
+	const FEncodedFrameBlock& HeadBlock = EncodedBlocks[HeadBlockIndex].Block;
+	const int32 SkipFrames = Algo::LowerBound(HeadBlock.FrameTimeStamps, ClipStartTime);
+
+	int32 NumFrames = -SkipFrames;
+	for (int32 Index = HeadBlockIndex; Index < EncodedBlocks.Num(); ++Index)
+	{
+		NumFrames += EncodedBlocks[Index].Block.NumFrames;
+	}
+	if (NumFrames < 2)
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("Not enough raw frames to interpolate."));
+		return false;
+	}
+
+	OutFirstFrameIndex = HeadBlock.FirstFrameIndex + SkipFrames;
+	OutActorData.FirstPrimaryTransform = HeadBlock.PrimaryTransforms[SkipFrames];
+	OutActorData.TimeBase = ClipStartTime;
+	OutActorData.SkipFrames = SkipFrames;
+	OutActorData.NumFrames = NumFrames;
+
+	OutActorData.Blocks.Reset(EncodedBlocks.Num() - HeadBlockIndex);
+	for (int32 Index = HeadBlockIndex; Index < EncodedBlocks.Num(); ++Index)
+	{
+		OutActorData.Blocks.Add(MoveTemp(EncodedBlocks[Index].Block));
+	}
+	EncodedBlocks.Reset();
+
+	return true;
+}
+
+void FFrameBlockRecorder::CollectFinishedBlocks(bool bWaitForAll)
+{
+	int32 NumFinished = 0;
+	for (UE::Tasks::TTask<FRecordedBlock>& Task : InFlightBlocks)
+	{
+		if (!bWaitForAll && !Task.IsCompleted())
+		{
+			break;
+		}
+		EncodedBlocks.Add(MoveTemp(Task.GetResult()));
+		++NumFinished;
+	}
+
+	if (NumFinished > 0)
+	{
+		InFlightBlocks.RemoveAt(0, NumFinished, EAllowShrinking::No);
+		DEC_DWORD_STAT_BY(STAT_FrameBlockRecorder_InFlightBlocks, NumFinished);
+	}
+}
+
+FFrameBlockRecorder::FRecordedBlock FFrameBlockRecorder::EncodeFrames(TArray<FRecordFrame>&& Frames, const FBloodStainFileOptions& Options, const FString& PrimaryComponentKey)
+{
+	FRecordedBlock Recorded;
+	FEncodedFrameBlock& Block = Recorded.Block;
+	const bool bEncoded = BloodStainBlockUtils::EncodeBlock(Frames, Options, Block);
+
+	Block.FrameTimeStamps.Reserve(Frames.Num());
+	Block.PrimaryTransforms.Reserve(Frames.Num());
+	for (const FRecordFrame& Frame : Frames)
+	{
+		Block.FrameTimeStamps.Add(Frame.TimeStamp);
+		Block.PrimaryTransforms.Add(Frame.ComponentTransforms.FindRef(PrimaryComponentKey));
+	}
+
+	if (!bEncoded && Frames.Num() > 0)
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BS] FrameBlockRecorder: Background encode failed, keeping %d raw frames for the save"), Frames.Num());
+		Block.StartTime = Frames[0].TimeStamp;
+		Block.EndTime = Frames.Last().TimeStamp;
+		Recorded.FailedFrames = MoveTemp(Frames);
+	}
+	return Recorded;
+}
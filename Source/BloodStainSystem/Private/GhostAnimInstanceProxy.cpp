@@ -28,9 +28,10 @@ bool FGhostAnimInstanceProxy::Evaluate(FPoseContext& Output)
 		{
 			Output.Pose[CompactIndex] = SrcPose[SkeletonIndex];
 		}
-		else
+		else if (Output.Pose.IsValidIndex(CompactIndex))
 		{
-			Output.Pose[CompactIndex] = FTransform::Identity;
+			// Bones missing from the recording (e.g. a reduced low resolution bone set) keep their reference pose
+			Output.Pose[CompactIndex] = Output.Pose.GetRefPose(CompactIndex);
 		}
 	}
 	return true;
@@ -4,7 +4,6 @@
 
 #include "GhostPlayerController.h"
 #include "UObject/ConstructorHelpers.h"
-#include "HAL/PlatformFilemanager.h"
 #include "BloodStainSubsystem.h"
 #include "BloodStainSystem.h"
 #include "Kismet/KismetMathLibrary.h"
@@ -53,9 +52,9 @@ void AGhostPlayerController::Tick(float DeltaSeconds)
 
     if (bIsUploading)
     {
-        if (!UploadFileHandle)
+        if (UploadBytes.Num() != TotalFileSize)
         {
-            UE_LOG(LogBloodStain, Error, TEXT("Upload stopped: File handle is invalid."));
+            UE_LOG(LogBloodStain, Error, TEXT("Upload stopped: File buffer is invalid."));
             bIsUploading = false;
             return;
         }
@@ -102,24 +101,12 @@ void AGhostPlayerController::Tick(float DeltaSeconds)
         		break;
         	}
         	
-        	TArray<uint8> ChunkBuffer;
-        	ChunkBuffer.SetNumUninitialized(BytesToRead);
-        	
-        	if (UploadFileHandle->Read(ChunkBuffer.GetData(), BytesToRead))
-        	{
-        		Server_SendFileChunk(ChunkBuffer);
-                
-        		BytesSent += BytesToRead;
-        		BytesSentThisFrame += BytesToRead;
-        		ChunksSentThisFrame++;
-        	}
-            else
-            {
-                UE_LOG(LogBloodStain, Error, TEXT("Failed to read chunk from file %s. Aborting upload."), *UploadFilePath);
-                bIsUploading = false;
-                UploadFileHandle.Reset();
-                return;
-            }
+        	TArray<uint8> ChunkBuffer(UploadBytes.GetData() + BytesSent, static_cast<int32>(BytesToRead));
+        	Server_SendFileChunk(ChunkBuffer);
+
+        	BytesSent += BytesToRead;
+        	BytesSentThisFrame += BytesToRead;
+        	ChunksSentThisFrame++;
         }
 
     	// If we sent any bytes this frame, reset the accumulated tick time
@@ -140,13 +127,13 @@ void AGhostPlayerController::Tick(float DeltaSeconds)
         {
             UE_LOG(LogBloodStain, Log, TEXT("File upload completed for %s."), *UploadHeader.FileName.ToString());
             bIsUploading = false;
-            UploadFileHandle.Reset();
+            UploadBytes.Empty();
             Server_EndFileUpload();
         }
     }
 }
 
-void AGhostPlayerController::StartFileUpload(const FString& FilePath, const FRecordHeaderData& Header)
+void AGhostPlayerController::StartFileUpload(TArray<uint8>&& FileBytes, const FRecordHeaderData& Header)
 {
 	if (GetLocalRole() != ENetRole::ROLE_AutonomousProxy)
 	{
@@ -160,16 +147,15 @@ void AGhostPlayerController::StartFileUpload(const FString& FilePath, const FRec
 		return;
 	}
 
-	UploadFileHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*FilePath));
-	if (!UploadFileHandle)
+	if (FileBytes.Num() == 0)
 	{
-		UE_LOG(LogBloodStain, Error, TEXT("Failed to open file for upload: %s"), *FilePath);
+		UE_LOG(LogBloodStain, Error, TEXT("Nothing to upload for %s."), *Header.FileName.ToString());
 		return;
 	}
 
-	TotalFileSize = UploadFileHandle->Size();
+	UploadBytes = MoveTemp(FileBytes);
+	TotalFileSize = UploadBytes.Num();
 	BytesSent = 0;
-	UploadFilePath = FilePath;
 	UploadHeader = Header;
 
 	// Notify the server to begin the upload process
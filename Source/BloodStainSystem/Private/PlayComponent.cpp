@@ -5,11 +5,14 @@
 
 
 #include "PlayComponent.h"
+#include "BloodStainRecordDataUtils.h"
 #include "BloodStainSubsystem.h"
 #include "BloodStainSystem.h"
 #include "ReplayActor.h"
 #include "Engine/World.h"
 #include "Engine/GameInstance.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
 #include "Engine/StaticMesh.h"
 #include "Engine/SkeletalMesh.h"
 #include "UObject/UObjectGlobals.h"
@@ -52,6 +55,7 @@ void UPlayComponent::Initialize(FGuid InPlaybackKey, const FRecordHeaderData& In
 
     PlaybackStartTime = GetWorld()->GetTimeSeconds();
     CurrentFrame      = PlaybackOptions.PlaybackRate > 0 ? 0 : ReplayData.RecordedFrames.Num() - 2;
+	UniformFrameInterval = BloodStainRecordDataUtils::FindUniformFrameInterval(ReplayData.RecordedFrames);
 
 	TSet<FString> UniqueAssetPaths;
 	for (const FComponentActiveInterval& Interval : ReplayData.ComponentIntervals)
@@ -135,6 +139,25 @@ void UPlayComponent::Initialize(FGuid InPlaybackKey, const FRecordHeaderData& In
 		}
 	}
 	
+	RebuildIntervalTree();
+	SeekFrame(0);
+
+	SetComponentTickEnabled(true);
+}
+
+void UPlayComponent::UpgradeReplayData(const FRecordActorSaveData& InReplayData)
+{
+	ReplayData = InReplayData;
+	UniformFrameInterval = BloodStainRecordDataUtils::FindUniformFrameInterval(ReplayData.RecordedFrames);
+	bIsLowResolution = false;
+
+	// Frame indices changed meaning; force the next update to seek
+	RebuildIntervalTree();
+	CurrentFrame = INDEX_NONE;
+}
+
+void UPlayComponent::RebuildIntervalTree()
+{
 	// Initialize the Interval Tree for querying active components at a specific point(frame) in time.
 	TArray<FComponentActiveInterval*> Ptrs;
 	for (FComponentActiveInterval& I : ReplayData.ComponentIntervals)
@@ -143,9 +166,24 @@ void UPlayComponent::Initialize(FGuid InPlaybackKey, const FRecordHeaderData& In
 		Ptrs.Add(&I);			
 	}
 	IntervalRoot = BuildIntervalTree(Ptrs);
-	SeekFrame(0);
+}
 
-	SetComponentTickEnabled(true);
+bool UPlayComponent::ShouldUpgradeResolution() const
+{
+	if (!bIsLowResolution || bFullResolutionRequested || PlaybackOptions.FullResolutionDistance <= 0.f)
+	{
+		return false;
+	}
+
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (!PlayerController || !PlayerController->PlayerCameraManager)
+	{
+		return false;
+	}
+
+	const USceneComponent* PrimaryComponent = ReconstructedComponents.FindRef(ReplayData.PrimaryComponentName.ToString());
+	const FVector GhostLocation = PrimaryComponent ? PrimaryComponent->GetComponentLocation() : GetOwner()->GetActorLocation();
+	return FVector::DistSquared(GhostLocation, PlayerController->PlayerCameraManager->GetCameraLocation()) <= FMath::Square(PlaybackOptions.FullResolutionDistance);
 }
 
 void UPlayComponent::FinishReplay() const
@@ -209,6 +247,17 @@ bool UPlayComponent::CalculatePlaybackTime(float& OutElapsedTime)
 
 void UPlayComponent::UpdatePlaybackToTime(float ElapsedTime)
 {
+	if (ShouldUpgradeResolution())
+	{
+		// Upgrades the whole group, this component included, once its full data has loaded in the background.
+		// Asked once; until then, or on failure, playback stays on the tier
+		bFullResolutionRequested = true;
+		if (UBloodStainSubsystem* Sub = GetWorld()->GetGameInstance()->GetSubsystem<UBloodStainSubsystem>())
+		{
+			Sub->UpgradeReplayToFullResolution(PlaybackKey);
+		}
+	}
+
 	const TArray<FRecordFrame>& Frames = ReplayData.RecordedFrames;
 	constexpr int32 MinFramesRequired = 2;
 	if (Frames.Num() < MinFramesRequired)
@@ -228,13 +277,7 @@ void UPlayComponent::UpdatePlaybackToTime(float ElapsedTime)
 
 	const int32 PreviousFrame = CurrentFrame;
 
-	// Find the correct frame index for the current time using a binary search.
-	const int32 UpperBoundIndex = Algo::UpperBoundBy(Frames, ElapsedTime, [](const FRecordFrame& Frame) {
-		return Frame.TimeStamp;
-	});
-	const int32 NewFrameIndex = FMath::Clamp(UpperBoundIndex - 1, 0, Frames.Num() - 2);
-	
-	CurrentFrame = NewFrameIndex;
+	CurrentFrame = FindFrameAtTime(ElapsedTime);
 	if (PreviousFrame != CurrentFrame)
 	{
 		// Only handle component activation/deactivation when the frame index changes.
@@ -254,6 +297,35 @@ void UPlayComponent::UpdatePlaybackToTime(float ElapsedTime)
 	ApplySkeletalBoneTransforms(Prev, Next, Alpha);
 }
 
+int32 UPlayComponent::FindFrameAtTime(float ElapsedTime) const
+{
+	const TArray<FRecordFrame>& Frames = ReplayData.RecordedFrames;
+
+	int32 FrameIndex;
+	if (UniformFrameInterval > 0.f)
+	{
+		// Evenly spaced frames: index arithmetic, then step over the frame boundary float rounding may have missed.
+		FrameIndex = FMath::Clamp(FMath::FloorToInt32((ElapsedTime - Frames[0].TimeStamp) / UniformFrameInterval), 0, Frames.Num() - 1);
+		while (FrameIndex > 0 && Frames[FrameIndex].TimeStamp > ElapsedTime)
+		{
+			--FrameIndex;
+		}
+		while (FrameIndex + 1 < Frames.Num() && Frames[FrameIndex + 1].TimeStamp <= ElapsedTime)
+		{
+			++FrameIndex;
+		}
+	}
+	else
+	{
+		// Find the correct frame index for the current time using a binary search.
+		FrameIndex = Algo::UpperBoundBy(Frames, ElapsedTime, [](const FRecordFrame& Frame) {
+			return Frame.TimeStamp;
+		}) - 1;
+	}
+
+	return FMath::Clamp(FrameIndex, 0, Frames.Num() - 2);
+}
+
 void UPlayComponent::ApplyMaterial(UMaterialInterface* InMaterial) const
 {
 	AActor* Owner = GetOwner();
@@ -6,215 +6,734 @@
 #include "BloodStainFileUtils.h"
 #include "BloodStainFileOptions.h"
 #include "QuantizationTypes.h"
+#include "UObject/ObjectVersion.h"
 
 namespace BloodStainFileUtils_Internal
 {
 
-void ComputeRanges(FRecordSaveData& SaveData)
+void ComputeRanges(TConstArrayView<FRecordFrame> Frames, FActorTransformRanges& OutRanges)
 {
-    for (FRecordActorSaveData& ActorData : SaveData.RecordActorDataArray)
+    OutRanges.BoneRanges.Empty();
+    OutRanges.BoneScaleRanges.Empty();
+    OutRanges.ComponentRanges = FLocRange();
+    OutRanges.ComponentScaleRanges = FScaleRange();
+    bool bIsComponentRangeInitialized = false;
+
+    // Keys whose ranges hold a real sample; a range may legitimately contain the origin, so zero is no sentinel
+    TSet<FString> SeededBoneKeys;
+    for (const FRecordFrame& Frame : Frames)
     {
-        ActorData.BoneRanges.Empty();
-        ActorData.BoneScaleRanges.Empty();
-        ActorData.ComponentRanges = FLocRange();
-        bool bIsComponentRangeInitialized  = false;
-        bool bIsComponentScaleRangeInitialized = false; 
-        for (const FRecordFrame& Frame : ActorData.RecordedFrames)
+        for (const auto& Pair : Frame.SkeletalMeshBoneTransforms)
         {
-            for (const auto& Pair : Frame.SkeletalMeshBoneTransforms)
+            const FString& BoneKey = Pair.Key;
+            const FBoneComponentSpace& Space = Pair.Value;
+            FLocRange& R = OutRanges.BoneRanges.FindOrAdd(BoneKey);
+            FScaleRange& ScaleRange = OutRanges.BoneScaleRanges.FindOrAdd(BoneKey);
+            if (Space.BoneTransforms.Num() == 0)
             {
-                const FString& BoneKey = Pair.Key;
-                const FBoneComponentSpace& Space = Pair.Value;
-                FLocRange& R = ActorData.BoneRanges.FindOrAdd(BoneKey);
-                FScaleRange& ScaleRange = ActorData.BoneScaleRanges.FindOrAdd(BoneKey);
-
-                bool bIsFirst = (R.PosMin.IsNearlyZero() && R.PosMax.IsNearlyZero());
-                if (bIsFirst && Space.BoneTransforms.Num() > 0)
-                {
-                    R.PosMin = R.PosMax = Space.BoneTransforms[0].GetLocation();
-                }
+                continue;
+            }
 
-                for (const FTransform& BoneT : Space.BoneTransforms)
-                {
-                    const FVector Loc = BoneT.GetLocation();
-                    R.PosMin = R.PosMin.ComponentMin(Loc);
-                    R.PosMax = R.PosMax.ComponentMax(Loc);
-                }
-                
-                bool bIsFirstScale = (ScaleRange.ScaleMin.IsNearlyZero() && ScaleRange.ScaleMax.IsNearlyZero());
+            if (!SeededBoneKeys.Contains(BoneKey))
+            {
+                SeededBoneKeys.Add(BoneKey);
+                R.PosMin = R.PosMax = Space.BoneTransforms[0].GetLocation();
+                ScaleRange.ScaleMin = ScaleRange.ScaleMax = Space.BoneTransforms[0].GetScale3D();
+            }
 
-                if (bIsFirstScale && Space.BoneTransforms.Num() > 0)
-                {
-                    ScaleRange.ScaleMin = ScaleRange.ScaleMax = Space.BoneTransforms[0].GetScale3D();
-                }
+            for (const FTransform& BoneT : Space.BoneTransforms)
+            {
+                const FVector Loc = BoneT.GetLocation();
+                const FVector Scale = BoneT.GetScale3D();
+                R.PosMin = R.PosMin.ComponentMin(Loc);
+                R.PosMax = R.PosMax.ComponentMax(Loc);
+                ScaleRange.ScaleMin = ScaleRange.ScaleMin.ComponentMin(Scale);
+                ScaleRange.ScaleMax = ScaleRange.ScaleMax.ComponentMax(Scale);
+            }
+        }
+        
+        for (const auto& Pair : Frame.ComponentTransforms)
+        {
+            const FTransform& ComponentT = Pair.Value;
+            const FVector Loc = ComponentT.GetLocation();
+            const FVector Scale = ComponentT.GetScale3D();
 
-                for (const FTransform& BoneT : Space.BoneTransforms)
-                {
-                    const FVector Scale = BoneT.GetScale3D();
-                    ScaleRange.ScaleMin = ScaleRange.ScaleMin.ComponentMin(Scale);
-                    ScaleRange.ScaleMax = ScaleRange.ScaleMax.ComponentMax(Scale);
-                }
+            if (!bIsComponentRangeInitialized)
+            {
+                OutRanges.ComponentRanges.PosMin = OutRanges.ComponentRanges.PosMax = Loc;
+                OutRanges.ComponentScaleRanges.ScaleMin = OutRanges.ComponentScaleRanges.ScaleMax = Scale;
+                bIsComponentRangeInitialized = true;
             }
-            
-            for (const auto& Pair : Frame.ComponentTransforms)
+            else
             {
-                const FTransform& ComponentT = Pair.Value;
-                const FVector Loc = ComponentT.GetLocation();
-                const FVector Scale = ComponentT.GetScale3D();
-
-                if (!bIsComponentRangeInitialized)
-                {
-                    ActorData.ComponentRanges.PosMin = ActorData.ComponentRanges.PosMax = Loc;
-                    bIsComponentRangeInitialized = true;
-                }
-                else
-                {
-                    ActorData.ComponentRanges.PosMin = ActorData.ComponentRanges.PosMin.ComponentMin(Loc);
-                    ActorData.ComponentRanges.PosMax = ActorData.ComponentRanges.PosMax.ComponentMax(Loc);
-                }
-
-                if (!bIsComponentScaleRangeInitialized)
-                {
-                    ActorData.ComponentScaleRanges.ScaleMin = ActorData.ComponentScaleRanges.ScaleMax = Scale;
-                    bIsComponentScaleRangeInitialized = true;
-                }
-                else
-                {
-                    ActorData.ComponentScaleRanges.ScaleMin = ActorData.ComponentScaleRanges.ScaleMin.ComponentMin(Scale);
-                    ActorData.ComponentScaleRanges.ScaleMax = ActorData.ComponentScaleRanges.ScaleMax.ComponentMax(Scale);
-                }
+                OutRanges.ComponentRanges.PosMin = OutRanges.ComponentRanges.PosMin.ComponentMin(Loc);
+                OutRanges.ComponentRanges.PosMax = OutRanges.ComponentRanges.PosMax.ComponentMax(Loc);
+                OutRanges.ComponentScaleRanges.ScaleMin = OutRanges.ComponentScaleRanges.ScaleMin.ComponentMin(Scale);
+                OutRanges.ComponentScaleRanges.ScaleMax = OutRanges.ComponentScaleRanges.ScaleMax.ComponentMax(Scale);
             }
         }
     }
-    
 }
-void SerializeQuantizedTransform(FArchive& Ar, const FTransform& Transform, const ETransformQuantizationMethod& QuantOpts, const FLocRange* LocRange, const FScaleRange* ScaleRange)
+
+void ComputeTrackRanges(TConstArrayView<const FTransform*> Samples, FLocRange& OutLocRange, FScaleRange& OutScaleRange)
 {
-    switch (QuantOpts)
+    OutLocRange = FLocRange();
+    OutScaleRange = FScaleRange();
+    if (Samples.Num() == 0)
+    {
+        return;
+    }
+
+    FVector3f PosMin(Samples[0]->GetLocation());
+    FVector3f PosMax = PosMin;
+    FVector3f ScaleMin(Samples[0]->GetScale3D());
+    FVector3f ScaleMax = ScaleMin;
+    for (const FTransform* Sample : Samples)
+    {
+        const FVector3f Loc(Sample->GetLocation());
+        const FVector3f Scale(Sample->GetScale3D());
+        PosMin = PosMin.ComponentMin(Loc);
+        PosMax = PosMax.ComponentMax(Loc);
+        ScaleMin = ScaleMin.ComponentMin(Scale);
+        ScaleMax = ScaleMax.ComponentMax(Scale);
+    }
+
+    // Float bounds are what gets stored, so the writer quantizes against exactly what the reader will see
+    OutLocRange.PosMin = FVector(PosMin);
+    OutLocRange.PosMax = FVector(PosMax);
+    OutScaleRange.ScaleMin = FVector(ScaleMin);
+    OutScaleRange.ScaleMax = FVector(ScaleMax);
+}
+
+void ComputeRanges(FRecordSaveData& SaveData)
+{
+    for (FRecordActorSaveData& ActorData : SaveData.RecordActorDataArray)
+    {
+        FActorTransformRanges Ranges;
+        ComputeRanges(ActorData.RecordedFrames, Ranges);
+
+        ActorData.ComponentRanges = Ranges.ComponentRanges;
+        ActorData.ComponentScaleRanges = Ranges.ComponentScaleRanges;
+        ActorData.BoneRanges = MoveTemp(Ranges.BoneRanges);
+        ActorData.BoneScaleRanges = MoveTemp(Ranges.BoneScaleRanges);
+    }
+}
+
+namespace
+{
+    void SerializeTransform(FArchive& Ar, const FTransform& Transform, ETransformQuantizationMethod QuantOpts, const FTrackQuantizationParams& Params)
+    {
+        switch (QuantOpts)
+        {
+        case ETransformQuantizationMethod::Standard_High:
+            {
+                FQuantizedTransform_High Q(Transform);
+                Ar << Q;
+            }
+            break;
+        case ETransformQuantizationMethod::Standard_Medium:
+            {
+                FQuantizedTransform_Compact Q(Transform);
+                Ar << Q;
+            }
+            break;
+        case ETransformQuantizationMethod::Standard_SmallestThree:
+            {
+                FQuantizedTransform_SmallestThree Q(Transform, FQuatSmallestThree::DefaultBits);
+                Ar << Q;
+            }
+            break;
+        case ETransformQuantizationMethod::Standard_Low:
+            {
+                FQuantizedTransform_Lowest Q(Transform, Params.Lowest);
+                Ar << Q;
+                break;
+            }
+        case ETransformQuantizationMethod::None:
+        default:
+            {
+                /** Basic Serialization for FTransform By Default */
+                FTransform NonConstT = Transform;
+                Ar << NonConstT;
+            }
+        }
+    }
+
+    FTransform DeserializeTransform(FArchive& Ar, ETransformQuantizationMethod QuantOpts, const FTrackQuantizationParams& Params)
     {
-    case ETransformQuantizationMethod::Standard_High:
+        switch (QuantOpts)
         {
-            FQuantizedTransform_High Q(Transform);
-            Ar << Q;
+        case ETransformQuantizationMethod::Standard_High:
+            {
+                FQuantizedTransform_High Q;
+                Ar << Q;
+                return Q.ToTransform();
+            }
+        case ETransformQuantizationMethod::Standard_Medium:
+            {
+                FQuantizedTransform_Compact Q;
+                Ar << Q;
+                return Q.ToTransform();
+            }
+        case ETransformQuantizationMethod::Standard_SmallestThree:
+            {
+                FQuantizedTransform_SmallestThree Q;
+                Ar << Q;
+                return Q.ToTransform();
+            }
+        case ETransformQuantizationMethod::Standard_Low:
+            {
+                FQuantizedTransform_Lowest Q;
+                Ar << Q;
+                return Q.ToTransform(Params.Lowest);
+            }
+        default:
+            {
+                FTransform T;
+                Ar << T;
+                return T;
+            }
         }
-        break;
-    case ETransformQuantizationMethod::Standard_Medium:
+    }
+
+    template<typename ValueType>
+    FORCEINLINE void WriteRaw(uint8*& Cursor, const ValueType& Value)
+    {
+        FMemory::Memcpy(Cursor, &Value, sizeof(ValueType));
+        Cursor += sizeof(ValueType);
+    }
+
+    template<typename ValueType>
+    FORCEINLINE void ReadRaw(const uint8*& Cursor, ValueType& Value)
+    {
+        FMemory::Memcpy(&Value, Cursor, sizeof(ValueType));
+        Cursor += sizeof(ValueType);
+    }
+
+    FORCEINLINE void WriteRawVector(uint8*& Cursor, const FVector& V)
+    {
+        WriteRaw(Cursor, V.X);
+        WriteRaw(Cursor, V.Y);
+        WriteRaw(Cursor, V.Z);
+    }
+
+    FORCEINLINE void ReadRawVector(const uint8*& Cursor, FVector& V)
+    {
+        ReadRaw(Cursor, V.X);
+        ReadRaw(Cursor, V.Y);
+        ReadRaw(Cursor, V.Z);
+    }
+
+    /**
+     * Byte layout of a quantized type in the row layout, identical to its operator<< on an archive that
+     * does not swap bytes and stores FVector as doubles (see CanUseRawRows). Lets a skeletal component's bones
+     * be quantized into one buffer and handed to the archive in a single call.
+     */
+    template<typename QuantType>
+    struct TRowLayout;
+
+    template<>
+    struct TRowLayout<FQuantizedTransform_High>
+    {
+        static constexpr int32 Size = 24 + 6 + 24;
+
+        static FORCEINLINE void Write(uint8*& Cursor, const FQuantizedTransform_High& Q)
         {
-            FQuantizedTransform_Compact Q(Transform);
-            Ar << Q;
+            WriteRawVector(Cursor, Q.Location);
+            WriteRaw(Cursor, Q.Rotation.X);
+            WriteRaw(Cursor, Q.Rotation.Y);
+            WriteRaw(Cursor, Q.Rotation.Z);
+            WriteRawVector(Cursor, Q.Scale);
         }
-        break;
-    case ETransformQuantizationMethod::Standard_Low:
+
+        static FORCEINLINE void Read(const uint8*& Cursor, FQuantizedTransform_High& Q)
         {
-            /** Only use Location / Scale Range if Quantization Option is Standard_Low */
-            FQuantizedTransform_Lowest Q(Transform, *LocRange, *ScaleRange);
-            Ar << Q;
-            break;
+            ReadRawVector(Cursor, Q.Location);
+            ReadRaw(Cursor, Q.Rotation.X);
+            ReadRaw(Cursor, Q.Rotation.Y);
+            ReadRaw(Cursor, Q.Rotation.Z);
+            ReadRawVector(Cursor, Q.Scale);
+        }
+    };
+
+    template<>
+    struct TRowLayout<FQuantizedTransform_Compact>
+    {
+        static constexpr int32 Size = 24 + 4 + 24;
+
+        static FORCEINLINE void Write(uint8*& Cursor, const FQuantizedTransform_Compact& Q)
+        {
+            WriteRawVector(Cursor, Q.Location);
+            WriteRaw(Cursor, Q.Rotation.Packed);
+            WriteRawVector(Cursor, Q.Scale);
+        }
+
+        static FORCEINLINE void Read(const uint8*& Cursor, FQuantizedTransform_Compact& Q)
+        {
+            ReadRawVector(Cursor, Q.Location);
+            ReadRaw(Cursor, Q.Rotation.Packed);
+            ReadRawVector(Cursor, Q.Scale);
+        }
+    };
+
+    template<>
+    struct TRowLayout<FQuantizedTransform_SmallestThree>
+    {
+        static constexpr int32 Size = 24 + 1 + 6 + 24;
+
+        static FORCEINLINE void Write(uint8*& Cursor, const FQuantizedTransform_SmallestThree& Q)
+        {
+            WriteRawVector(Cursor, Q.Location);
+            WriteRaw(Cursor, static_cast<uint8>((Q.Rotation.LargestIndex << 6) | (Q.Rotation.BitsPerComponent & 0x3F)));
+            WriteRaw(Cursor, Q.Rotation.Components);
+            WriteRawVector(Cursor, Q.Scale);
+        }
+
+        static FORCEINLINE void Read(const uint8*& Cursor, FQuantizedTransform_SmallestThree& Q)
+        {
+            uint8 Packed = 0;
+            ReadRawVector(Cursor, Q.Location);
+            ReadRaw(Cursor, Packed);
+            Q.Rotation.LargestIndex = Packed >> 6;
+            Q.Rotation.BitsPerComponent = static_cast<uint8>(FMath::Clamp<int32>(Packed & 0x3F, FQuatSmallestThree::MinBits, FQuatSmallestThree::MaxBits));
+            ReadRaw(Cursor, Q.Rotation.Components);
+            ReadRawVector(Cursor, Q.Scale);
+        }
+    };
+
+    template<>
+    struct TRowLayout<FQuantizedTransform_Lowest>
+    {
+        static constexpr int32 Size = 4 + 4 + 4;
+
+        static FORCEINLINE void Write(uint8*& Cursor, const FQuantizedTransform_Lowest& Q)
+        {
+            WriteRaw(Cursor, Q.Translation.Packed);
+            WriteRaw(Cursor, Q.Rotation.Packed);
+            WriteRaw(Cursor, Q.Scale.Packed);
+        }
+
+        static FORCEINLINE void Read(const uint8*& Cursor, FQuantizedTransform_Lowest& Q)
+        {
+            ReadRaw(Cursor, Q.Translation.Packed);
+            ReadRaw(Cursor, Q.Rotation.Packed);
+            ReadRaw(Cursor, Q.Scale.Packed);
+        }
+    };
+
+    /** @return true if TRowLayout matches what operator<< would write to or read from Ar */
+    bool CanUseRawRows(const FArchive& Ar)
+    {
+        return !Ar.IsByteSwapping() && Ar.UEVer() >= EUnrealEngineObjectUE5Version::LARGE_WORLD_COORDINATES;
+    }
+
+    template<typename QuantType>
+    void WriteRows(FArchive& Ar, TConstArrayView<FTransform> Transforms, const FTrackQuantizationParams& Params, TArray<uint8>& Scratch)
+    {
+        Scratch.SetNumUninitialized(Transforms.Num() * TRowLayout<QuantType>::Size, EAllowShrinking::No);
+        uint8* Cursor = Scratch.GetData();
+        for (const FTransform& Transform : Transforms)
+        {
+            TRowLayout<QuantType>::Write(Cursor, TQuantizationKernel<QuantType>::Quantize(Transform, Params));
+        }
+        Ar.Serialize(Scratch.GetData(), Scratch.Num());
+    }
+
+    template<typename QuantType>
+    void ReadRows(FArchive& Ar, int32 Count, const FTrackQuantizationParams& Params, TArray<uint8>& Scratch, TArray<FTransform>& OutTransforms)
+    {
+        const int64 Size = static_cast<int64>(Count) * TRowLayout<QuantType>::Size;
+        if (Count < 0 || (Ar.TotalSize() >= 0 && Size > Ar.TotalSize() - Ar.Tell()))
+        {
+            Ar.SetError();
+            return;
         }
-    case ETransformQuantizationMethod::None:
-    default:
+
+        Scratch.SetNumUninitialized(static_cast<int32>(Size), EAllowShrinking::No);
+        Ar.Serialize(Scratch.GetData(), Scratch.Num());
+        if (Ar.IsError())
+        {
+            return;
+        }
+
+        TArray<QuantType> Quantized;
+        Quantized.SetNum(Count);
+        const uint8* Cursor = Scratch.GetData();
+        for (QuantType& Q : Quantized)
         {
-            /** Basic Serialization for FTransform By Default */
-            FTransform NonConstT = Transform;
-            Ar << NonConstT;
+            TRowLayout<QuantType>::Read(Cursor, Q);
         }
+        DequantizeTrack<QuantType>(Quantized, Params, OutTransforms);
     }
+
+    /**
+     * Writes a run of transforms sharing one quantized method through TRowLayout, dispatching on the method once.
+     * @return false if the method or the archive has no raw row layout; nothing is written then
+     */
+    bool WriteRawRows(FArchive& Ar, TConstArrayView<FTransform> Transforms, ETransformQuantizationMethod Method, const FTrackQuantizationParams& Params, TArray<uint8>& Scratch)
+    {
+        if (!CanUseRawRows(Ar))
+        {
+            return false;
+        }
+
+        switch (Method)
+        {
+        case ETransformQuantizationMethod::Standard_High:
+            WriteRows<FQuantizedTransform_High>(Ar, Transforms, Params, Scratch);
+            return true;
+        case ETransformQuantizationMethod::Standard_Medium:
+            WriteRows<FQuantizedTransform_Compact>(Ar, Transforms, Params, Scratch);
+            return true;
+        case ETransformQuantizationMethod::Standard_SmallestThree:
+            WriteRows<FQuantizedTransform_SmallestThree>(Ar, Transforms, Params, Scratch);
+            return true;
+        case ETransformQuantizationMethod::Standard_Low:
+            WriteRows<FQuantizedTransform_Lowest>(Ar, Transforms, Params, Scratch);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /** Reading counterpart of WriteRawRows. @return false if nothing was read */
+    bool ReadRawRows(FArchive& Ar, int32 Count, ETransformQuantizationMethod Method, const FTrackQuantizationParams& Params, TArray<uint8>& Scratch, TArray<FTransform>& OutTransforms)
+    {
+        if (!CanUseRawRows(Ar))
+        {
+            return false;
+        }
+
+        switch (Method)
+        {
+        case ETransformQuantizationMethod::Standard_High:
+            ReadRows<FQuantizedTransform_High>(Ar, Count, Params, Scratch, OutTransforms);
+            return true;
+        case ETransformQuantizationMethod::Standard_Medium:
+            ReadRows<FQuantizedTransform_Compact>(Ar, Count, Params, Scratch, OutTransforms);
+            return true;
+        case ETransformQuantizationMethod::Standard_SmallestThree:
+            ReadRows<FQuantizedTransform_SmallestThree>(Ar, Count, Params, Scratch, OutTransforms);
+            return true;
+        case ETransformQuantizationMethod::Standard_Low:
+            ReadRows<FQuantizedTransform_Lowest>(Ar, Count, Params, Scratch, OutTransforms);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /** Params of every skeletal component's shared bone range, built once per run of frames */
+    TMap<FString, FTrackQuantizationParams> MakeBoneParams(const FActorTransformRanges& Ranges, int32 SmallestThreeBits = FQuatSmallestThree::DefaultBits)
+    {
+        TMap<FString, FTrackQuantizationParams> BoneParams;
+        BoneParams.Reserve(Ranges.BoneRanges.Num());
+        for (const TPair<FString, FLocRange>& Pair : Ranges.BoneRanges)
+        {
+            BoneParams.Add(Pair.Key, FTrackQuantizationParams(&Pair.Value, Ranges.BoneScaleRanges.Find(Pair.Key), SmallestThreeBits));
+        }
+        return BoneParams;
+    }
+}
+
+void SerializeQuantizedTransform(FArchive& Ar, const FTransform& Transform, const ETransformQuantizationMethod& QuantOpts, const FLocRange* LocRange, const FScaleRange* ScaleRange)
+{
+    SerializeTransform(Ar, Transform, QuantOpts, QuantOpts == ETransformQuantizationMethod::Standard_Low ? FTrackQuantizationParams(LocRange, ScaleRange) : FTrackQuantizationParams());
 }
 
 FTransform DeserializeQuantizedTransform(FArchive& Ar, const ETransformQuantizationMethod& Opts, const FLocRange* LocRange, const FScaleRange* ScaleRange)
 {
-    switch (Opts)
+    return DeserializeTransform(Ar, Opts, Opts == ETransformQuantizationMethod::Standard_Low ? FTrackQuantizationParams(LocRange, ScaleRange) : FTrackQuantizationParams());
+}
+
+namespace
+{
+    /** Fixed methods tried by 'Auto', cheapest serialized size first */
+    constexpr ETransformQuantizationMethod AutoCandidates[] =
     {
-    case ETransformQuantizationMethod::Standard_High:
+        ETransformQuantizationMethod::Standard_Low,
+        ETransformQuantizationMethod::Standard_SmallestThree,
+        ETransformQuantizationMethod::Standard_Medium,
+        ETransformQuantizationMethod::Standard_High
+    };
+
+    /** @return true if every sample of the track survives a round trip through QuantType within the budget */
+    template<typename QuantType>
+    bool IsTrackWithinBudget(TConstArrayView<const FTransform*> Samples, const FTrackQuantizationParams& Params, float MaxPositionErrorSq, float MinRotationDot)
+    {
+        constexpr float MaxScaleError = 0.01f;
+
+        for (const FTransform* Sample : Samples)
         {
-            FQuantizedTransform_High Q;
-            Ar << Q;
-            return Q.ToTransform();
+            const FTransform Decoded = TQuantizationKernel<QuantType>::Dequantize(TQuantizationKernel<QuantType>::Quantize(*Sample, Params), Params);
+            if (FVector::DistSquared(Decoded.GetLocation(), Sample->GetLocation()) > MaxPositionErrorSq
+                || FMath::Abs(Decoded.GetRotation() | Sample->GetRotation()) < MinRotationDot
+                || FVector::DistSquared(Decoded.GetScale3D(), Sample->GetScale3D()) > MaxScaleError * MaxScaleError)
+            {
+                return false;
+            }
         }
-    case ETransformQuantizationMethod::Standard_Medium:
+        return true;
+    }
+
+    ETransformQuantizationMethod ChooseTrackMethod(TConstArrayView<const FTransform*> Samples, const FLocRange* LocRange, const FScaleRange* ScaleRange, float MaxPositionErrorSq, float MinRotationDot, int32 SmallestThreeBits)
+    {
+        const FTrackQuantizationParams Params(LocRange, ScaleRange, SmallestThreeBits);
+
+        for (const ETransformQuantizationMethod Method : AutoCandidates)
         {
-            FQuantizedTransform_Compact Q;
-            Ar << Q;
-            return Q.ToTransform();
+            bool bWithinBudget = false;
+            switch (Method)
+            {
+            case ETransformQuantizationMethod::Standard_Low:
+                bWithinBudget = LocRange && ScaleRange && IsTrackWithinBudget<FQuantizedTransform_Lowest>(Samples, Params, MaxPositionErrorSq, MinRotationDot);
+                break;
+            case ETransformQuantizationMethod::Standard_SmallestThree:
+                bWithinBudget = IsTrackWithinBudget<FQuantizedTransform_SmallestThree>(Samples, Params, MaxPositionErrorSq, MinRotationDot);
+                break;
+            case ETransformQuantizationMethod::Standard_Medium:
+                bWithinBudget = IsTrackWithinBudget<FQuantizedTransform_Compact>(Samples, Params, MaxPositionErrorSq, MinRotationDot);
+                break;
+            case ETransformQuantizationMethod::Standard_High:
+                bWithinBudget = IsTrackWithinBudget<FQuantizedTransform_High>(Samples, Params, MaxPositionErrorSq, MinRotationDot);
+                break;
+            default:
+                break;
+            }
+
+            if (bWithinBudget)
+            {
+                return Method;
+            }
         }
-    case ETransformQuantizationMethod::Standard_Low:
+        return ETransformQuantizationMethod::None;
+    }
+}
+
+void ChooseTrackQuantization(TConstArrayView<FRecordFrame> Frames, const FActorTransformRanges* Ranges, float MaxPositionError, float MaxRotationError, int32 SmallestThreeBits, FTrackQuantizationTable& OutTable)
+{
+    OutTable.ComponentMethods.Reset();
+    OutTable.BoneMethods.Reset();
+
+    const float MaxPositionErrorSq = FMath::Square(FMath::Max(MaxPositionError, 0.f));
+    // |q1 . q2| = cos(angle / 2)
+    const float MinRotationDot = FMath::Cos(FMath::DegreesToRadians(FMath::Max(MaxRotationError, 0.f)) * 0.5f);
+
+    TMap<FString, TArray<const FTransform*>> ComponentSamples;
+    TMap<FString, TArray<TArray<const FTransform*>>> BoneSamples;
+    for (const FRecordFrame& Frame : Frames)
+    {
+        for (const auto& Pair : Frame.ComponentTransforms)
+        {
+            ComponentSamples.FindOrAdd(Pair.Key).Add(&Pair.Value);
+        }
+        for (const auto& BonePair : Frame.SkeletalMeshBoneTransforms)
+        {
+            TArray<TArray<const FTransform*>>& PerBone = BoneSamples.FindOrAdd(BonePair.Key);
+            const TArray<FTransform>& BoneTransforms = BonePair.Value.BoneTransforms;
+            if (PerBone.Num() < BoneTransforms.Num())
+            {
+                PerBone.SetNum(BoneTransforms.Num());
+            }
+            for (int32 BoneIndex = 0; BoneIndex < BoneTransforms.Num(); ++BoneIndex)
+            {
+                PerBone[BoneIndex].Add(&BoneTransforms[BoneIndex]);
+            }
+        }
+    }
+
+    FLocRange TrackLocRange;
+    FScaleRange TrackScaleRange;
+
+    for (const auto& [ComponentName, Samples] : ComponentSamples)
+    {
+        if (!Ranges)
         {
-            FQuantizedTransform_Lowest Q;
-            Ar << Q;
-            return Q.ToTransform(*LocRange, *ScaleRange);
+            ComputeTrackRanges(Samples, TrackLocRange, TrackScaleRange);
         }
-    default:
+        const FLocRange* LocRange = Ranges ? &Ranges->ComponentRanges : &TrackLocRange;
+        const FScaleRange* ScaleRange = Ranges ? &Ranges->ComponentScaleRanges : &TrackScaleRange;
+        OutTable.ComponentMethods.Add(ComponentName, ChooseTrackMethod(Samples, LocRange, ScaleRange, MaxPositionErrorSq, MinRotationDot, SmallestThreeBits));
+    }
+
+    for (const auto& [ComponentName, PerBone] : BoneSamples)
+    {
+        TArray<ETransformQuantizationMethod>& Methods = OutTable.BoneMethods.Add(ComponentName);
+        Methods.Reserve(PerBone.Num());
+        for (const TArray<const FTransform*>& Samples : PerBone)
         {
-            FTransform T;
-            Ar << T;
-            return T;
+            if (!Ranges)
+            {
+                ComputeTrackRanges(Samples, TrackLocRange, TrackScaleRange);
+            }
+            const FLocRange* LocRange = Ranges ? Ranges->BoneRanges.Find(ComponentName) : &TrackLocRange;
+            const FScaleRange* ScaleRange = Ranges ? Ranges->BoneScaleRanges.Find(ComponentName) : &TrackScaleRange;
+            Methods.Add(ChooseTrackMethod(Samples, LocRange, ScaleRange, MaxPositionErrorSq, MinRotationDot, SmallestThreeBits));
         }
     }
 }
 
-void SerializeSaveData(FArchive& RawAr, FRecordSaveData& SaveData, ETransformQuantizationMethod& QuantOpts)
+void SerializeFrames(FArchive& RawAr, TConstArrayView<FRecordFrame> Frames, const ETransformQuantizationMethod& QuantOpts, const FActorTransformRanges& Ranges, const FTrackQuantizationTable* TrackTable, int32 SmallestThreeBits)
 {
-    ComputeRanges(SaveData);
+    const bool bPerTrack = QuantOpts == ETransformQuantizationMethod::Auto && ensure(TrackTable);
 
-    int32 NumActors = SaveData.RecordActorDataArray.Num();
-    RawAr << NumActors;
+    // Range-derived constants are built once per run instead of once per transform
+    const FTrackQuantizationParams ComponentParams(&Ranges.ComponentRanges, &Ranges.ComponentScaleRanges, SmallestThreeBits);
+    const TMap<FString, FTrackQuantizationParams> BoneParams = MakeBoneParams(Ranges, SmallestThreeBits);
+    TArray<uint8> Scratch;
 
-    for (FRecordActorSaveData& ActorData : SaveData.RecordActorDataArray)
+    int32 NumFrames = Frames.Num();
+    RawAr << NumFrames;
+
+    for (const FRecordFrame& Frame : Frames)
     {
-        RawAr << ActorData.PrimaryComponentName;
-        RawAr << ActorData.ComponentIntervals;
-        RawAr << ActorData.ComponentRanges;
-        RawAr << ActorData.ComponentScaleRanges;
-        RawAr << ActorData.BoneRanges;
-        RawAr << ActorData.BoneScaleRanges;        
+        // Saving archives never write through these references; the casts only satisfy operator<<
+        RawAr << const_cast<float&>(Frame.TimeStamp);
+        RawAr << const_cast<int32&>(Frame.FrameIndex);
 
-        int32 NumFrames = ActorData.RecordedFrames.Num();
-        RawAr << NumFrames;
+        // Component's World Transforms
+        int32 NumComps = Frame.ComponentTransforms.Num();
+        RawAr << NumComps;
+        for (const auto& Pair : Frame.ComponentTransforms)
+        {
+            RawAr << const_cast<FString&>(Pair.Key);
+            const ETransformQuantizationMethod Method = bPerTrack ? TrackTable->GetComponentMethod(Pair.Key) : QuantOpts;
+            SerializeTransform(RawAr, Pair.Value, Method, ComponentParams);
+        }
 
-        for (FRecordFrame& Frame : ActorData.RecordedFrames)
+        // Skeletal Mesh Component's BoneTransforms
+        int32 NumBoneMaps = Frame.SkeletalMeshBoneTransforms.Num();
+        RawAr << NumBoneMaps;
+        for (const auto& BonePair : Frame.SkeletalMeshBoneTransforms)
         {
-            RawAr << Frame.TimeStamp;
-            RawAr << Frame.FrameIndex;
+            RawAr << const_cast<FString&>(BonePair.Key);
 
-            // Component's World Transforms
-            int32 NumComps = Frame.ComponentTransforms.Num();
-            RawAr << NumComps;
-            for (auto& Pair : Frame.ComponentTransforms)
-            {
-                RawAr << Pair.Key;
+            const FBoneComponentSpace& Space = BonePair.Value;
+            int32 BoneCount = Space.BoneTransforms.Num();
+            RawAr << BoneCount;
 
-                const FLocRange* Range = &ActorData.ComponentRanges;
-                const FScaleRange* ScaleRange = &ActorData.ComponentScaleRanges;
-                if (ensure(Range && ScaleRange))
+            const FTrackQuantizationParams* Params = BoneParams.Find(BonePair.Key);
+            if (ensure(Params && Ranges.BoneScaleRanges.Contains(BonePair.Key)))
+            {
+                // One method for every bone: dispatch once and hand the whole component to the archive in one call
+                if (bPerTrack || !WriteRawRows(RawAr, Space.BoneTransforms, QuantOpts, *Params, Scratch))
                 {
-                    SerializeQuantizedTransform(RawAr, Pair.Value, QuantOpts, Range, ScaleRange);
+                    for (int32 BoneIndex = 0; BoneIndex < BoneCount; ++BoneIndex)
+                    {
+                        const ETransformQuantizationMethod Method = bPerTrack ? TrackTable->GetBoneMethod(BonePair.Key, BoneIndex) : QuantOpts;
+                        SerializeTransform(RawAr, Space.BoneTransforms[BoneIndex], Method, *Params);
+                    }
                 }
             }
+        }
+    }
+}
 
-            // Skeletal Mesh Component's BoneTransforms
-            int32 NumBoneMaps = Frame.SkeletalMeshBoneTransforms.Num();
-            RawAr << NumBoneMaps;
-            for (auto& BonePair : Frame.SkeletalMeshBoneTransforms)
-            {
-                RawAr << BonePair.Key;
+void DeserializeFrames(FArchive& DataAr, TArray<FRecordFrame>& OutFrames, const ETransformQuantizationMethod& QuantOpts, const FActorTransformRanges& Ranges, const FTrackQuantizationTable* TrackTable)
+{
+    const bool bPerTrack = QuantOpts == ETransformQuantizationMethod::Auto;
+    if (bPerTrack && !TrackTable)
+    {
+        DataAr.SetError();
+        return;
+    }
+
+    int32 NumFrames = 0;
+    DataAr << NumFrames;
+    if (DataAr.IsError() || NumFrames < 0)
+    {
+        DataAr.SetError();
+        return;
+    }
+    OutFrames.Reserve(OutFrames.Num() + NumFrames);
 
-                const FBoneComponentSpace& Space = BonePair.Value;
-                int32 BoneCount = Space.BoneTransforms.Num();
-                RawAr << BoneCount;
+    const FTrackQuantizationParams ComponentParams(&Ranges.ComponentRanges, &Ranges.ComponentScaleRanges);
+    const TMap<FString, FTrackQuantizationParams> BoneParams = MakeBoneParams(Ranges);
+    const FTrackQuantizationParams DefaultParams;
+    TArray<uint8> Scratch;
 
-                const FLocRange* Range = ActorData.BoneRanges.Find(BonePair.Key);
-                const FScaleRange* ScaleRange = ActorData.BoneScaleRanges.Find(BonePair.Key);
-                if (ensure(Range && ScaleRange))
+    for (int32 f = 0; f < NumFrames; ++f)
+    {
+        FRecordFrame& Frame = OutFrames.AddDefaulted_GetRef();
+        DataAr << Frame.TimeStamp;
+        DataAr << Frame.FrameIndex; 
+
+        // Component's Transforms
+        int32 NumComps = 0;
+        DataAr << NumComps;
+        Frame.ComponentTransforms.Reserve(NumComps);
+        for (int32 c = 0; c < NumComps; ++c)
+        {
+            FString Key;
+            DataAr << Key;
+            const ETransformQuantizationMethod Method = bPerTrack ? TrackTable->GetComponentMethod(Key) : QuantOpts;
+            FTransform T = DeserializeTransform(DataAr, Method, ComponentParams);
+            Frame.ComponentTransforms.Add(MoveTemp(Key), T);
+        }
+
+        // Skeletal Mesh Component's Bone Transforms
+        int32 NumBoneMaps = 0;
+        DataAr << NumBoneMaps;
+        for (int32 bm = 0; bm < NumBoneMaps; ++bm)
+        {
+            FString Key;
+            int32 BoneCount = 0;
+            
+            DataAr << Key;                
+            DataAr << BoneCount;
+            
+            const FTrackQuantizationParams* FoundParams = BoneParams.Find(Key);
+            const FTrackQuantizationParams& Params = FoundParams ? *FoundParams : DefaultParams;
+            
+            const TArray<ETransformQuantizationMethod>* BoneMethods = bPerTrack ? TrackTable->BoneMethods.Find(Key) : nullptr;
+            
+            FBoneComponentSpace& Space = Frame.SkeletalMeshBoneTransforms.Add(MoveTemp(Key));
+            if (bPerTrack || !ReadRawRows(DataAr, BoneCount, QuantOpts, Params, Scratch, Space.BoneTransforms))
+            {
+                Space.BoneTransforms.Reserve(BoneCount);
+                for (int32 b = 0; b < BoneCount; ++b)
                 {
-                    for (const FTransform& BoneT : Space.BoneTransforms)
-                    {
-                        SerializeQuantizedTransform(RawAr, BoneT, QuantOpts, Range, ScaleRange);
-                    }
+                    const ETransformQuantizationMethod Method = !bPerTrack ? QuantOpts
+                        : (BoneMethods && BoneMethods->IsValidIndex(b) ? (*BoneMethods)[b] : ETransformQuantizationMethod::None);
+                    Space.BoneTransforms.Add(DeserializeTransform(DataAr, Method, Params));
                 }
             }
         }
+
+        if (DataAr.IsError())
+        {
+            OutFrames.Pop(EAllowShrinking::No);
+            return;
+        }
+    }
+}
+
+void SerializeSaveData(FArchive& RawAr, const FRecordSaveData& SaveData, const FBloodStainFileOptions& Options)
+{
+    const ETransformQuantizationMethod QuantOpts = Options.QuantizationOption;
+
+    int32 NumActors = SaveData.RecordActorDataArray.Num();
+    RawAr << NumActors;
+
+    for (const FRecordActorSaveData& ActorData : SaveData.RecordActorDataArray)
+    {
+        // Ranges live only for the duration of the write; the source data is left untouched
+        FActorTransformRanges Ranges;
+        ComputeRanges(ActorData.RecordedFrames, Ranges);
+
+        RawAr << const_cast<FName&>(ActorData.PrimaryComponentName);
+        RawAr << const_cast<TArray<FComponentActiveInterval>&>(ActorData.ComponentIntervals);
+        RawAr << Ranges;
+
+        FTrackQuantizationTable TrackTable;
+        if (QuantOpts == ETransformQuantizationMethod::Auto)
+        {
+            ChooseTrackQuantization(ActorData.RecordedFrames, &Ranges, Options.AutoQuantizationMaxPositionError, Options.AutoQuantizationMaxRotationError, Options.SmallestThreeRotationBits, TrackTable);
+            RawAr << TrackTable;
+        }
+
+        SerializeFrames(RawAr, ActorData.RecordedFrames, QuantOpts, Ranges, &TrackTable, Options.SmallestThreeRotationBits);
     }
-    
 }
 
 void DeserializeSaveData(FArchive& DataAr, FRecordSaveData& OutData, const ETransformQuantizationMethod& QuantOpts)
@@ -225,67 +744,31 @@ void DeserializeSaveData(FArchive& DataAr, FRecordSaveData& OutData, const ETran
 
     for (int32 i = 0; i < NumActors; ++i)
     {
-        FRecordActorSaveData ActorData;
+        FRecordActorSaveData& ActorData = OutData.RecordActorDataArray.AddDefaulted_GetRef();
         DataAr << ActorData.PrimaryComponentName;
         DataAr << ActorData.ComponentIntervals;
-        DataAr << ActorData.ComponentRanges;
-        DataAr << ActorData.ComponentScaleRanges;
-        DataAr << ActorData.BoneRanges;
-        DataAr << ActorData.BoneScaleRanges;
 
-        int32 NumFrames = 0;
-        DataAr << NumFrames;
-        ActorData.RecordedFrames.Empty(NumFrames);
+        FActorTransformRanges Ranges;
+        DataAr << Ranges;
 
-        for (int32 f = 0; f < NumFrames; ++f)
+        FTrackQuantizationTable TrackTable;
+        if (QuantOpts == ETransformQuantizationMethod::Auto)
         {
-            FRecordFrame Frame;
-            DataAr << Frame.TimeStamp;
-            DataAr << Frame.FrameIndex; 
+            DataAr << TrackTable;
+        }
 
-            // Component's Transforms
-            int32 NumComps = 0;
-            DataAr << NumComps;
-            for (int32 c = 0; c < NumComps; ++c)
-            {
-                FString Key;
-                DataAr << Key;
-                const FLocRange* Range = &ActorData.ComponentRanges;
-                const FScaleRange* ScaleRange = &ActorData.ComponentScaleRanges;
-                FTransform T = DeserializeQuantizedTransform(DataAr, QuantOpts, Range, ScaleRange);
-                Frame.ComponentTransforms.Add(Key, T);
-            }
+        DeserializeFrames(DataAr, ActorData.RecordedFrames, QuantOpts, Ranges, &TrackTable);
 
-            // Skeletal Mesh Component's Bone Transforms
-            int32 NumBoneMaps = 0;
-            DataAr << NumBoneMaps;
-            for (int32 bm = 0; bm < NumBoneMaps; ++bm)
-            {
-                FString Key;
-                int32 BoneCount = 0;
-                
-                DataAr << Key;                
-                DataAr << BoneCount;
-                
-                FBoneComponentSpace Space;
-                Space.BoneTransforms.Empty(BoneCount);
-                
-                const FLocRange* Range = ActorData.BoneRanges.Find(Key);
-                const FScaleRange* ScaleRange = ActorData.BoneScaleRanges.Find(Key);
-                
-                for (int32 b = 0; b < BoneCount; ++b)
-                {
-                    FTransform BoneT = DeserializeQuantizedTransform(DataAr, QuantOpts, Range, ScaleRange);
-                    Space.BoneTransforms.Add(BoneT);
-                }
-                Frame.SkeletalMeshBoneTransforms.Add(Key, Space);
-            }
+        ActorData.ComponentRanges = Ranges.ComponentRanges;
+        ActorData.ComponentScaleRanges = Ranges.ComponentScaleRanges;
+        ActorData.BoneRanges = MoveTemp(Ranges.BoneRanges);
+        ActorData.BoneScaleRanges = MoveTemp(Ranges.BoneScaleRanges);
 
-            ActorData.RecordedFrames.Add(Frame);
+        if (DataAr.IsError())
+        {
+            return;
         }
-
-        OutData.RecordActorDataArray.Add(ActorData);
     }
 }
 
-} // namespace BloodStainFileUtils_Internal
+} // namespace BloodStainFileUtils_Internal
\ No newline at end of file
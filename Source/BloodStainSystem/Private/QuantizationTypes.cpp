@@ -5,80 +5,93 @@
 
 #include "QuantizationTypes.h"
 
-FQuantizedTransform_Lowest::FQuantizedTransform_Lowest(const FTransform& T, const FLocRange& BoneRange,const FScaleRange& ScaleRange)
+FLowestQuantizationParams::FLowestQuantizationParams(const FLocRange& Range, const FScaleRange& ScaleRange)
 {
-	FVector Mins = BoneRange.PosMin;
-	FVector Ranges = BoneRange.PosMax - Mins;
+	const FVector PosRange = Range.PosMax - Range.PosMin;
+	const FVector ScaleRangeVec = ScaleRange.ScaleMax - ScaleRange.ScaleMin;
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		Mins[Axis] = static_cast<float>(Range.PosMin[Axis]);
+		Ranges[Axis] = static_cast<float>(FMath::Max(PosRange[Axis], static_cast<double>(KINDA_SMALL_NUMBER)));
+		ScaleMins[Axis] = static_cast<float>(ScaleRange.ScaleMin[Axis]);
+		ScaleRanges[Axis] = FMath::Max(static_cast<float>(ScaleRangeVec[Axis]), KINDA_SMALL_NUMBER);
+	}
+}
 
-	FVector ScaleMins = ScaleRange.ScaleMin;
-	FVector ScaleRangesVec = ScaleRange.ScaleMax - ScaleMins;
-	
-	Ranges.X = FMath::Max(Ranges.X, KINDA_SMALL_NUMBER);
-	Ranges.Y = FMath::Max(Ranges.Y, KINDA_SMALL_NUMBER);
-	Ranges.Z = FMath::Max(Ranges.Z, KINDA_SMALL_NUMBER);
-
-	const float MinsArr[3] = {
-		static_cast<float>(Mins.X), static_cast<float>(Mins.Y), static_cast<float>(Mins.Z)
-	};
-	const float RangesArr[3] = {
-		static_cast<float>(Ranges.X), static_cast<float>(Ranges.Y), static_cast<float>(Ranges.Z)
-	};
-
-	const float ScaleMinsArr[3] = { (float)ScaleMins.X, (float)ScaleMins.Y, (float)ScaleMins.Z };
-	const float ScaleRangesArr[3] = {
-		FMath::Max((float)ScaleRangesVec.X, KINDA_SMALL_NUMBER),
-		FMath::Max((float)ScaleRangesVec.Y, KINDA_SMALL_NUMBER),
-		FMath::Max((float)ScaleRangesVec.Z, KINDA_SMALL_NUMBER)
-	};
+FQuantizedTransform_Lowest::FQuantizedTransform_Lowest(const FTransform& T, const FLocRange& BoneRange, const FScaleRange& ScaleRange)
+	: FQuantizedTransform_Lowest(T, FLowestQuantizationParams(BoneRange, ScaleRange))
+{
+}
 
+FQuantizedTransform_Lowest::FQuantizedTransform_Lowest(const FTransform& T, const FLowestQuantizationParams& Params)
+{
 	FVector3f Vec3f(T.GetLocation());
 	FQuat4f Quat4f(T.GetRotation());
 	FVector3f Scale3f(T.GetScale3D());
 	
-	Translation.FromVector(Vec3f, MinsArr, RangesArr);
+	Translation.FromVector(Vec3f, Params.Mins, Params.Ranges);
 	Rotation.FromQuat(Quat4f);
-	Scale = FVectorIntervalFixed32NoW(Scale3f, ScaleMinsArr, ScaleRangesArr);
+	Scale = FVectorIntervalFixed32NoW(Scale3f, Params.ScaleMins, Params.ScaleRanges);
 }
 
 FTransform FQuantizedTransform_Lowest::ToTransform(const FLocRange& Range, const FScaleRange& ScaleRange) const
+{
+	return ToTransform(FLowestQuantizationParams(Range, ScaleRange));
+}
+
+FTransform FQuantizedTransform_Lowest::ToTransform(const FLowestQuantizationParams& Params) const
 {
 	FTransform Out;
-	
-	FVector Mins = Range.PosMin;
-	FVector Ranges = Range.PosMax - Mins;
-	Ranges.X = FMath::Max(Ranges.X, KINDA_SMALL_NUMBER);
-	Ranges.Y = FMath::Max(Ranges.Y, KINDA_SMALL_NUMBER);
-	Ranges.Z = FMath::Max(Ranges.Z, KINDA_SMALL_NUMBER);
-
-	const float MinsArr[3] = {
-		static_cast<float>(Mins.X), static_cast<float>(Mins.Y), static_cast<float>(Mins.Z)
-	};
-	const float RangesArr[3] = {
-		static_cast<float>(Ranges.X), static_cast<float>(Ranges.Y), static_cast<float>(Ranges.Z)
-	};
-    
-    FVector3f Loc;
-    Translation.ToVector(Loc, MinsArr, RangesArr);
+
+	FVector3f Loc;
+	Translation.ToVector(Loc, Params.Mins, Params.Ranges);
 
 	FQuat4f Rot;
 	Rotation.ToQuat(Rot);
 	
 	Out.SetLocation(FVector(Loc));
-	Out.SetRotation( FQuat(Rot) );
-
-	FVector ScaleMins = ScaleRange.ScaleMin;
-	FVector ScaleRangesVec = ScaleRange.ScaleMax - ScaleMins;
-	const float ScaleMinsArr[3] = { (float)ScaleMins.X, (float)ScaleMins.Y, (float)ScaleMins.Z };
-	const float ScaleRangesArr[3] = {
-		FMath::Max((float)ScaleRangesVec.X, KINDA_SMALL_NUMBER),
-		FMath::Max((float)ScaleRangesVec.Y, KINDA_SMALL_NUMBER),
-		FMath::Max((float)ScaleRangesVec.Z, KINDA_SMALL_NUMBER)
-	};
-	
+	Out.SetRotation(FQuat(Rot));
+
 	FVector3f S3f;
-	Scale.ToVector(S3f, ScaleMinsArr, ScaleRangesArr);
+	Scale.ToVector(S3f, Params.ScaleMins, Params.ScaleRanges);
 	
 	Out.SetScale3D(FVector(S3f));
 
 	return Out;
-}
\ No newline at end of file
+}
+
+FQuatSmallestThree::FQuatSmallestThree(const FQuat& Q, int32 InBitsPerComponent)
+	: BitsPerComponent(static_cast<uint8>(FMath::Clamp(InBitsPerComponent, MinBits, MaxBits)))
+{
+	const FQuat N = Q.GetNormalized();
+	const double Values[4] = { N.X, N.Y, N.Z, N.W };
+
+	LargestIndex = 0;
+	for (uint8 Index = 1; Index < 4; ++Index)
+	{
+		if (FMath::Abs(Values[Index]) > FMath::Abs(Values[LargestIndex]))
+		{
+			LargestIndex = Index;
+		}
+	}
+
+	// q and -q are the same rotation; flip so the dropped component is positive
+	const double Sign = Values[LargestIndex] < 0.0 ? -1.0 : 1.0;
+	const double MaxValue = static_cast<double>((1 << BitsPerComponent) - 1);
+
+	int32 Out = 0;
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		if (Index == LargestIndex)
+		{
+			continue;
+		}
+		const double Normalized = (Values[Index] * Sign * UE_DOUBLE_SQRT_2 + 1.0) * 0.5;
+		Components[Out++] = static_cast<uint16>(FMath::Clamp(FMath::RoundToDouble(Normalized * MaxValue), 0.0, MaxValue));
+	}
+}
+
+FQuat FQuatSmallestThree::ToQuat() const
+{
+	return BloodStainQuantizationKernels::DequantizeSmallestThree_Reference(*this);
+}
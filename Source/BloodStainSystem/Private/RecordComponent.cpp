@@ -4,10 +4,10 @@
 
 
 #include "RecordComponent.h"
-#include "BloodStainRecordDataUtils.h"
 #include "BloodStainSubsystem.h"
 #include "BloodStainSystem.h"
 #include "GhostData.h"
+#include "SaveRecordingTask.h"
 #include "Engine/StaticMesh.h"
 #include "Engine/SkeletalMesh.h"
 #include "Engine/GameInstance.h"
@@ -23,7 +23,6 @@
 DECLARE_CYCLE_STAT(TEXT("RecordComp TickComponent"), STAT_RecordComponent_TickComponent, STATGROUP_BloodStain);
 DECLARE_CYCLE_STAT(TEXT("RecordComp Initialize"), STAT_RecordComponent_Initialize, STATGROUP_BloodStain);
 DECLARE_CYCLE_STAT(TEXT("RecordComp CollectMeshComponents"), STAT_RecordComponent_CollectMeshComponents, STATGROUP_BloodStain);
-DECLARE_CYCLE_STAT(TEXT("RecordComp SaveQueuedFrames"), STAT_RecordComponent_CookQueuedFrames, STATGROUP_BloodStain);
 DECLARE_CYCLE_STAT(TEXT("RecordComp OnComponentAttached"), STAT_RecordComponent_OnComponentAttached, STATGROUP_BloodStain);
 DECLARE_CYCLE_STAT(TEXT("RecordComp OnComponentDetached"), STAT_RecordComponent_OnComponentDetached, STATGROUP_BloodStain);
 DECLARE_CYCLE_STAT(TEXT("RecordComp FillMaterialData"), STAT_RecordComponent_FillMaterialData, STATGROUP_BloodStain);
@@ -93,8 +92,7 @@ void URecordComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActo
 							BoneLocalTransforms[BoneIndex] = BoneWorldTransforms[BoneIndex] * WorldToComponent;
 						}
 					}
-					FBoneComponentSpace LocalBoneData(BoneLocalTransforms);
-					NewFrame.SkeletalMeshBoneTransforms.Add(ComponentName, LocalBoneData);
+					NewFrame.SkeletalMeshBoneTransforms.Add(ComponentName, FBoneComponentSpace(MoveTemp(BoneLocalTransforms)));
 				}
 				else
 				{
@@ -105,13 +103,21 @@ void URecordComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActo
 			NewFrame.ComponentTransforms.Add(ComponentName, MeshComp->GetComponentTransform());
 		}
 
+		if (BlockRecorder)
+		{
+			/* Blocks that ended before the rolling window can never be saved */
+			const float WindowStartTime = NewFrame.TimeStamp - RecordOptions.MaxRecordTime;
+			BlockRecorder->AddFrame(MoveTemp(NewFrame));
+			BlockRecorder->DiscardBlocksBefore(WindowStartTime);
+			return;
+		}
+
 		/* If there is no space left, discard the oldest frame */
 		if (FrameQueuePtr->IsFull())
 		{
-			FRecordFrame Discard;
-			FrameQueuePtr->Dequeue(Discard);
+			FrameQueuePtr->Dequeue();
 		}
-		FrameQueuePtr->Enqueue(NewFrame);
+		FrameQueuePtr->Enqueue(MoveTemp(NewFrame));
 	}
 }
 
@@ -135,30 +141,38 @@ void URecordComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 	}
 }
 
-void URecordComponent::Initialize(const FBloodStainRecordOptions& InOptions, const float& InGroupStartTime)
+void URecordComponent::Initialize(const FBloodStainRecordOptions& InOptions, const float& InGroupStartTime, const FBloodStainFileOptions& InFileOptions)
 {
 	SCOPE_CYCLE_COUNTER(STAT_RecordComponent_Initialize);
 	
 	RecordOptions = InOptions;
 	
 	MaxRecordFrames = FMath::CeilToInt(RecordOptions.MaxRecordTime / RecordOptions.SamplingInterval);
-	uint32 CapacityPlusOne = FMath::Max<uint32>(MaxRecordFrames + 1, 2);
+	/* Frames go to the block recorder when pre-cooking, so the queue only needs its minimum capacity */
+	uint32 CapacityPlusOne = RecordOptions.bPrecookInBackground ? 2 : FMath::Max<uint32>(MaxRecordFrames + 1, 2);
 	FrameQueuePtr = MakeUnique<TCircularQueue<FRecordFrame>>(CapacityPlusOne);
 
 	StartTime = InGroupStartTime;
 	
 	CollectOwnedMeshComponents();
+
+	if (RecordOptions.bPrecookInBackground)
+	{
+		BlockRecorder = MakeUnique<FFrameBlockRecorder>(RecordOptions.PrecookBlockFrames, InFileOptions, PrimaryComponentName);
+	}
 }
 
-FRecordActorSaveData URecordComponent::CookQueuedFrames(const float& BaseTime)
+void URecordComponent::TakeRecordSnapshot(FRecordActorSnapshot& OutSnapshot)
 {
-	SCOPE_CYCLE_COUNTER(STAT_RecordComponent_CookQueuedFrames);
-
-	FRecordActorSaveData Result = FRecordActorSaveData();
-	Result.PrimaryComponentName = PrimaryComponentName;
-	BloodStainRecordDataUtils::CookQueuedFrames(RecordOptions.SamplingInterval, BaseTime, FrameQueuePtr.Get(), Result, ComponentActiveIntervals);
-
-	return Result;
+	OutSnapshot.ActorName = GetOwner() ? GetOwner()->GetFName() : NAME_None;
+	OutSnapshot.PrimaryComponentName = PrimaryComponentName;
+	OutSnapshot.FrameQueuePtr = TSharedPtr<TCircularQueue<FRecordFrame>>(FrameQueuePtr.Release());
+	OutSnapshot.BlockRecorder = TSharedPtr<FFrameBlockRecorder>(BlockRecorder.Release());
+	OutSnapshot.ComponentIntervals = MoveTemp(ComponentActiveIntervals);
+	OutSnapshot.RecordActorUserData = InstancedStruct;
+
+	IntervalIndexMap.Empty();
+	SetComponentTickEnabled(false);
 }
 
 void URecordComponent::OnComponentAttached(UMeshComponent* NewComponent)
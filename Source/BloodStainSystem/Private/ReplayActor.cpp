@@ -284,17 +284,13 @@ void AReplayActor::Client_AssembleAndFinalize()
 
 void AReplayActor::Client_FinalizeAndSpawnVisuals()
 {
-	TArray<uint8> RawBytes;
-	if (!BloodStainCompressionUtils::DecompressBuffer(Client_FileHeader.UncompressedSize, Client_ReceivedPayloadBuffer,RawBytes, Client_FileHeader.Options.CompressionOption))
+	FRecordSaveData AllReplayData;
+	if (!BloodStainFileUtils::DecodePayload(Client_FileHeader, Client_ReceivedPayloadBuffer, AllReplayData))
 	{
-		UE_LOG(LogBloodStain, Error, TEXT("[BS] Client failed to decompress payload."));
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] Client failed to decode payload."));
 		Destroy();
 		return;
 	}
-
-	FRecordSaveData AllReplayData;
-	FMemoryReader MemoryReader(RawBytes, true);
-	BloodStainFileUtils_Internal::DeserializeSaveData(MemoryReader, AllReplayData, Client_FileHeader.Options.QuantizationOption);
 	AllReplayData.Header = Client_RecordHeader;
 
 	// Save the replay data locally if it doesn't already exist
@@ -303,13 +299,6 @@ void AReplayActor::Client_FinalizeAndSpawnVisuals()
 		SaveReplayLocallyIfNotExists(AllReplayData, Client_RecordHeader, Client_FileHeader.Options);
 	}
 
-	if (MemoryReader.IsError())
-	{
-		UE_LOG(LogBloodStain, Error, TEXT("[BS] Client failed to deserialize raw bytes."));
-		Destroy();
-		return;
-	}
-
 	if (IsNetMode(NM_DedicatedServer))
 	{
 		PlayComponent->SetComponentTickEnabled(true);
@@ -399,7 +388,7 @@ void AReplayActor::Multicast_InitializeForPayload_Implementation(const FGuid& In
 	
 		TArray<uint8> SerializedData;
 		FMemoryWriter MemoryWriter(SerializedData, true);
-		BloodStainFileUtils_Internal::SerializeSaveData(MemoryWriter, TempData, Client_FileHeader.Options.QuantizationOption);
+		BloodStainFileUtils_Internal::SerializeSaveData(MemoryWriter, TempData, Client_FileHeader.Options);
 	
 		Client_ReceivedPayloadBuffer = SerializedData;
 		Client_FinalizeAndSpawnVisuals(TempData);
@@ -632,15 +621,18 @@ void AReplayActor::SaveReplayLocallyIfNotExists(const FRecordSaveData& SaveData,
 
 	if (!BloodStainFileUtils::FileExists(FileName, LevelName))
 	{
-		const bool bSaved = BloodStainFileUtils::SaveToFile(SaveData, LevelName, FileName, Options);
-		if (bSaved)
+		// The write is queued; the game thread does not wait for it
+		BloodStainFileUtils::SaveToFileAsync(SaveData, LevelName, FileName, Options).Next([LevelName, FileName](bool bSaved)
 		{
-			UE_LOG(LogBloodStain, Log, TEXT("[Client] Replay saved locally: %s / %s"), *LevelName, *FileName);
-		}
-		else
-		{
-			UE_LOG(LogBloodStain, Warning, TEXT("[Client] Failed to save replay locally: %s / %s"), *LevelName, *FileName);
-		}
+			if (bSaved)
+			{
+				UE_LOG(LogBloodStain, Log, TEXT("[Client] Replay saved locally: %s / %s"), *LevelName, *FileName);
+			}
+			else
+			{
+				UE_LOG(LogBloodStain, Warning, TEXT("[Client] Failed to save replay locally: %s / %s"), *LevelName, *FileName);
+			}
+		});
 	}
 	else
 	{
@@ -4,9 +4,9 @@
 
 
 #include "ReplayTerminatedActorManager.h"
-#include "BloodStainRecordDataUtils.h"
 #include "BloodStainSystem.h"
 #include "RecordComponent.h"
+#include "SaveRecordingTask.h"
 #include "Engine/World.h"
 
 void UReplayTerminatedActorManager::Tick(float DeltaTime)
@@ -31,7 +31,8 @@ void UReplayTerminatedActorManager::AddToRecordGroup(const FName& GroupName, URe
 	RecordComponentData.ActorName = RecordComponent->GetOwner()->GetFName();
 	RecordComponentData.TimeSinceLastRecord = RecordComponent->TimeSinceLastRecord;
 	RecordComponentData.FrameQueuePtr = TSharedPtr<TCircularQueue<FRecordFrame>>(RecordComponent->FrameQueuePtr.Release());
-	RecordComponentData.GhostSaveData.PrimaryComponentName = MoveTemp(RecordComponent->PrimaryComponentName);
+	RecordComponentData.BlockRecorder = TSharedPtr<FFrameBlockRecorder>(RecordComponent->BlockRecorder.Release());
+	RecordComponentData.PrimaryComponentName = MoveTemp(RecordComponent->PrimaryComponentName);
 
 	RecordComponentData.ComponentIntervals = MoveTemp(RecordComponent->ComponentActiveIntervals);
 	RecordComponentData.InstancedStruct = RecordComponent->GetRecordActorUserData();	
@@ -61,15 +62,28 @@ void UReplayTerminatedActorManager::CollectRecordGroups(float DeltaTime)
 			FRecordComponentData& RecordComponentData = RecordGroupData.RecordComponentData[i];
 			RecordComponentData.TimeSinceLastRecord += DeltaTime;
 			
-			if (RecordComponentData.TimeSinceLastRecord >= RecordGroupData.RecordOptions.SamplingInterval)
+			if (RecordComponentData.TimeSinceLastRecord >= RecordGroupData.RecordOptions.SamplingInterval && RecordComponentData.BlockRecorder.IsValid())
 			{
-				FRecordFrame FirstFrame;
-				while (RecordComponentData.FrameQueuePtr->Peek(FirstFrame))
+				const float CurrentTimeStamp = GetWorld()->GetTimeSeconds() - RecordComponentData.StartTime;
+				RecordComponentData.BlockRecorder->DiscardBlocksBefore(CurrentTimeStamp - RecordGroupData.RecordOptions.MaxRecordTime);
+
+				if (RecordComponentData.BlockRecorder->IsEmpty())
+				{
+					RecordGroupData.RecordComponentData.RemoveAt(i);
+					continue;
+				}
+
+				RecordComponentData.TimeSinceLastRecord = 0.0f;
+			}
+			else if (RecordComponentData.TimeSinceLastRecord >= RecordGroupData.RecordOptions.SamplingInterval)
+			{
+				// Peek by pointer so the head frame is not copied on every collect
+				while (const FRecordFrame* FirstFrame = RecordComponentData.FrameQueuePtr->Peek())
 				{
 					float CurrentTimeStamp = GetWorld()->GetTimeSeconds() - RecordComponentData.StartTime;
 
 					// Time Buffer Out
-					if (FirstFrame.TimeStamp + RecordGroupData.RecordOptions.MaxRecordTime < CurrentTimeStamp)
+					if (FirstFrame->TimeStamp + RecordGroupData.RecordOptions.MaxRecordTime < CurrentTimeStamp)
 					{
 						RecordComponentData.FrameQueuePtr->Dequeue();
 					}
@@ -102,37 +116,25 @@ void UReplayTerminatedActorManager::CollectRecordGroups(float DeltaTime)
 	}
 }
 
-TArray<FRecordActorSaveData> UReplayTerminatedActorManager::CookQueuedFrames(const FName& GroupName, const float& BaseTime, TArray<FName>& OutActorNameArray, TArray<FInstancedStruct>& OutInstancedStructArray)
+void UReplayTerminatedActorManager::TakeRecordGroupSnapshots(const FName& GroupName, TArray<FRecordActorSnapshot>& OutSnapshots)
 {
-	TArray<FRecordActorSaveData> Result = TArray<FRecordActorSaveData>();
-	OutActorNameArray.Empty();
-	
-	if (!RecordGroups.Contains(GroupName))
+	FRecordGroupData* RecordGroupData = RecordGroups.Find(GroupName);
+	if (!RecordGroupData)
 	{
-		UE_LOG(LogBloodStain, Warning, TEXT("There is No Group for %s"), *GroupName.ToString());
-		return Result;
+		return;
 	}
 
-	FRecordGroupData& RecordGroupData = RecordGroups[GroupName];
-
-	if (RecordGroupData.RecordComponentData.Num() == 0)
+	OutSnapshots.Reserve(OutSnapshots.Num() + RecordGroupData->RecordComponentData.Num());
+	for (FRecordComponentData& RecordComponentData : RecordGroupData->RecordComponentData)
 	{
-		UE_LOG(LogBloodStain, Warning, TEXT("There is no Record Data in Group for %s"), *GroupName.ToString());
-		RecordGroups.Remove(GroupName);
-		return Result;
-	}
-	
-	for (FRecordComponentData& RecordComponentData : RecordGroupData.RecordComponentData)
-	{
-		if (BloodStainRecordDataUtils::CookQueuedFrames(RecordGroupData.RecordOptions.SamplingInterval, BaseTime, RecordComponentData.FrameQueuePtr.Get(), RecordComponentData.GhostSaveData, RecordComponentData.ComponentIntervals))
-		{
-			OutActorNameArray.Add(RecordComponentData.ActorName);
-			Result.Add(RecordComponentData.GhostSaveData);
-			OutInstancedStructArray.Add(RecordComponentData.InstancedStruct);
-		}
+		FRecordActorSnapshot& Snapshot = OutSnapshots.AddDefaulted_GetRef();
+		Snapshot.ActorName = RecordComponentData.ActorName;
+		Snapshot.PrimaryComponentName = RecordComponentData.PrimaryComponentName;
+		Snapshot.FrameQueuePtr = MoveTemp(RecordComponentData.FrameQueuePtr);
+		Snapshot.BlockRecorder = MoveTemp(RecordComponentData.BlockRecorder);
+		Snapshot.ComponentIntervals = MoveTemp(RecordComponentData.ComponentIntervals);
+		Snapshot.RecordActorUserData = MoveTemp(RecordComponentData.InstancedStruct);
 	}
 
 	RecordGroups.Remove(GroupName);
-	
-	return Result;
-}
\ No newline at end of file
+}
@@ -5,20 +5,144 @@
 
 #include "SaveRecordingTask.h"
 #include "BloodStainFileUtils.h"
-#include "BloodStainsystem.h"
+#include "BloodStainRecordDataUtils.h"
+#include "BloodStainSystem.h"
+#include "Async/TaskGraphInterfaces.h"
+
+DECLARE_CYCLE_STAT(TEXT("SaveRecordingTask CookSnapshots"), STAT_SaveRecordingTask_CookSnapshots, STATGROUP_BloodStain);
 
 void FSaveRecordingTask::DoWork()
 {
-	const bool bSuccess = BloodStainFileUtils::SaveToFile(SavedData, LevelName, FileName, FileOptions);
-	FGraphEventRef Task = FFunctionGraphTask::CreateAndDispatchWhenReady([=, LocalOnTaskCompleted = this->OnTaskCompleted]()
+	TFuture<bool> SaveResult;
+	if (!CookSnapshots())
+	{
+		SaveResult = MakeFulfilledPromise<bool>(false).GetFuture();
+	}
+	else if (EncodedActors.Num() > 0)
+	{
+		// Groups with any pre-cooked recorder are saved fully encoded (MergeCookedActors)
+		SaveResult = BloodStainFileUtils::SaveEncodedToFileAsync(SavedData.Header, MoveTemp(EncodedActors), LevelName, FileName, FileOptions);
+	}
+	else
+	{
+		SaveResult = BloodStainFileUtils::SaveToFileAsync(SavedData, LevelName, FileName, FileOptions);
+	}
+
+	// The write is queued on the I/O scheduler; this worker is released instead of waiting for it
+	SaveResult.Next([Header = MoveTemp(SavedData.Header), LocalOnTaskCompleted = MoveTemp(OnTaskCompleted)](bool bSuccess) mutable
 	{
-		if (bSuccess)
+		FFunctionGraphTask::CreateAndDispatchWhenReady([bSuccess, Header = MoveTemp(Header), LocalOnTaskCompleted = MoveTemp(LocalOnTaskCompleted)]()
 		{
-			LocalOnTaskCompleted.ExecuteIfBound();
+			if (!bSuccess)
+			{
+				UE_LOG(LogBloodStain, Error, TEXT("Async save task failed. Upload will not start."));
+			}
+			LocalOnTaskCompleted.ExecuteIfBound(bSuccess, Header);
+		}, TStatId(), nullptr, ENamedThreads::GameThread);
+	});
+}
+
+bool FSaveRecordingTask::CookSnapshots()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SaveRecordingTask_CookSnapshots);
+
+	int32 SpawnPointIndex = INDEX_NONE;
+	TArray<FTransform> FirstPrimaryTransforms;
+	FirstPrimaryTransforms.Reserve(Snapshots.Num());
+
+	// Per saved actor, in snapshot order: true if it came from a pre-cooked recorder
+	TArray<bool> SavedPrecooked;
+	SavedPrecooked.Reserve(Snapshots.Num());
+	SavedData.Header.RecordActorUserData.Reset(Snapshots.Num());
+
+	for (FRecordActorSnapshot& Snapshot : Snapshots)
+	{
+		if (Snapshot.BlockRecorder.IsValid())
+		{
+			FEncodedActorData ActorData;
+			ActorData.PrimaryComponentName = Snapshot.PrimaryComponentName;
+
+			int32 FirstFrameIndex = 0;
+			if (!Snapshot.BlockRecorder->Finalize(ClipStartTime, ActorData, FirstFrameIndex))
+			{
+				UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Warning: Frame is 0: %s"), *Snapshot.ActorName.ToString());
+				continue;
+			}
+			BloodStainRecordDataUtils::BuildInitialComponentStructure(FirstFrameIndex, ActorData.NumFrames, Snapshot.ComponentIntervals, ActorData.ComponentIntervals);
+
+			FirstPrimaryTransforms.Add(ActorData.FirstPrimaryTransform);
+			EncodedActors.Add(MoveTemp(ActorData));
+			SavedPrecooked.Add(true);
+		}
+		else if (Snapshot.FrameQueuePtr.IsValid())
+		{
+			FRecordActorSaveData ActorData;
+			ActorData.PrimaryComponentName = Snapshot.PrimaryComponentName;
+			if (!BloodStainRecordDataUtils::CookQueuedFrames(SamplingInterval, ClipStartTime, Snapshot.FrameQueuePtr.Get(), ActorData, Snapshot.ComponentIntervals))
+			{
+				UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Warning: Frame is 0: %s"), *Snapshot.ActorName.ToString());
+				continue;
+			}
+
+			if (FileOptions.bReduceKeyframes)
+			{
+				const int32 NumRemoved = BloodStainRecordDataUtils::ReduceKeyframes(ActorData, FileOptions.MaxKeyframePositionError, FileOptions.MaxKeyframeRotationError);
+				UE_LOG(LogBloodStain, Log, TEXT("[BloodStain] Keyframe reduction removed %d frames of %s"), NumRemoved, *Snapshot.ActorName.ToString());
+			}
+
+			FirstPrimaryTransforms.Add(ActorData.RecordedFrames[0].ComponentTransforms.FindRef(ActorData.PrimaryComponentName.ToString()));
+			SavedData.RecordActorDataArray.Add(MoveTemp(ActorData));
+			SavedPrecooked.Add(false);
 		}
 		else
 		{
-			UE_LOG(LogBloodStain, Error, TEXT("Async save task failed. Upload will not start."));
+			continue;
+		}
+
+		if (Snapshot.ActorName == MainActorName && SpawnPointIndex == INDEX_NONE)
+		{
+			SpawnPointIndex = FirstPrimaryTransforms.Num() - 1;
 		}
-	}, TStatId(), nullptr, ENamedThreads::GameThread);
-}
\ No newline at end of file
+		SavedData.Header.RecordActorUserData.Add(MoveTemp(Snapshot.RecordActorUserData));
+	}
+	Snapshots.Empty();
+
+	if (FirstPrimaryTransforms.Num() == 0)
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Failed: There is no Valid Recorder in file [%s]"), *FileName);
+		return false;
+	}
+
+	SavedData.Header.SpawnPointTransform = FirstPrimaryTransforms[SpawnPointIndex != INDEX_NONE ? SpawnPointIndex : 0];
+	SavedData.Header.Summary.MainActorIndex = SpawnPointIndex != INDEX_NONE ? SpawnPointIndex : 0;
+
+	return EncodedActors.Num() == 0 || MergeCookedActors(SavedPrecooked);
+}
+
+bool FSaveRecordingTask::MergeCookedActors(TConstArrayView<bool> SavedPrecooked)
+{
+	if (SavedData.RecordActorDataArray.Num() == 0)
+	{
+		return true;
+	}
+
+	TArray<FEncodedActorData> CookedActors;
+	if (!BloodStainBlockUtils::EncodeActors(SavedData.RecordActorDataArray, BloodStainBlockUtils::SaveBlockDuration, BloodStainBlockUtils::SaveBlockMaxFrames, FileOptions, CookedActors))
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BloodStain] StopRecording Failed: Could not encode the cooked actors of file [%s]"), *FileName);
+		return false;
+	}
+
+	// Actor indices (spawn point, user data) count both kinds in snapshot order, so the merged list must keep it
+	TArray<FEncodedActorData> PrecookedActors = MoveTemp(EncodedActors);
+	EncodedActors.Reset(SavedPrecooked.Num());
+	int32 NextPrecooked = 0;
+	int32 NextCooked = 0;
+	for (const bool bPrecooked : SavedPrecooked)
+	{
+		EncodedActors.Add(MoveTemp(bPrecooked ? PrecookedActors[NextPrecooked++] : CookedActors[NextCooked++]));
+	}
+
+	SavedData.RecordActorDataArray.Empty();
+	return true;
+}
@@ -0,0 +1,285 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#include "BloodStainQuantizationKernels.h"
+#include "QuantizationTypes.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace BloodStainQuantizationKernelsTest_Internal
+{
+	/** Bit-exact, so a difference in the last ulp (or in the sign of a zero) fails */
+	bool IsBitIdentical(double A, double B)
+	{
+		return FMemory::Memcmp(&A, &B, sizeof(double)) == 0;
+	}
+
+	bool IsBitIdentical(const FVector& A, const FVector& B)
+	{
+		return IsBitIdentical(A.X, B.X) && IsBitIdentical(A.Y, B.Y) && IsBitIdentical(A.Z, B.Z);
+	}
+
+	bool IsBitIdentical(const FTransform& A, const FTransform& B)
+	{
+		const FQuat QA = A.GetRotation();
+		const FQuat QB = B.GetRotation();
+		return IsBitIdentical(QA.X, QB.X) && IsBitIdentical(QA.Y, QB.Y) && IsBitIdentical(QA.Z, QB.Z) && IsBitIdentical(QA.W, QB.W)
+			&& IsBitIdentical(A.GetLocation(), B.GetLocation()) && IsBitIdentical(A.GetScale3D(), B.GetScale3D());
+	}
+
+	/** Random stored components, with the first rows pinned to the ends of the range */
+	FQuantizedTransform_SmallestThree MakeQuantized(FRandomStream& Random, int32 Row, int32 LargestIndex, int32 Bits)
+	{
+		const int32 MaxValue = (1 << Bits) - 1;
+
+		FQuantizedTransform_SmallestThree Q;
+		Q.Location = FVector(Random.FRandRange(-1.0e4f, 1.0e4f), Random.FRandRange(-1.0e4f, 1.0e4f), Random.FRandRange(-1.0e4f, 1.0e4f));
+		Q.Scale = FVector(Random.FRandRange(0.1f, 4.f));
+		Q.Rotation.LargestIndex = static_cast<uint8>(LargestIndex);
+		Q.Rotation.BitsPerComponent = static_cast<uint8>(Bits);
+		for (int32 Component = 0; Component < 3; ++Component)
+		{
+			const int32 Value = Row == 0 ? 0 : Row == 1 ? MaxValue : Row == 2 ? MaxValue / 2 : Random.RandRange(0, MaxValue);
+			Q.Rotation.Components[Component] = static_cast<uint16>(Value);
+		}
+		return Q;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBloodStainDequantizeTransformsTest, "BloodStain.Quantization.Kernels.DequantizeTransforms",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBloodStainDequantizeTransformsTest::RunTest(const FString& Parameters)
+{
+	using namespace BloodStainQuantizationKernelsTest_Internal;
+
+	FRandomStream Random(0x5253746E);
+
+	// Counts around the lane width cover the vector loop, the scalar tail, and both together
+	const int32 Counts[] = { 0, 1, 3, 4, 5, 7, 8, 13, 64, 67 };
+
+	for (int32 Bits = FQuatSmallestThree::MinBits; Bits <= FQuatSmallestThree::MaxBits; ++Bits)
+	{
+		for (int32 LargestIndex = 0; LargestIndex < 4; ++LargestIndex)
+		{
+			for (const int32 Count : Counts)
+			{
+				TArray<FQuantizedTransform_SmallestThree> Quantized;
+				for (int32 Row = 0; Row < Count; ++Row)
+				{
+					Quantized.Add(MakeQuantized(Random, Row, LargestIndex, Bits));
+				}
+
+				TArray<FTransform> Vector;
+				TArray<FTransform> Reference;
+				BloodStainQuantizationKernels::DequantizeTransforms(Quantized, Vector);
+				BloodStainQuantizationKernels::DequantizeTransforms_Reference(Quantized, Reference);
+
+				if (!TestEqual(FString::Printf(TEXT("Count (Bits %d, LargestIndex %d, Num %d)"), Bits, LargestIndex, Count), Vector.Num(), Count)
+					|| !TestEqual(TEXT("Reference count"), Reference.Num(), Count))
+				{
+					return false;
+				}
+
+				for (int32 Row = 0; Row < Count; ++Row)
+				{
+					if (!IsBitIdentical(Vector[Row], Reference[Row]))
+					{
+						AddError(FString::Printf(TEXT("Row %d differs (Bits %d, LargestIndex %d, Num %d): %s vs %s"),
+							Row, Bits, LargestIndex, Count, *Vector[Row].ToString(), *Reference[Row].ToString()));
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	// Appends behind what the caller already holds
+	TArray<FQuantizedTransform_SmallestThree> Quantized;
+	for (int32 Row = 0; Row < 6; ++Row)
+	{
+		Quantized.Add(MakeQuantized(Random, Row, Row % 4, FQuatSmallestThree::DefaultBits));
+	}
+	TArray<FTransform> Appended;
+	Appended.Add(FTransform::Identity);
+	BloodStainQuantizationKernels::DequantizeTransforms(Quantized, Appended);
+	TestEqual(TEXT("Appended count"), Appended.Num(), Quantized.Num() + 1);
+	TestTrue(TEXT("Existing element kept"), IsBitIdentical(Appended[0], FTransform::Identity));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBloodStainSnapToGridTest, "BloodStain.Quantization.Kernels.SnapToGrid",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBloodStainSnapToGridTest::RunTest(const FString& Parameters)
+{
+	using namespace BloodStainQuantizationKernelsTest_Internal;
+
+	FRandomStream Random(0x42535044);
+
+	const double StepsPerUnits[] = { QuantizedLocationStepsPerUnit, QuantizedScaleStepsPerUnit, 1.0, 3.0 };
+	for (const double StepsPerUnit : StepsPerUnits)
+	{
+		TArray<FVector> Inputs;
+
+		// Exact halves round up, on both sides of zero
+		Inputs.Add(FVector(0.5 / StepsPerUnit, -0.5 / StepsPerUnit, 1.5 / StepsPerUnit));
+		Inputs.Add(FVector(0.0, -0.0, 1.0 / StepsPerUnit));
+		Inputs.Add(FVector(1.0e7, -1.0e7, 12345.678));
+		for (int32 Index = 0; Index < 256; ++Index)
+		{
+			Inputs.Add(FVector(Random.FRandRange(-1.0e5f, 1.0e5f), Random.FRandRange(-10.f, 10.f), Random.FRandRange(-1.f, 1.f)));
+		}
+
+		for (const FVector& Input : Inputs)
+		{
+			const FVector Vector = BloodStainQuantizationKernels::SnapToGrid(Input, StepsPerUnit);
+			const FVector Reference = BloodStainQuantizationKernels::SnapToGrid_Reference(Input, StepsPerUnit);
+			if (!IsBitIdentical(Vector, Reference))
+			{
+				AddError(FString::Printf(TEXT("SnapToGrid(%s, %.1f) differs: %s vs %s"), *Input.ToString(), StepsPerUnit, *Vector.ToString(), *Reference.ToString()));
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBloodStainGridBatchTest, "BloodStain.Quantization.Kernels.GridBatch",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBloodStainGridBatchTest::RunTest(const FString& Parameters)
+{
+	using namespace BloodStainQuantizationKernelsTest_Internal;
+
+	FRandomStream Random(0x47524944);
+
+	const double StepsPerUnits[] = { QuantizedLocationStepsPerUnit, QuantizedScaleStepsPerUnit };
+	const int32 Counts[] = { 0, 1, 2, 3, 4, 5, 7, 8, 13, 67 };
+	for (const double StepsPerUnit : StepsPerUnits)
+	{
+		for (const int32 Count : Counts)
+		{
+			TArray<FVector> Inputs;
+			for (int32 Index = 0; Index < Count; ++Index)
+			{
+				Inputs.Add(Index == 0 ? FVector(0.5 / StepsPerUnit, -0.5 / StepsPerUnit, -0.0)
+					: FVector(Random.FRandRange(-1.0e5f, 1.0e5f), Random.FRandRange(-10.f, 10.f), Random.FRandRange(-1.f, 1.f)));
+			}
+
+			// Batch snapping matches the reference and the single-vector kernel the constructors use
+			TArray<FVector> Snapped;
+			TArray<FVector> SnappedReference;
+			Snapped.SetNumUninitialized(Count);
+			SnappedReference.SetNumUninitialized(Count);
+			BloodStainQuantizationKernels::SnapToGrid(Inputs, StepsPerUnit, Snapped);
+			BloodStainQuantizationKernels::SnapToGrid_Reference(Inputs, StepsPerUnit, SnappedReference);
+			for (int32 Index = 0; Index < Count; ++Index)
+			{
+				if (!IsBitIdentical(Snapped[Index], SnappedReference[Index]) || !IsBitIdentical(Snapped[Index], BloodStainQuantizationKernels::SnapToGrid(Inputs[Index], StepsPerUnit)))
+				{
+					AddError(FString::Printf(TEXT("Batch SnapToGrid row %d of %d differs: %s vs %s"), Index, Count, *Snapped[Index].ToString(), *SnappedReference[Index].ToString()));
+					return false;
+				}
+			}
+
+			// Aliased input and output
+			TArray<FVector> InPlace = Inputs;
+			BloodStainQuantizationKernels::SnapToGrid(InPlace, StepsPerUnit, InPlace);
+			for (int32 Index = 0; Index < Count; ++Index)
+			{
+				if (!IsBitIdentical(InPlace[Index], SnappedReference[Index]))
+				{
+					AddError(FString::Printf(TEXT("In-place SnapToGrid row %d of %d differs"), Index, Count));
+					return false;
+				}
+			}
+
+			// Counts and back, as the track codec stores the translation / scale channels
+			const TConstArrayView<double> Values(reinterpret_cast<const double*>(Snapped.GetData()), Count * 3);
+			TArray<int64> GridCounts;
+			TArray<int64> GridCountsReference;
+			GridCounts.SetNumUninitialized(Values.Num());
+			GridCountsReference.SetNumUninitialized(Values.Num());
+			BloodStainQuantizationKernels::GridValuesToCounts(Values, StepsPerUnit, GridCounts);
+			BloodStainQuantizationKernels::GridValuesToCounts_Reference(Values, StepsPerUnit, GridCountsReference);
+			if (!TestTrue(FString::Printf(TEXT("GridValuesToCounts matches the reference (Num %d)"), Count), GridCounts == GridCountsReference))
+			{
+				return false;
+			}
+
+			TArray<double> Restored;
+			TArray<double> RestoredReference;
+			Restored.SetNumUninitialized(GridCounts.Num());
+			RestoredReference.SetNumUninitialized(GridCounts.Num());
+			BloodStainQuantizationKernels::GridCountsToValues(GridCounts, StepsPerUnit, Restored);
+			BloodStainQuantizationKernels::GridCountsToValues_Reference(GridCounts, StepsPerUnit, RestoredReference);
+			for (int32 Index = 0; Index < Restored.Num(); ++Index)
+			{
+				if (!IsBitIdentical(Restored[Index], RestoredReference[Index]))
+				{
+					AddError(FString::Printf(TEXT("GridCountsToValues value %d of %d differs: %.17g vs %.17g"), Index, Restored.Num(), Restored[Index], RestoredReference[Index]));
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBloodStainGridBatchBenchmark, "BloodStain.Quantization.Kernels.GridBatchBenchmark",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FBloodStainGridBatchBenchmark::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumVectors = 64 * 1024;
+	constexpr int32 NumRuns = 16;
+
+	FRandomStream Random(0x42454E43);
+	TArray<FVector> Inputs;
+	Inputs.Reserve(NumVectors);
+	for (int32 Index = 0; Index < NumVectors; ++Index)
+	{
+		Inputs.Add(FVector(Random.FRandRange(-1.0e5f, 1.0e5f), Random.FRandRange(-1.0e5f, 1.0e5f), Random.FRandRange(-1.0e3f, 1.0e3f)));
+	}
+	TArray<FVector> Snapped;
+	Snapped.SetNumUninitialized(NumVectors);
+	TArray<int64> GridCounts;
+	GridCounts.SetNumUninitialized(NumVectors * 3);
+	TArray<double> Restored;
+	Restored.SetNumUninitialized(NumVectors * 3);
+	const TConstArrayView<double> Values(reinterpret_cast<const double*>(Snapped.GetData()), NumVectors * 3);
+
+	// Best of several runs, reported side by side; timings are informational and never fail the test
+	auto Measure = [NumRuns](TFunctionRef<void()> Work)
+	{
+		double Best = TNumericLimits<double>::Max();
+		for (int32 Run = 0; Run < NumRuns; ++Run)
+		{
+			const double Start = FPlatformTime::Seconds();
+			Work();
+			Best = FMath::Min(Best, FPlatformTime::Seconds() - Start);
+		}
+		return Best * 1000.0;
+	};
+
+	const double SnapMs = Measure([&]() { BloodStainQuantizationKernels::SnapToGrid(Inputs, QuantizedLocationStepsPerUnit, Snapped); });
+	const double SnapReferenceMs = Measure([&]() { BloodStainQuantizationKernels::SnapToGrid_Reference(Inputs, QuantizedLocationStepsPerUnit, Snapped); });
+	const double ToCountsMs = Measure([&]() { BloodStainQuantizationKernels::GridValuesToCounts(Values, QuantizedLocationStepsPerUnit, GridCounts); });
+	const double ToCountsReferenceMs = Measure([&]() { BloodStainQuantizationKernels::GridValuesToCounts_Reference(Values, QuantizedLocationStepsPerUnit, GridCounts); });
+	const double ToValuesMs = Measure([&]() { BloodStainQuantizationKernels::GridCountsToValues(GridCounts, QuantizedLocationStepsPerUnit, Restored); });
+	const double ToValuesReferenceMs = Measure([&]() { BloodStainQuantizationKernels::GridCountsToValues_Reference(GridCounts, QuantizedLocationStepsPerUnit, Restored); });
+
+	AddInfo(FString::Printf(TEXT("%d vectors: SnapToGrid %.3f ms (reference %.3f ms), GridValuesToCounts %.3f ms (reference %.3f ms), GridCountsToValues %.3f ms (reference %.3f ms)"),
+		NumVectors, SnapMs, SnapReferenceMs, ToCountsMs, ToCountsReferenceMs, ToValuesMs, ToValuesReferenceMs));
+	return true;
+}
+
+#endif
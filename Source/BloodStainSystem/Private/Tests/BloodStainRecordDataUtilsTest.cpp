@@ -0,0 +1,136 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#include "BloodStainRecordDataUtils.h"
+#include "GhostData.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace BloodStainRecordDataUtilsTest_Internal
+{
+	/** Step between frames; a power of two so timestamps and the window edges are exact */
+	constexpr float FrameStep = 0.25f;
+
+	/** [Start, End) in frame indices */
+	struct FFrameRange
+	{
+		int32 Start;
+		int32 End;
+	};
+
+	FRecordActorSaveData MakeActor(float StartTime, int32 NumFrames, std::initializer_list<FFrameRange> Intervals)
+	{
+		FRecordActorSaveData Actor;
+		for (int32 Index = 0; Index < NumFrames; ++Index)
+		{
+			FRecordFrame& Frame = Actor.RecordedFrames.AddDefaulted_GetRef();
+			Frame.TimeStamp = StartTime + Index * FrameStep;
+			Frame.FrameIndex = Index;
+		}
+		for (const FFrameRange& Interval : Intervals)
+		{
+			Actor.ComponentIntervals.Add(FComponentActiveInterval(FComponentRecord(), Interval.Start, Interval.End));
+		}
+		return Actor;
+	}
+
+	bool TestIntervals(FAutomationTestBase& Test, const FString& What, const FRecordActorSaveData& Actor, std::initializer_list<FFrameRange> Expected)
+	{
+		if (!Test.TestEqual(What + TEXT(" interval count"), Actor.ComponentIntervals.Num(), static_cast<int32>(Expected.size())))
+		{
+			return false;
+		}
+
+		int32 Index = 0;
+		for (const FFrameRange& Interval : Expected)
+		{
+			const FComponentActiveInterval& Actual = Actor.ComponentIntervals[Index++];
+			Test.TestEqual(FString::Printf(TEXT("%s interval %d start"), *What, Index - 1), Actual.StartFrame, Interval.Start);
+			Test.TestEqual(FString::Printf(TEXT("%s interval %d end"), *What, Index - 1), Actual.EndFrame, Interval.End);
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBloodStainClipActorSaveDataTest, "BloodStain.RecordData.ClipActorSaveDataByGroup",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBloodStainClipActorSaveDataTest::RunTest(const FString& Parameters)
+{
+	using namespace BloodStainRecordDataUtilsTest_Internal;
+
+	// Empty actor list: nothing to clip, only a warning
+	{
+		AddExpectedMessage(TEXT("ClipActorSaveDataByGroup: No actors to process."), ELogVerbosity::Warning, EAutomationExpectedMessageFlags::Contains, 1, false);
+		TArray<FRecordActorSaveData> Actors;
+		BloodStainRecordDataUtils::ClipActorSaveDataByGroup(Actors, 2.f, FrameStep);
+		TestEqual(TEXT("Empty list stays empty"), Actors.Num(), 0);
+	}
+
+	// Group [0, 5]; a 2 second budget keeps the window [3, 5]
+	TArray<FRecordActorSaveData> Actors;
+
+	// Ends before the window opens
+	Actors.Add(MakeActor(0.f, 5, { { 0, 3 }, { 1, INT32_MAX } }));
+
+	// Frames 2.0 .. 5.0; frame 4 (t = 3.0) is the first one kept
+	Actors.Add(MakeActor(2.f, 13, {
+		{ 0, 6 },          // straddles the window start
+		{ 2, 4 },          // ends before the window
+		{ 6, INT32_MAX },  // open-ended, starts inside
+		{ 4, 13 },         // exactly the window
+		{ 0, INT32_MAX },  // open-ended, straddles the window start
+		{ 10, 20 } }));    // straddles the window end
+
+	// Starts after the window opens, so nothing is cut from its head
+	Actors.Add(MakeActor(4.f, 5, { { 1, INT32_MAX }, { 0, 2 } }));
+
+	// Never recorded a frame
+	Actors.Add(MakeActor(0.f, 0, { { 0, INT32_MAX } }));
+
+	BloodStainRecordDataUtils::ClipActorSaveDataByGroup(Actors, 2.f, FrameStep);
+
+	TestEqual(TEXT("Actor count is kept"), Actors.Num(), 4);
+
+	TestEqual(TEXT("Actor before the window loses every frame"), Actors[0].RecordedFrames.Num(), 0);
+	TestIntervals(*this, TEXT("Actor before the window"), Actors[0], {});
+
+	const FRecordActorSaveData& Straddling = Actors[1];
+	if (TestEqual(TEXT("Straddling actor frame count"), Straddling.RecordedFrames.Num(), 9))
+	{
+		TestEqual(TEXT("Straddling actor is rebased onto the window start"), Straddling.RecordedFrames[0].TimeStamp, 0.f);
+		TestEqual(TEXT("Straddling actor last timestamp"), Straddling.RecordedFrames.Last().TimeStamp, 2.f);
+		TestEqual(TEXT("Straddling actor keeps its first frame inside the window"), Straddling.RecordedFrames[0].FrameIndex, 4);
+	}
+	TestIntervals(*this, TEXT("Straddling actor"), Straddling, { { 0, 2 }, { 2, 9 }, { 0, 9 }, { 0, 9 }, { 6, 9 } });
+
+	const FRecordActorSaveData& Inside = Actors[2];
+	if (TestEqual(TEXT("Actor inside the window keeps every frame"), Inside.RecordedFrames.Num(), 5))
+	{
+		TestEqual(TEXT("Actor inside the window is rebased too"), Inside.RecordedFrames[0].TimeStamp, 1.f);
+		TestEqual(TEXT("Actor inside the window last timestamp"), Inside.RecordedFrames.Last().TimeStamp, 2.f);
+	}
+	TestIntervals(*this, TEXT("Actor inside the window"), Inside, { { 1, 5 }, { 0, 2 } });
+
+	TestEqual(TEXT("Empty actor stays empty"), Actors[3].RecordedFrames.Num(), 0);
+	TestIntervals(*this, TEXT("Empty actor"), Actors[3], {});
+
+	// A budget longer than the recording keeps everything and does not move the time origin
+	{
+		TArray<FRecordActorSaveData> Short;
+		Short.Add(MakeActor(0.f, 4, { { 0, INT32_MAX }, { 2, 10 } }));
+		BloodStainRecordDataUtils::ClipActorSaveDataByGroup(Short, 10.f, FrameStep);
+		if (TestEqual(TEXT("Short recording frame count"), Short[0].RecordedFrames.Num(), 4))
+		{
+			TestEqual(TEXT("Short recording first timestamp"), Short[0].RecordedFrames[0].TimeStamp, 0.f);
+		}
+		TestIntervals(*this, TEXT("Short recording"), Short[0], { { 0, 4 }, { 2, 4 } });
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,485 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#include "BloodStainTrackUtils.h"
+#include "BloodStainFileOptions.h"
+#include "GhostData.h"
+#include "QuantizationHelper.h"
+#include "QuantizationTypes.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace BloodStainTrackUtilsTest_Internal
+{
+	using BloodStainFileUtils_Internal::FTrackQuantizationParams;
+
+	constexpr int32 NumFrames = 80;
+	constexpr int32 NumBones = 3;
+
+	/** Power of two, so uniform timestamps and the decoded start + index * interval are exact */
+	constexpr float FrameStep = 0.25f;
+	constexpr double StartTime = 0.5;
+
+	/** Location, rotation X / Y / Z (W is rebuilt, not stored) and scale of a transform */
+	constexpr int32 NumComponents = 9;
+
+	const TCHAR* const ComponentNames[NumComponents] = {
+		TEXT("translation X"), TEXT("translation Y"), TEXT("translation Z"),
+		TEXT("rotation X"), TEXT("rotation Y"), TEXT("rotation Z"),
+		TEXT("scale X"), TEXT("scale Y"), TEXT("scale Z") };
+
+	/** Channel groups a track holds at their first value for the whole run */
+	enum EConstantGroup : uint8
+	{
+		ConstantTranslation = 1 << 0,
+		ConstantRotation    = 1 << 1,
+		ConstantScale       = 1 << 2,
+		ConstantAll         = ConstantTranslation | ConstantRotation | ConstantScale
+	};
+
+	/** Randomized smooth motion with per-sample jitter. Rotations stay below 90 degrees, so W is always the dropped component */
+	struct FTrackMotion
+	{
+		FVector Base;
+		FVector Amplitude;
+		FVector Frequency;
+		FVector Phase;
+		FVector AngleAmplitude;
+		FVector AngleFrequency;
+		FVector ScaleAmplitude;
+		uint8 ConstantGroups = 0;
+
+		FTrackMotion(FRandomStream& Random, uint8 InConstantGroups)
+			: ConstantGroups(InConstantGroups)
+		{
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				Base[Axis] = Random.FRandRange(-500.f, 500.f);
+				Amplitude[Axis] = Random.FRandRange(1.f, 200.f);
+				Frequency[Axis] = Random.FRandRange(0.2f, 2.f);
+				Phase[Axis] = Random.FRandRange(0.f, UE_TWO_PI);
+				AngleAmplitude[Axis] = Random.FRandRange(5.f, 25.f);
+				AngleFrequency[Axis] = Random.FRandRange(0.2f, 2.f);
+				ScaleAmplitude[Axis] = Random.FRandRange(0.1f, 0.4f);
+			}
+		}
+
+		FTransform Evaluate(FRandomStream& Random, float Time) const
+		{
+			FVector Location = Base;
+			FRotator Rotator = FRotator::ZeroRotator;
+			FVector Scale = FVector::OneVector;
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				if (!(ConstantGroups & ConstantTranslation))
+				{
+					Location[Axis] += Amplitude[Axis] * FMath::Sin(Frequency[Axis] * Time + Phase[Axis]) + Random.FRandRange(-0.02f, 0.02f);
+				}
+				if (!(ConstantGroups & ConstantScale))
+				{
+					Scale[Axis] += ScaleAmplitude[Axis] * FMath::Sin(Frequency[Axis] * Time);
+				}
+			}
+			if (!(ConstantGroups & ConstantRotation))
+			{
+				Rotator.Pitch = AngleAmplitude.X * FMath::Sin(AngleFrequency.X * Time) + Random.FRandRange(-0.05f, 0.05f);
+				Rotator.Yaw = AngleAmplitude.Y * FMath::Sin(AngleFrequency.Y * Time + 1.0) + Random.FRandRange(-0.05f, 0.05f);
+				Rotator.Roll = AngleAmplitude.Z * FMath::Sin(AngleFrequency.Z * Time + 2.0) + Random.FRandRange(-0.05f, 0.05f);
+			}
+			return FTransform(Rotator.Quaternion(), Location, Scale);
+		}
+	};
+
+	/**
+	 * Two component tracks and a skeletal track. "Prop" skips frames and the last bone is missing from some frames,
+	 * so tracks hold fewer samples than the run has frames.
+	 * @param bUniform Evenly spaced, consecutively indexed frames; otherwise irregular millisecond offsets and skipped indices
+	 * @param bConstantGroups Hold translation / rotation / scale groups of most tracks constant
+	 */
+	TArray<FRecordFrame> MakeFrames(FRandomStream& Random, bool bUniform, bool bConstantGroups)
+	{
+		const FTrackMotion Root(Random, bConstantGroups ? ConstantTranslation | ConstantScale : 0);
+		const FTrackMotion Prop(Random, bConstantGroups ? ConstantAll : 0);
+		const FTrackMotion Bones[NumBones] = {
+			FTrackMotion(Random, bConstantGroups ? ConstantRotation : 0),
+			FTrackMotion(Random, bConstantGroups ? ConstantAll : 0),
+			FTrackMotion(Random, bConstantGroups ? ConstantTranslation : 0) };
+
+		TArray<FRecordFrame> Frames;
+		int32 Milliseconds = 0;
+		int32 FrameIndex = 3;
+		for (int32 Index = 0; Index < NumFrames; ++Index)
+		{
+			FRecordFrame& Frame = Frames.AddDefaulted_GetRef();
+			if (bUniform)
+			{
+				Frame.TimeStamp = static_cast<float>(StartTime) + Index * FrameStep;
+				Frame.FrameIndex = Index;
+			}
+			else
+			{
+				// Matches how the reader rebuilds the timestamp, so the comparison below can be exact
+				Frame.TimeStamp = static_cast<float>(StartTime + Milliseconds / 1000.0);
+				Frame.FrameIndex = FrameIndex;
+				Milliseconds += Random.RandRange(10, 40);
+				FrameIndex += Index % 5 == 0 ? 2 : 1;
+			}
+
+			Frame.ComponentTransforms.Add(TEXT("Root"), Root.Evaluate(Random, Frame.TimeStamp));
+			if (Index % 7 != 3)
+			{
+				Frame.ComponentTransforms.Add(TEXT("Prop"), Prop.Evaluate(Random, Frame.TimeStamp));
+			}
+
+			FBoneComponentSpace& Space = Frame.SkeletalMeshBoneTransforms.Add(TEXT("Body"));
+			const int32 BoneCount = Index % 11 == 5 ? NumBones - 1 : NumBones;
+			for (int32 BoneIndex = 0; BoneIndex < BoneCount; ++BoneIndex)
+			{
+				Space.BoneTransforms.Add(Bones[BoneIndex].Evaluate(Random, Frame.TimeStamp));
+			}
+		}
+		return Frames;
+	}
+
+	/** A component track (BoneIndex INDEX_NONE) or one bone of a skeletal track */
+	struct FTrackKey
+	{
+		FString Name;
+		int32 BoneIndex = INDEX_NONE;
+
+		FString ToString() const
+		{
+			return BoneIndex == INDEX_NONE ? Name : FString::Printf(TEXT("%s bone %d"), *Name, BoneIndex);
+		}
+	};
+
+	const FTransform* FindSample(const FRecordFrame& Frame, const FTrackKey& Key)
+	{
+		if (Key.BoneIndex == INDEX_NONE)
+		{
+			return Frame.ComponentTransforms.Find(Key.Name);
+		}
+		const FBoneComponentSpace* Space = Frame.SkeletalMeshBoneTransforms.Find(Key.Name);
+		return Space && Space->BoneTransforms.IsValidIndex(Key.BoneIndex) ? &Space->BoneTransforms[Key.BoneIndex] : nullptr;
+	}
+
+	void GetTrack(TConstArrayView<FRecordFrame> Frames, const FTrackKey& Key, TArray<const FTransform*>& OutSamples, TBitArray<>& OutPresent)
+	{
+		OutSamples.Reset();
+		OutPresent.Init(false, Frames.Num());
+		for (int32 Index = 0; Index < Frames.Num(); ++Index)
+		{
+			if (const FTransform* Sample = FindSample(Frames[Index], Key))
+			{
+				OutPresent[Index] = true;
+				OutSamples.Add(Sample);
+			}
+		}
+	}
+
+	void GetComponents(const FTransform& T, double* Out)
+	{
+		const FVector Location = T.GetLocation();
+		const FQuat Rotation = T.GetRotation();
+		const FVector Scale = T.GetScale3D();
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			Out[Axis] = Location[Axis];
+			Out[6 + Axis] = Scale[Axis];
+		}
+		Out[3] = Rotation.X;
+		Out[4] = Rotation.Y;
+		Out[5] = Rotation.Z;
+	}
+
+	bool IsBitIdentical(const FTransform& A, const FTransform& B)
+	{
+		const FQuat QA = A.GetRotation();
+		const FQuat QB = B.GetRotation();
+		double ComponentsA[NumComponents];
+		double ComponentsB[NumComponents];
+		GetComponents(A, ComponentsA);
+		GetComponents(B, ComponentsB);
+		return FMemory::Memcmp(ComponentsA, ComponentsB, sizeof(ComponentsA)) == 0 && FMemory::Memcmp(&QA.W, &QB.W, sizeof(QA.W)) == 0;
+	}
+
+	template<typename QuantType>
+	void QuantizeRoundTrip(TConstArrayView<const FTransform*> Samples, const FTrackQuantizationParams& Params, TArray<FTransform>& OutExpected)
+	{
+		TArray<QuantType> Quantized;
+		BloodStainFileUtils_Internal::QuantizeTrack(Samples, Params, Quantized);
+		BloodStainFileUtils_Internal::DequantizeTrack<QuantType>(Quantized, Params, OutExpected);
+	}
+
+	/**
+	 * What a track decodes to without curves: every sample quantized and rebuilt on its own.
+	 * @param OutSteps Value of one channel step for every component; zero for unquantized tracks, which must stay exact.
+	 *                 'Standard_Low' fields are 10 or 11 bits wide, so its translation and scale use the coarser 10 bit step.
+	 */
+	void BuildReference(TConstArrayView<const FTransform*> Samples, ETransformQuantizationMethod Method, int32 SmallestThreeBits, TArray<FTransform>& OutExpected, double* OutSteps)
+	{
+		OutExpected.Reset();
+		const double LocationStep = 1.0 / QuantizedLocationStepsPerUnit;
+		const double ScaleStep = 1.0 / QuantizedScaleStepsPerUnit;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			OutSteps[Axis] = LocationStep;
+			OutSteps[6 + Axis] = ScaleStep;
+		}
+
+		// FQuatFixed32NoW holds X and Y in 11 bits and Z in 10 bits, each over [-1, 1]
+		const double Fixed32Steps[3] = { 1.0 / 1023.0, 1.0 / 1023.0, 1.0 / 511.0 };
+
+		switch (Method)
+		{
+		case ETransformQuantizationMethod::Standard_High:
+			QuantizeRoundTrip<FQuantizedTransform_High>(Samples, FTrackQuantizationParams(), OutExpected);
+			OutSteps[3] = OutSteps[4] = OutSteps[5] = 1.0 / 32767.0;
+			break;
+		case ETransformQuantizationMethod::Standard_Medium:
+			QuantizeRoundTrip<FQuantizedTransform_Compact>(Samples, FTrackQuantizationParams(), OutExpected);
+			FMemory::Memcpy(OutSteps + 3, Fixed32Steps, sizeof(Fixed32Steps));
+			break;
+		case ETransformQuantizationMethod::Standard_SmallestThree:
+			QuantizeRoundTrip<FQuantizedTransform_SmallestThree>(Samples, FTrackQuantizationParams(nullptr, nullptr, SmallestThreeBits), OutExpected);
+			OutSteps[3] = OutSteps[4] = OutSteps[5] = UE_DOUBLE_SQRT_2 / ((1 << SmallestThreeBits) - 1);
+			break;
+		case ETransformQuantizationMethod::Standard_Low:
+			{
+				FLocRange LocRange;
+				FScaleRange ScaleRange;
+				BloodStainFileUtils_Internal::ComputeTrackRanges(Samples, LocRange, ScaleRange);
+				const FTrackQuantizationParams Params(&LocRange, &ScaleRange);
+				QuantizeRoundTrip<FQuantizedTransform_Lowest>(Samples, Params, OutExpected);
+
+				FMemory::Memcpy(OutSteps + 3, Fixed32Steps, sizeof(Fixed32Steps));
+				for (int32 Axis = 0; Axis < 3; ++Axis)
+				{
+					OutSteps[Axis] = Params.Lowest.Ranges[Axis] / 511.0;
+					OutSteps[6 + Axis] = Params.Lowest.ScaleRanges[Axis] / 511.0;
+				}
+				break;
+			}
+		case ETransformQuantizationMethod::None:
+		default:
+			for (const FTransform* Sample : Samples)
+			{
+				OutExpected.Add(*Sample);
+			}
+			FMemory::Memzero(OutSteps, NumComponents * sizeof(double));
+			break;
+		}
+	}
+
+	/**
+	 * Checks a decoded track against its reference: exactly without curves, otherwise every component within Tolerance
+	 * channel steps and inside the range the reference spans, which is the range its channel was packed in.
+	 */
+	bool TestTrack(FAutomationTestBase& Test, const FString& What, TConstArrayView<FTransform> Expected, TConstArrayView<FTransform> Actual, const double* Steps, int32 Tolerance)
+	{
+		if (!Test.TestEqual(What + TEXT(" sample count"), Actual.Num(), Expected.Num()))
+		{
+			return false;
+		}
+
+		if (Tolerance <= 0)
+		{
+			for (int32 Index = 0; Index < Expected.Num(); ++Index)
+			{
+				if (!IsBitIdentical(Actual[Index], Expected[Index]))
+				{
+					Test.AddError(FString::Printf(TEXT("%s sample %d differs: %s vs %s"), *What, Index, *Actual[Index].ToString(), *Expected[Index].ToString()));
+					return false;
+				}
+			}
+			return true;
+		}
+
+		double Min[NumComponents];
+		double Max[NumComponents];
+		for (int32 Component = 0; Component < NumComponents; ++Component)
+		{
+			Min[Component] = MAX_dbl;
+			Max[Component] = -MAX_dbl;
+		}
+		for (const FTransform& Transform : Expected)
+		{
+			double Components[NumComponents];
+			GetComponents(Transform, Components);
+			for (int32 Component = 0; Component < NumComponents; ++Component)
+			{
+				Min[Component] = FMath::Min(Min[Component], Components[Component]);
+				Max[Component] = FMath::Max(Max[Component], Components[Component]);
+			}
+		}
+
+		for (int32 Index = 0; Index < Expected.Num(); ++Index)
+		{
+			double ExpectedComponents[NumComponents];
+			double ActualComponents[NumComponents];
+			GetComponents(Expected[Index], ExpectedComponents);
+			GetComponents(Actual[Index], ActualComponents);
+			for (int32 Component = 0; Component < NumComponents; ++Component)
+			{
+				// Covers float rounding of the dequantized values, far below a step
+				const double Slack = Steps[Component] * 0.01 + UE_DOUBLE_KINDA_SMALL_NUMBER;
+				const double Value = ActualComponents[Component];
+				const double Error = FMath::Abs(Value - ExpectedComponents[Component]);
+				if (Error > Tolerance * Steps[Component] + Slack)
+				{
+					Test.AddError(FString::Printf(TEXT("%s sample %d %s is %.3f steps off (tolerance %d)"),
+						*What, Index, ComponentNames[Component], Steps[Component] > 0.0 ? Error / Steps[Component] : Error, Tolerance));
+					return false;
+				}
+				if (Value < Min[Component] - Slack || Value > Max[Component] + Slack)
+				{
+					Test.AddError(FString::Printf(TEXT("%s sample %d %s %f leaves the packed range [%f, %f]"),
+						*What, Index, ComponentNames[Component], Value, Min[Component], Max[Component]));
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBloodStainTrackRoundTripTest, "BloodStain.Tracks.RoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBloodStainTrackRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace BloodStainTrackUtilsTest_Internal;
+
+	FRandomStream Random(0x42535452);
+
+	const ETransformQuantizationMethod Methods[] = {
+		ETransformQuantizationMethod::None,
+		ETransformQuantizationMethod::Standard_High,
+		ETransformQuantizationMethod::Standard_Medium,
+		ETransformQuantizationMethod::Standard_Low,
+		ETransformQuantizationMethod::Standard_SmallestThree,
+		ETransformQuantizationMethod::Auto };
+
+	// 'Auto' mixes every fixed method across the tracks
+	FTrackQuantizationTable TrackTable;
+	TrackTable.ComponentMethods.Add(TEXT("Root"), ETransformQuantizationMethod::Standard_High);
+	TrackTable.ComponentMethods.Add(TEXT("Prop"), ETransformQuantizationMethod::Standard_Low);
+	TrackTable.BoneMethods.Add(TEXT("Body"), { ETransformQuantizationMethod::Standard_Medium, ETransformQuantizationMethod::Standard_SmallestThree, ETransformQuantizationMethod::None });
+
+	TArray<FTrackKey> Tracks = { { TEXT("Root") }, { TEXT("Prop") } };
+	for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+	{
+		Tracks.Add({ TEXT("Body"), BoneIndex });
+	}
+
+	const int32 SmallestThreeBits = FQuatSmallestThree::DefaultBits;
+
+	for (const bool bUniform : { true, false })
+	{
+		for (const bool bConstantGroups : { false, true })
+		{
+			const TArray<FRecordFrame> Frames = MakeFrames(Random, bUniform, bConstantGroups);
+
+			for (const ETransformQuantizationMethod Method : Methods)
+			{
+				const FTrackQuantizationTable* Table = Method == ETransformQuantizationMethod::Auto ? &TrackTable : nullptr;
+				int32 ExactSize = 0;
+
+				for (const bool bFitCurves : { false, true })
+				{
+					FBloodStainFileOptions Options;
+					Options.QuantizationOption = Method;
+					Options.bFitCurves = bFitCurves;
+					const int32 CurveTolerance = Options.bFitCurves ? Options.CurveMaxError : 0;
+
+					const FString Case = FString::Printf(TEXT("[%s timeline, %s, %s, curves %s]"),
+						bUniform ? TEXT("uniform") : TEXT("millisecond"),
+						bConstantGroups ? TEXT("constant groups") : TEXT("animated"),
+						*StaticEnum<ETransformQuantizationMethod>()->GetNameStringByValue(static_cast<int64>(Method)),
+						bFitCurves ? TEXT("on") : TEXT("off"));
+
+					TArray<uint8> Bytes;
+					FMemoryWriter Writer(Bytes);
+					BloodStainTrackUtils::SerializeTracks(Writer, Frames, Method, Table, SmallestThreeBits, CurveTolerance);
+
+					TArray<FRecordFrame> Decoded;
+					FMemoryReader Reader(Bytes);
+					BloodStainTrackUtils::DeserializeTracks(Reader, Decoded, Method, Table);
+					if (!TestFalse(Case + TEXT(" decodes"), Reader.IsError())
+						|| !TestEqual(Case + TEXT(" consumes every byte"), Reader.Tell(), static_cast<int64>(Bytes.Num()))
+						|| !TestEqual(Case + TEXT(" frame count"), Decoded.Num(), Frames.Num()))
+					{
+						return false;
+					}
+
+					// Curves and reduced precision are only picked when they take fewer bytes
+					if (bFitCurves)
+					{
+						TestTrue(Case + TEXT(" is no larger than without curves"), Bytes.Num() <= ExactSize);
+					}
+					ExactSize = Bytes.Num();
+
+					for (int32 Index = 0; Index < Frames.Num(); ++Index)
+					{
+						if (Decoded[Index].TimeStamp != Frames[Index].TimeStamp || Decoded[Index].FrameIndex != Frames[Index].FrameIndex)
+						{
+							AddError(FString::Printf(TEXT("%s frame %d timeline: %f / %d vs %f / %d"), *Case, Index,
+								Decoded[Index].TimeStamp, Decoded[Index].FrameIndex, Frames[Index].TimeStamp, Frames[Index].FrameIndex));
+							return false;
+						}
+					}
+
+					for (const FTrackKey& Key : Tracks)
+					{
+						const FString What = Case + TEXT(" ") + Key.ToString();
+
+						TArray<const FTransform*> Samples;
+						TBitArray<> Present;
+						GetTrack(Frames, Key, Samples, Present);
+
+						TArray<const FTransform*> DecodedSamples;
+						TBitArray<> DecodedPresent;
+						GetTrack(Decoded, Key, DecodedSamples, DecodedPresent);
+						if (!TestTrue(What + TEXT(" presence"), DecodedPresent == Present))
+						{
+							return false;
+						}
+
+						ETransformQuantizationMethod TrackMethod = Method;
+						if (Table)
+						{
+							TrackMethod = Key.BoneIndex == INDEX_NONE ? Table->GetComponentMethod(Key.Name) : Table->GetBoneMethod(Key.Name, Key.BoneIndex);
+						}
+
+						TArray<FTransform> Expected;
+						double Steps[NumComponents];
+						BuildReference(Samples, TrackMethod, SmallestThreeBits, Expected, Steps);
+
+						TArray<FTransform> Actual;
+						for (const FTransform* Sample : DecodedSamples)
+						{
+							Actual.Add(*Sample);
+						}
+
+						// Unquantized tracks never go through curves
+						const int32 TrackTolerance = TrackMethod == ETransformQuantizationMethod::None ? 0 : CurveTolerance;
+						if (!TestTrack(*this, What, Expected, Actual, Steps, TrackTolerance))
+						{
+							return false;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,86 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Appends values of arbitrary bit width (0..64) to a byte buffer, least significant bit first.
+ * Call Flush() before reading GetBytes(); a partial last byte is zero padded.
+ */
+class BLOODSTAINSYSTEM_API FBloodStainBitWriter
+{
+public:
+	explicit FBloodStainBitWriter(TArray<uint8>& InBytes);
+
+	/** Writes the low NumBits bits of Value */
+	void WriteBits(uint64 Value, int32 NumBits);
+
+	/** Writes out the partially filled byte, if any */
+	void Flush();
+
+	/** Bits written so far, including any not yet flushed */
+	int64 GetNumBits() const { return NumBitsWritten; }
+
+private:
+	TArray<uint8>& Bytes;
+
+	/** Bits not yet written to Bytes, in the low NumPending bits */
+	uint64 Pending = 0;
+	int32 NumPending = 0;
+
+	int64 NumBitsWritten = 0;
+};
+
+/** Reads values written by FBloodStainBitWriter. Reading past the end yields zero bits and sets the overflow flag */
+class BLOODSTAINSYSTEM_API FBloodStainBitReader
+{
+public:
+	FBloodStainBitReader(const uint8* InData, int64 InNumBytes);
+
+	uint64 ReadBits(int32 NumBits);
+
+	/** Moves to an absolute bit position */
+	void Seek(int64 InBitPosition);
+
+	bool IsOverflowed() const { return bOverflowed; }
+
+	int64 GetBitPosition() const { return BitPosition; }
+
+private:
+	const uint8* Data;
+	int64 NumBytes;
+	int64 BitPosition = 0;
+	bool bOverflowed = false;
+};
+
+namespace BloodStainBitStream
+{
+	/** Bytes needed for Count values of Width bits */
+	FORCEINLINE int64 GetPackedSize(int64 Count, int32 Width)
+	{
+		return (Count * Width + 7) / 8;
+	}
+
+	/** Smallest width that holds Value (0 for zero) */
+	FORCEINLINE int32 GetBitWidth(uint64 Value)
+	{
+		return Value == 0 ? 0 : 64 - static_cast<int32>(FPlatformMath::CountLeadingZeros64(Value));
+	}
+
+	/**
+	 * Writes every value with the same Width bits.
+	 * @return Bytes appended to OutBytes
+	 */
+	int64 PackFixedWidth(TConstArrayView<uint64> Values, int32 Width, TArray<uint8>& OutBytes);
+
+	/**
+	 * Unpacks OutValues.Num() values of Width bits. Values are loaded a 64-bit word at a time, so the
+	 * loop has no per-bit branches; the last few values fall back to the bit reader near the end of the buffer.
+	 * @return false if Data is too short
+	 */
+	bool UnpackFixedWidth(const uint8* Data, int64 NumBytes, int32 Width, TArrayView<uint64> OutValues);
+}
@@ -0,0 +1,213 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BloodStainFileOptions.h"
+#include "GhostData.h"
+
+/**
+ * @brief A run of consecutive frames of a single actor, quantized and compressed as an independently decodable unit.
+ *
+ * Block content (before compression):
+ *  - EBloodStainFileVersion::Columnar: the block's FTrackQuantizationTable when the quantization option is 'Auto',
+ *    then per-track columns (BloodStainTrackUtils::SerializeTracks), each track carrying its own ranges.
+ *  - BlockContainer: FActorTransformRanges of the block, the FTrackQuantizationTable when 'Auto',
+ *    then rows (BloodStainFileUtils_Internal::SerializeFrames).
+ */
+struct FEncodedFrameBlock
+{
+	/** Recorder frame index of the first frame in the block */
+	int32 FirstFrameIndex = 0;
+
+	/** Number of frames stored in the block */
+	int32 NumFrames = 0;
+
+	/** Timestamps of the first and last frame, in recorder time */
+	float StartTime = 0.f;
+	float EndTime = 0.f;
+
+	/** Size of the block content before compression */
+	int32 UncompressedSize = 0;
+
+	/** Compressed block content */
+	TArray<uint8> Bytes;
+
+	/** [Not serialized] Per-frame timestamps, used to cut the saved window inside a block without decoding it */
+	TArray<float> FrameTimeStamps;
+
+	/** [Not serialized] Per-frame primary component transform, used to resolve the spawn point without decoding */
+	TArray<FTransform> PrimaryTransforms;
+
+	/** [Not serialized] World-space box around every component location in the block, for the header summary */
+	FBox Bounds = FBox(ForceInit);
+};
+
+/** @brief Encoded frames of one actor, ready to be written into a block container payload */
+struct FEncodedActorData
+{
+	/** Name of the primary (root) component for this actor */
+	FName PrimaryComponentName;
+
+	/** Lifecycle intervals for each component, in saved frame indices */
+	TArray<FComponentActiveInterval> ComponentIntervals;
+
+	/** Subtracted from every decoded timestamp so the saved window starts at zero */
+	float TimeBase = 0.f;
+
+	/** Frames dropped from the front of the first block because they fall before the saved window */
+	int32 SkipFrames = 0;
+
+	/** Number of saved frames, after SkipFrames */
+	int32 NumFrames = 0;
+
+	/** Blocks in frame order */
+	TArray<FEncodedFrameBlock> Blocks;
+
+	/** [Not serialized] Primary component transform of the first saved frame */
+	FTransform FirstPrimaryTransform;
+};
+
+/** @brief Per-actor entry of the block container directory */
+struct FBlockActorDirectoryEntry
+{
+	FName PrimaryComponentName;
+	TArray<FComponentActiveInterval> ComponentIntervals;
+	float TimeBase = 0.f;
+	int32 SkipFrames = 0;
+	int32 NumFrames = 0;
+
+	/** Range of this actor's blocks in the block table */
+	int32 FirstBlock = 0;
+	int32 NumBlocks = 0;
+
+	friend FArchive& operator<<(FArchive& Ar, FBlockActorDirectoryEntry& Entry)
+	{
+		Ar << Entry.PrimaryComponentName;
+		Ar << Entry.ComponentIntervals;
+		Ar << Entry.TimeBase;
+		Ar << Entry.SkipFrames;
+		Ar << Entry.NumFrames;
+		Ar << Entry.FirstBlock;
+		Ar << Entry.NumBlocks;
+		return Ar;
+	}
+};
+
+/** @brief Block table entry: where a block lives in the payload and which frames it covers */
+struct FBlockTableEntry
+{
+	int32 ActorIndex = 0;
+	int32 FirstFrameIndex = 0;
+	int32 NumFrames = 0;
+	float StartTime = 0.f;
+	float EndTime = 0.f;
+
+	/** Offset of the block from the start of the block data section */
+	int64 Offset = 0;
+	int32 CompressedSize = 0;
+	int32 UncompressedSize = 0;
+
+	friend FArchive& operator<<(FArchive& Ar, FBlockTableEntry& Entry)
+	{
+		Ar << Entry.ActorIndex;
+		Ar << Entry.FirstFrameIndex;
+		Ar << Entry.NumFrames;
+		Ar << Entry.StartTime;
+		Ar << Entry.EndTime;
+		Ar << Entry.Offset;
+		Ar << Entry.CompressedSize;
+		Ar << Entry.UncompressedSize;
+		return Ar;
+	}
+};
+
+/**
+ * BloodStainBlockUtils
+ *  - Encode/Decode independently compressed frame blocks
+ *  - Write/Read the block container payload (EBloodStainFileVersion::BlockContainer and later)
+ *
+ *  Container layout: NumActors, directory entries, NumBlocks, block table, block data.
+ *  The directory and block table sit right behind the headers, so a reader can seek to and decode
+ *  only the blocks covering the time range it needs (ReadContainerRange).
+ */
+namespace BloodStainBlockUtils
+{
+	/** Time span (seconds) of a block when a whole recording is encoded at save time */
+	constexpr float SaveBlockDuration = 1.5f;
+
+	/** Upper bound of frames per block at save time, for clips sampled faster than SaveBlockDuration can hold */
+	constexpr int32 SaveBlockMaxFrames = 256;
+
+	/**
+	 * Quantizes and compresses a run of frames into a single block in the latest layout. Ranges are computed per track over the block only.
+	 * @param Frames Frames to encode, in order. They are not modified.
+	 * @param Options Quantization and compression to apply.
+	 * @return Success or failure
+	 */
+	bool EncodeBlock(TConstArrayView<FRecordFrame> Frames, const FBloodStainFileOptions& Options, FEncodedFrameBlock& OutBlock);
+
+	/**
+	 * Decompresses and dequantizes one block, appending its frames to OutFrames.
+	 * @param Version File version the block was written with (EBloodStainFileVersion)
+	 * @return Success or failure
+	 */
+	bool DecodeBlock(const uint8* Data, int64 CompressedSize, int32 UncompressedSize, const FBloodStainFileOptions& Options, uint32 Version, TArray<FRecordFrame>& OutFrames);
+
+	/**
+	 * Splits every actor into blocks spanning BlockDuration seconds (at most MaxBlockFrames frames) and encodes all blocks in parallel.
+	 * Block boundaries depend only on the timestamps, so the output is identical for any number of worker threads.
+	 * @param Actors Cooked actors whose timestamps already start at zero. They are not modified.
+	 * @return false if any block failed to encode
+	 */
+	bool EncodeActors(TConstArrayView<FRecordActorSaveData> Actors, float BlockDuration, int32 MaxBlockFrames, const FBloodStainFileOptions& Options, TArray<FEncodedActorData>& OutActors);
+
+	/** @return Total uncompressed size of all blocks, stored as FBloodStainFileHeader::UncompressedSize */
+	int64 GetUncompressedSize(const TArray<FEncodedActorData>& Actors);
+
+	/** @return Total compressed size of all blocks */
+	int64 GetCompressedSize(const TArray<FEncodedActorData>& Actors);
+
+	/**
+	 * Fills the counts, bounds and preview pose of OutSummary from already encoded actors.
+	 * Their frames are compressed by now, so the preview holds only the primary component of OutSummary.MainActorIndex,
+	 * and the bounds may include frames of the head block that fall before the saved window.
+	 */
+	void BuildHeaderSummary(TConstArrayView<FEncodedActorData> Actors, FRecordHeaderSummary& OutSummary);
+
+	/**
+	 * Writes the block container payload for the given actors.
+	 * @return Total uncompressed size of all blocks, stored as FBloodStainFileHeader::UncompressedSize
+	 */
+	int64 WriteContainer(FArchive& Ar, const TArray<FEncodedActorData>& Actors);
+
+	/**
+	 * Reads a block container payload back into save data.
+	 * Frames before each actor's window are dropped and timestamps are rebased on the actor's TimeBase.
+	 * @return Success or failure
+	 */
+	bool ReadContainer(TConstArrayView<uint8> Payload, const FBloodStainFileOptions& Options, uint32 Version, FRecordSaveData& OutData);
+
+	/**
+	 * Reads the directory and block table at the start of a block container payload, leaving Ar at the block data.
+	 * @param PayloadEnd Position just past the payload in Ar (the end of a loose file, or of a pack entry's payload)
+	 * @return Success or failure
+	 */
+	bool ReadContainerIndex(FArchive& Ar, int64 PayloadEnd, TArray<FBlockActorDirectoryEntry>& OutDirectory, TArray<FBlockTableEntry>& OutBlockTable);
+
+	/**
+	 * Seeks to and decodes only the blocks each actor needs to cover [StartTime, EndTime] (saved time, after TimeBase).
+	 * Every actor keeps its frames from the last one at or before StartTime to the first one at or after EndTime,
+	 * so playback can interpolate across the whole range. Timestamps stay on the saved timeline and
+	 * component intervals are remapped to the kept frames.
+	 * @param Ar Seekable archive holding the payload
+	 * @param BlockDataStart Position of the block data in Ar, as left by ReadContainerIndex
+	 * @param PayloadEnd Position just past the payload in Ar; no block may reach beyond it
+	 * @return Success or failure
+	 */
+	bool ReadContainerRange(FArchive& Ar, int64 BlockDataStart, int64 PayloadEnd, const TArray<FBlockActorDirectoryEntry>& Directory, const TArray<FBlockTableEntry>& BlockTable,
+		const FBloodStainFileOptions& Options, uint32 Version, float StartTime, float EndTime, FRecordSaveData& OutData);
+}
@@ -9,20 +9,49 @@
 namespace BloodStainCompressionUtils
 {
 	/** 
-	 * Compress InBuffer by Options.Compression.Method, Options.Compression.Level 
+	 * Compress InBuffer by Opts
+	 * @param Filter Reversible filter applied before compressing
+	 * @param OodleCompressor Codec used when Opts is Oodle
+	 * @param OodleLevel Effort used when Opts is Oodle, -4 to 9 (see FBloodStainFileOptions::OodleCompressionLevel)
 	 * @return success/failure
 	 */
 	bool CompressBuffer(const TArray<uint8>& InBuffer,
 							  TArray<uint8>& OutCompressed,
-							  ECompressionMethod Opts = ECompressionMethod::None);
+							  ECompressionMethod Opts = ECompressionMethod::None,
+							  ECompressionFilter Filter = ECompressionFilter::None,
+							  EOodleCompressorType OodleCompressor = EOodleCompressorType::Kraken,
+							  int32 OodleLevel = 6);
+
+	/** Compress a raw memory range, e.g. one block of a larger encode buffer */
+	bool CompressBuffer(const uint8* InData, int64 InSize,
+							  TArray<uint8>& OutCompressed,
+							  ECompressionMethod Opts = ECompressionMethod::None,
+							  ECompressionFilter Filter = ECompressionFilter::None,
+							  EOodleCompressorType OodleCompressor = EOodleCompressorType::Kraken,
+							  int32 OodleLevel = 6);
 
 	/**
 	 * Decompress the compressed data InBuffer to the original size (UncompressedSize)
 	 * @param UncompressedSize The value of RawBuffer.Num(), measured right before saving, must be stored in the header or as a separate prefix.
+	 * @param Filter The filter the data was compressed with; it is reversed after decompressing
 	 * @return success/failure
 	 */
 	bool DecompressBuffer(int64 UncompressedSize,
 						  const TArray<uint8>& Compressed,
 						  TArray<uint8>& OutRaw,
-						  ECompressionMethod  Opts = ECompressionMethod::None);
+						  ECompressionMethod  Opts = ECompressionMethod::None,
+						  ECompressionFilter Filter = ECompressionFilter::None);
+
+	/** Decompress a compressed memory range, e.g. one block inside a loaded payload */
+	bool DecompressBuffer(int64 UncompressedSize,
+						  const uint8* CompressedData, int64 CompressedSize,
+						  TArray<uint8>& OutRaw,
+						  ECompressionMethod  Opts = ECompressionMethod::None,
+						  ECompressionFilter Filter = ECompressionFilter::None);
+
+	/** Applies Filter to Size bytes of InData, writing the same number of bytes to OutData. Buffers must not overlap */
+	void ApplyFilter(const uint8* InData, int64 Size, uint8* OutData, ECompressionFilter Filter);
+
+	/** Reverses ApplyFilter. Buffers must not overlap */
+	void ReverseFilter(const uint8* InData, int64 Size, uint8* OutData, ECompressionFilter Filter);
 }
@@ -17,7 +17,40 @@ enum class ECompressionMethod : uint8
 	None  UMETA(DisplayName = "None"),
 	Zlib  UMETA(DisplayName = "Zlib"),
 	Gzip  UMETA(DisplayName = "Gzip"),
-	LZ4   UMETA(DisplayName = "LZ4")  
+	LZ4   UMETA(DisplayName = "LZ4"),
+	Oodle UMETA(DisplayName = "Oodle")
+};
+
+/**
+ * @brief Oodle codecs, fastest to decode first.
+ *
+ * - Selkie: fastest decode, lowest ratio.
+ * - Mermaid: between Selkie and Kraken.
+ * - Kraken: good ratio with fast decode; the usual choice.
+ * - Leviathan: highest ratio, slower decode.
+ */
+UENUM(BlueprintType)
+enum class EOodleCompressorType : uint8
+{
+	Selkie     UMETA(DisplayName = "Selkie"),
+	Mermaid    UMETA(DisplayName = "Mermaid"),
+	Kraken     UMETA(DisplayName = "Kraken"),
+	Leviathan  UMETA(DisplayName = "Leviathan")
+};
+
+/**
+ * @brief Reversible filters applied to the payload right before compression.
+ *
+ * Both treat the buffer as 4-byte elements (floats, int32 and packed fixed-point values) and keep a trailing partial element as is.
+ * - ByteShuffle: groups byte 0 of every element, then byte 1, ... so slowly changing high bytes form long runs.
+ * - BitShuffle: same idea per bit plane, for data whose redundancy is below byte granularity.
+ */
+UENUM(BlueprintType)
+enum class ECompressionFilter : uint8
+{
+	None         UMETA(DisplayName = "None"),
+	ByteShuffle  UMETA(DisplayName = "Byte Shuffle"),
+	BitShuffle   UMETA(DisplayName = "Bit Shuffle")
 };
 
 /**
@@ -27,6 +60,9 @@ enum class ECompressionMethod : uint8
  * - Standard_High: High‑precision quantization (uses FQuantizedTransform_High).
  * - Standard_Medium: Medium quantization (uses FQuantizedTransform_Medium).
  * - Standard_Low: Lowest‑bit quantization (uses FQuantizedTransform_Lowest).
+ * - Auto: Cheapest of the fixed methods per track (component or bone) within the file options' error budget.
+ *         The chosen method of every track is stored in front of the frames (FTrackQuantizationTable).
+ * - Standard_SmallestThree: Medium location/scale with a smallest-three rotation (uses FQuantizedTransform_SmallestThree).
  */
 UENUM(BlueprintType)
 enum class ETransformQuantizationMethod : uint8
@@ -34,7 +70,9 @@ enum class ETransformQuantizationMethod : uint8
 	None,            
 	Standard_High,   
 	Standard_Medium,
-	Standard_Low     
+	Standard_Low,
+	Auto,
+	Standard_SmallestThree
 };
 
 /**
@@ -49,10 +87,96 @@ struct FBloodStainFileOptions
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Compression")
 	ECompressionMethod CompressionOption = ECompressionMethod::Zlib;
 
+	/** Oodle codec when CompressionOption is Oodle. Stored in the file header; decoding does not depend on it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Compression", meta=(EditCondition="CompressionOption==ECompressionMethod::Oodle"))
+	EOodleCompressorType OodleCompressor = EOodleCompressorType::Kraken;
+
+	/**
+	 * Oodle effort when CompressionOption is Oodle: -4 (HyperFast4) to 0 (no compression) to 4 (Normal) to 9 (Optimal5).
+	 * Higher levels only slow down compression, which runs on background saves; decode speed depends on the codec alone.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Compression", meta=(EditCondition="CompressionOption==ECompressionMethod::Oodle", ClampMin="-4", ClampMax="9"))
+	int32 OodleCompressionLevel = 6;
+
+	/** Filter applied before compression. Stored in the file header since EBloodStainFileVersion::Columnar */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Compression")
+	ECompressionFilter CompressionFilter = ECompressionFilter::None;
+
 	/** Quantization settings for bone transforms */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Quantization")
-	ETransformQuantizationMethod QuantizationOption = ETransformQuantizationMethod::Standard_Medium;
-	
+	ETransformQuantizationMethod QuantizationOption = ETransformQuantizationMethod::Standard_Low;
+
+	/**
+	 * Bits per stored rotation component for Standard_SmallestThree, plus 2 bits for the dropped component's index.
+	 * Save-time only: the width is stored with the rotations it applies to.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Quantization", meta=(ClampMin="9", ClampMax="16"))
+	int32 SmallestThreeRotationBits = 10;
+
+	/** Maximum location error per track when QuantizationOption is Auto, in cm. Save-time only */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Quantization", meta=(EditCondition="QuantizationOption==ETransformQuantizationMethod::Auto", ClampMin="0.0"))
+	float AutoQuantizationMaxPositionError = 0.1f;
+
+	/** Maximum rotation error per track when QuantizationOption is Auto, in degrees. Save-time only */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Quantization", meta=(EditCondition="QuantizationOption==ETransformQuantizationMethod::Auto", ClampMin="0.0"))
+	float AutoQuantizationMaxRotationError = 0.5f;
+
+	/**
+	 * Drop frames that playback can rebuild by interpolating their neighbours within the error limits below.
+	 * Save-time only: kept frames store their own timestamps, so nothing is written to the file header.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Keyframes")
+	bool bReduceKeyframes = false;
+
+	/** Maximum location error of a dropped frame, in cm */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Keyframes", meta=(EditCondition="bReduceKeyframes", ClampMin="0.0"))
+	float MaxKeyframePositionError = 0.5f;
+
+	/** Maximum rotation error of a dropped frame, in degrees */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Keyframes", meta=(EditCondition="bReduceKeyframes", ClampMin="0.0"))
+	float MaxKeyframeRotationError = 1.0f;
+
+	/**
+	 * Store the animated channels of quantized tracks as piecewise cubic curves wherever that takes fewer bytes than per-frame values.
+	 * Per-frame channels may also drop to the fewest bits per value their range allows within CurveMaxError.
+	 * Pays off most on long, smooth clips. Lossy on top of the quantization. Requires EBloodStainFileVersion::Columnar.
+	 * Save-time only: every channel records how it is stored. Unquantized tracks are not affected.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Curves")
+	bool bFitCurves = false;
+
+	/** Maximum deviation of a decoded curve or reduced precision channel from its samples, in steps of the channel's quantization grid (0.01 cm for grid translations) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Curves", meta=(EditCondition="bFitCurves", ClampMin="1"))
+	int32 CurveMaxError = 2;
+
+	/**
+	 * Also write a low resolution tier (decimated frames, reduced bone set, coarser quantization) in front of the full data,
+	 * so distant or bulk ghosts can be loaded and played from a fraction of the file. Requires EBloodStainFileVersion::Columnar.
+	 * Save-time only: the tier carries its own quantization. Not written for blocks precooked while recording.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|LowResolution")
+	bool bWriteLowResolutionTier = false;
+
+	/** The tier keeps every Nth frame (and the last one) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|LowResolution", meta=(EditCondition="bWriteLowResolutionTier", ClampMin="1"))
+	int32 LowResolutionFrameStep = 4;
+
+	/** Skeletal tracks of the tier keep only their first N bones (parents come before their children), 0 drops them */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|LowResolution", meta=(EditCondition="bWriteLowResolutionTier", ClampMin="0"))
+	int32 LowResolutionMaxBones = 16;
+
+	/** Quantization of the tier */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|LowResolution", meta=(EditCondition="bWriteLowResolutionTier"))
+	ETransformQuantizationMethod LowResolutionQuantization = ETransformQuantizationMethod::Standard_Low;
+
+	/**
+	 * Append recordings to their level's pack (BloodStainPackUtils) instead of writing one .bin file each,
+	 * so header scans read one directory instead of opening every file. Loose files and pack entries are read alike.
+	 * Save-time only.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Pack")
+	bool bStoreInLevelPack = false;
+
 	friend FArchive& operator<<(FArchive& Ar, FBloodStainFileOptions& Options)
 	{
 		Ar << Options.CompressionOption;
@@ -61,6 +185,29 @@ struct FBloodStainFileOptions
 	}
 };
 
+/**
+ * @brief Payload layout revisions stored in FBloodStainFileHeader::Version
+ */
+namespace EBloodStainFileVersion
+{
+	enum Type : uint32
+	{
+		/** One compressed payload holding every actor's frames row by row */
+		Initial = 1,
+
+		/** Actor directory and block table followed by independently compressed frame blocks */
+		BlockContainer = 2,
+
+		/**
+		 * BlockContainer whose blocks store per-track columns (BloodStainTrackUtils) instead of rows,
+		 * preceded by the size of an optional low resolution tier and the tier itself
+		 */
+		Columnar = 3,
+
+		LatestVersion = Columnar
+	};
+}
+
 /**
  * @brief Header prepended to all BloodStain data files
  */
@@ -69,9 +216,15 @@ struct FBloodStainFileHeader
 {
     GENERATED_BODY()
 
-	/** [Unused] Magic identifier ('RStn') and version */
-    uint32 Magic = 0x5253746E;
-    uint32 Version = 1;
+	/** Magic identifier ('RStn') every BloodStain file starts its header with */
+	static constexpr uint32 ExpectedMagic = 0x5253746E;
+
+	/** Magic identifier read from or written to the file; ExpectedMagic unless the file is not ours or corrupt */
+    uint32 Magic = ExpectedMagic;
+
+	/** Payload layout (EBloodStainFileVersion). Replicated so clients can decode streamed payloads */
+	UPROPERTY()
+    uint32 Version = EBloodStainFileVersion::Initial;
 
 	/** File I/O options */
     UPROPERTY()
@@ -86,6 +239,20 @@ struct FBloodStainFileHeader
 		Ar << Header.Magic;
 		Ar << Header.Version;
 		Ar << Header.Options;
+		if (Header.Version >= EBloodStainFileVersion::Columnar)
+		{
+			Ar << Header.Options.CompressionFilter;
+			if (Header.Options.CompressionOption == ECompressionMethod::Oodle)
+			{
+				Ar << Header.Options.OodleCompressor;
+				Ar << Header.Options.OodleCompressionLevel;
+				if (Ar.IsLoading() && Header.Options.OodleCompressor > EOodleCompressorType::Leviathan)
+				{
+					// Written by a newer codec list or corrupt; no compressor of ours can be assumed
+					Ar.SetError();
+				}
+			}
+		}
 		Ar << Header.UncompressedSize;
 		return Ar;
 	}
@@ -8,24 +8,72 @@
 #include "CoreMinimal.h"
 #include "BloodStainFileOptions.h"
 #include "HAL/PlatformFilemanager.h"
+#include "Async/Future.h"
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
 #include "Serialization/MemoryReader.h"
 #include "GhostData.h"
 
+struct FEncodedActorData;
+
 /**
  * FBloodStainFileUtils
  *  - Serialize/Deserialize Binary of FRecordSavedData
- *  - Save & Load from .bin extension file in Saved/BloodStain folder
+ *  - Save & Load from .bin extension file in Saved/BloodStain folder, or from the level's pack (BloodStainPackUtils)
  */
 namespace BloodStainFileUtils
 {
 	/** 
 	 * Binary Save SaveData to Project/Saved/BloodStain/LevelName/<FileName>.bin
+	 * Frames are written as a block container, encoded and compressed in parallel per block
 	 * @param FileName  without extension
 	 * @return Success or failure
 	 */
 	bool SaveToFile(const FRecordSaveData& SaveData, const FString& LevelName, const FString& FileName, const FBloodStainFileOptions& Options = FBloodStainFileOptions());
+
+	/**
+	 * Binary Save already encoded frame blocks as a block container file (EBloodStainFileVersion::LatestVersion)
+	 * Headers and blocks are streamed through a file writer without an intermediate file-sized buffer
+	 * @param Options   Must match the options the blocks were encoded with
+	 * @param LowResolutionActors Optional low resolution tier, encoded with Options.LowResolutionQuantization and stored in front of the full data
+	 * @return Success or failure
+	 */
+	bool SaveEncodedToFile(const FRecordHeaderData& Header, const TArray<FEncodedActorData>& EncodedActors, const FString& LevelName, const FString& FileName, const FBloodStainFileOptions& Options, const TArray<FEncodedActorData>* LowResolutionActors = nullptr);
+
+	/**
+	 * SaveToFile that encodes on the calling thread and queues the write instead of waiting for it
+	 * @return Resolves on an I/O worker with the result; false when a newer save to the same file superseded it
+	 */
+	TFuture<bool> SaveToFileAsync(const FRecordSaveData& SaveData, const FString& LevelName, const FString& FileName, const FBloodStainFileOptions& Options = FBloodStainFileOptions());
+
+	/**
+	 * SaveEncodedToFile that queues the write instead of waiting for it. Long running tasks chain on the result with Next
+	 * @param LowResolutionActors Optional low resolution tier, empty for none
+	 * @return Resolves on an I/O worker with the result; false when a newer save to the same file superseded it
+	 */
+	TFuture<bool> SaveEncodedToFileAsync(const FRecordHeaderData& Header, TArray<FEncodedActorData>&& EncodedActors, const FString& LevelName, const FString& FileName, const FBloodStainFileOptions& Options, TArray<FEncodedActorData>&& LowResolutionActors = TArray<FEncodedActorData>());
+
+	/**
+	 * Saves the bytes of a whole recording file as received (e.g. uploaded by a client) as a loose file or a level pack entry
+	 * @param Options   Only bStoreInLevelPack is used; the bytes already carry their own headers
+	 * @return Success or failure
+	 */
+	bool SaveFileBytes(const TArray<uint8>& FileBytes, const FString& LevelName, const FString& FileName, const FBloodStainFileOptions& Options);
+
+	/**
+	 * Reads the bytes of a whole recording file (loose file or level pack entry, headers included) on an I/O worker,
+	 * e.g. to upload it. The inverse of SaveFileBytes
+	 * @param OnLoaded  Called on the game thread with the result and the bytes
+	 */
+	void LoadFileBytesAsync(const FString& FileName, const FString& LevelName, TUniqueFunction<void(bool bSuccess, TArray<uint8>&& FileBytes)>&& OnLoaded);
+
+	/**
+	 * Decodes a payload read behind the headers (file or network transfer) according to its file header version
+	 * @param FileHeader Header stored in front of the payload
+	 * @param Payload    Payload bytes exactly as stored in the file
+	 * @return Success or failure
+	 */
+	bool DecodePayload(const FBloodStainFileHeader& FileHeader, TConstArrayView<uint8> Payload, FRecordSaveData& OutData);
 	/**
 	 * Project/Saved/BloodStain/<FileName>.bin 에서 이진 로드하여 OutData에 채움
 	 * @param OutData   읽어들인 데이터를 담을 구조체 (empty여도 덮어쓰기)
@@ -36,6 +84,27 @@ namespace BloodStainFileUtils
 
 	bool LoadFromFile(const FString& RelativeFilePath, FRecordSaveData& OutData);
 
+	/**
+	 * LoadFromFile without blocking the caller: the file is read at Interactive priority and decoded on a worker
+	 * @param OnLoaded  Called on the game thread with the result and the decoded recording
+	 */
+	void LoadFromFileAsync(const FString& FileName, const FString& LevelName, TUniqueFunction<void(bool bSuccess, FRecordSaveData&& Data)>&& OnLoaded);
+
+	/**
+	 * Loads only the part of a recording covering [StartTime, EndTime] (seconds from the start of the replay).
+	 * Block container files read just the block index and the blocks overlapping the range; older files are loaded whole and cut.
+	 * Every actor keeps the frames bracketing the range, with timestamps left on the replay timeline.
+	 * @return Success or failure
+	 */
+	bool LoadTimeRangeFromFile(const FString& FileName, const FString& LevelName, float StartTime, float EndTime, FRecordSaveData& OutData);
+
+	/**
+	 * Loads only the low resolution tier of a recording (see FBloodStainFileOptions::bWriteLowResolutionTier).
+	 * Reads the headers and the tier, never the full data stored behind it.
+	 * @return false if the file has no tier or it cannot be read
+	 */
+	bool LoadLowResolutionFromFile(const FString& FileName, const FString& LevelName, FRecordSaveData& OutData);
+
 	/**
 	 * @brief Directly loads the header and compressed original data payload from the file.
 	 * @param FileName Name of the file
@@ -56,6 +125,15 @@ namespace BloodStainFileUtils
 	int32 LoadHeadersForAllFilesInLevel(TMap<FString, FRecordHeaderData>& OutLoadedHeaders, const FString& LevelName);
 
 	int32 LoadHeadersForAllFiles(TMap<FString, FRecordHeaderData>& OutLoadedHeaders);
+
+	/**
+	 * LoadHeadersForAllFilesInLevel without blocking: the directories are enumerated and read on an I/O worker
+	 * @param OnLoaded  Called on the game thread with the headers, keyed like LoadHeadersForAllFilesInLevel
+	 */
+	void LoadHeadersForAllFilesInLevelAsync(const TArray<FString>& LevelNames, TUniqueFunction<void(TMap<FString, FRecordHeaderData>&& LoadedHeaders)>&& OnLoaded);
+
+	/** LoadHeadersForAllFiles without blocking. @param OnLoaded Called on the game thread with the headers */
+	void LoadHeadersForAllFilesAsync(TUniqueFunction<void(TMap<FString, FRecordHeaderData>&& LoadedHeaders)>&& OnLoaded);
 	
 	/**
 	 * Finds and loads all recording files from the save directory.
@@ -68,13 +146,26 @@ namespace BloodStainFileUtils
 
 	int32 LoadAllFiles(TMap<FString, FRecordSaveData>& OutLoadedDataMap);
 	
+	/** Deletes a loose recording file, or removes a packed one and queues a background compaction of its pack when worthwhile */
 	bool DeleteFile(const FString& FileName, const FString& LevelName);
 
+	/**
+	 * Rewrites a level's pack without the data of removed and replaced entries. Blocks until done.
+	 * @return false if the level has no pack or compaction failed
+	 */
+	bool CompactLevelPack(const FString& LevelName);
+
 	bool FileExists(const FString& FileName, const FString& LevelName);
 
 	TArray<FString> GetSavedLevelNames();
 
 	TArray<FString> GetSavedFileNames(const FString& LevelName);
+
+	/** GetSavedLevelNames without blocking. @param OnFound Called on the game thread with the level names */
+	void GetSavedLevelNamesAsync(TUniqueFunction<void(TArray<FString>&& LevelNames)>&& OnFound);
+
+	/** GetSavedFileNames without blocking. @param OnFound Called on the game thread with the file names */
+	void GetSavedFileNamesAsync(const FString& LevelName, TUniqueFunction<void(TArray<FString>&& FileNames)>&& OnFound);
 	
 	FString GetFullFilePath(const FString& FileName, const FString& LevelName);
 
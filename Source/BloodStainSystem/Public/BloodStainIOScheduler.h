@@ -0,0 +1,107 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Event.h"
+#include "Templates/Function.h"
+#include "Templates/UniquePtr.h"
+
+class FQueuedThreadPool;
+
+/**
+ * @brief Priority classes of replay file I/O, highest first
+ */
+enum class EBloodStainIOPriority : uint8
+{
+	/** Loads someone is waiting on right now (starting a replay, uploading a file) */
+	Interactive,
+
+	/** Header scans and other reads that only warm up data */
+	Prefetch,
+
+	/** Writing recordings */
+	Save,
+
+	/** Deleting and other housekeeping */
+	Maintenance,
+
+	Num
+};
+
+/**
+ * Process-wide scheduler for replay file I/O.
+ *
+ * Requests are queued per priority class and run on the scheduler's own thread pool, never on task graph workers,
+ * so callers blocked on a request cannot starve the threads that would run it. At most MaxConcurrentRequests run at once,
+ * plus ReservedInteractiveRequests slots only Interactive requests may take, so a load someone waits on never queues
+ * behind saves and compactions. Higher classes always start first; within a class requests run FIFO.
+ * A queued save to a path that already has a queued save replaces it; the replaced save resolves with false (not written).
+ * Background classes (Save, Maintenance) apply backpressure: off the game thread, Submit blocks while the class is full.
+ */
+class BLOODSTAINSYSTEM_API FBloodStainIOScheduler
+{
+public:
+	static FBloodStainIOScheduler& Get();
+
+	/**
+	 * Queues Work to run on an I/O worker.
+	 * @param CoalesceKey Non-empty keys let a newer Save request replace a queued one with the same key (usually the file path)
+	 * @return Future resolved with the result of Work, or with false if a newer request with the same key replaced it
+	 */
+	TFuture<bool> Submit(EBloodStainIOPriority Priority, TUniqueFunction<bool()>&& Work, const FString& CoalesceKey = FString());
+
+	/**
+	 * Queues Work and blocks until it has run. Runs inline if called from an I/O worker, so nested requests cannot deadlock.
+	 * Workers of long background jobs should chain on Submit's future instead of blocking here.
+	 * @return Result of Work
+	 */
+	bool SubmitAndWait(EBloodStainIOPriority Priority, TUniqueFunction<bool()>&& Work, const FString& CoalesceKey = FString());
+
+	/** Number of requests waiting in a class */
+	int32 GetQueueDepth(EBloodStainIOPriority Priority) const;
+
+	/** Requests of any class allowed to run at once */
+	static constexpr int32 MaxConcurrentRequests = 2;
+
+	/** Extra slots only Interactive requests may use */
+	static constexpr int32 ReservedInteractiveRequests = 1;
+
+	/** Queued requests per background class before Submit starts blocking */
+	static constexpr int32 MaxQueuedBackgroundRequests = 8;
+
+private:
+	FBloodStainIOScheduler();
+	~FBloodStainIOScheduler();
+
+	struct FRequest
+	{
+		TUniqueFunction<bool()> Work;
+		FString CoalesceKey;
+		TArray<TPromise<bool>> Promises;
+		double QueuedTime = 0.0;
+	};
+
+	/** Starts queued requests while there is a free slot. Must be called with Lock held */
+	void Pump_Locked();
+
+	/** Runs one request on a worker, then frees its slot */
+	void Execute(TUniquePtr<FRequest> Request);
+
+	mutable FCriticalSection Lock;
+
+	TArray<TUniquePtr<FRequest>> Queues[static_cast<int32>(EBloodStainIOPriority::Num)];
+
+	int32 NumRunning = 0;
+
+	/** One thread per slot, so a started request never waits for a thread. Null without multithreading */
+	TUniquePtr<FQueuedThreadPool> ThreadPool;
+
+	/** Signalled whenever a request leaves a queue, to release callers held back by backpressure */
+	FEventRef QueueDrainedEvent;
+};
@@ -0,0 +1,132 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Templates/Function.h"
+
+/** @brief One recording stored in a level pack */
+struct FBloodStainPackEntry
+{
+	/** Recording name, without extension */
+	FString Name;
+
+	/** Position of the recording's size-prefixed header block in the data segment */
+	int64 HeaderOffset = 0;
+
+	/** Size of the header block, including its size prefix */
+	int32 HeaderSize = 0;
+
+	/** Size of the payload that follows the header block */
+	int64 PayloadSize = 0;
+
+	/** Tags of the record header, for filtering without parsing HeaderBytes */
+	FGameplayTagContainer Tags;
+
+	/** Copy of the header block, so header scans never touch the data segment */
+	TArray<uint8> HeaderBytes;
+
+	int64 GetPayloadOffset() const { return HeaderOffset + HeaderSize; }
+	int64 GetTotalSize() const { return HeaderSize + PayloadSize; }
+};
+
+/** @brief Live entries of a level pack, rebuilt by replaying its directory journal */
+struct FBloodStainPackDirectory
+{
+	/** Generation of the data segment the entries point into; bumped by every compaction */
+	int32 Generation = 0;
+
+	TMap<FString, FBloodStainPackEntry> Entries;
+
+	/** Bytes of the data segment referenced by live entries */
+	int64 LiveBytes = 0;
+
+	/** Bytes of the data segment left behind by removed or replaced entries and failed appends */
+	int64 DeadBytes = 0;
+
+	/** Journal records that no longer describe a live entry */
+	int32 NumStaleRecords = 0;
+};
+
+/**
+ * BloodStainPackUtils
+ *  - Optional per-level container that stores many recordings in two files instead of one .bin file each
+ *
+ *  Files, inside the level's save directory:
+ *   - Recordings.bspackdir: directory journal. Magic, pack version and data generation, then one record per change:
+ *     an added entry (name, header offset, header size, payload size, tags, header bytes) or a removed name.
+ *     Every record is framed by its size and a CRC32 of its body. Later records override earlier ones;
+ *     a record with a bad checksum is skipped, and a torn record at the end (crash during an append)
+ *     is ignored by readers and cut off by the next writer before it appends.
+ *   - Recordings.<Generation>.bspack: append-only data segment. Every entry holds the exact bytes a loose .bin file would.
+ *
+ *  Writers are serialized in-process. Readers take no writer lock: data is appended before its directory record,
+ *  and compaction writes a new generation next to the old one and keeps the previous segment until the next compaction.
+ *  Parsed directories are cached per pack, so lookups only stat the journal unless another process changed it.
+ *  All functions do blocking file I/O; call them through FBloodStainIOScheduler.
+ */
+namespace BloodStainPackUtils
+{
+	/** Compaction runs once removed data reaches this size and a quarter of the data segment */
+	constexpr int64 CompactionMinDeadBytes = 4 * 1024 * 1024;
+
+	/** ...or once the journal holds at least this many stale records and more stale than live ones */
+	constexpr int32 CompactionMinStaleRecords = 256;
+
+	/** @return Path of the directory journal of the pack in LevelDir */
+	FString GetDirectoryPath(const FString& LevelDir);
+
+	/** @return Path of a data segment generation of the pack in LevelDir */
+	FString GetDataPath(const FString& LevelDir, int32 Generation);
+
+	/** @return true if LevelDir has a pack */
+	bool HasPack(const FString& LevelDir);
+
+	/**
+	 * Copies the replayed directory journal. Parses are cached per pack and only redone once the journal's size or timestamp changes;
+	 * appends and removals of this process update the cached directory in place.
+	 * @return false if there is no pack or its directory is not readable
+	 */
+	bool ReadDirectory(const FString& LevelDir, FBloodStainPackDirectory& OutDirectory);
+
+	/**
+	 * Looks up one entry in the cached directory, without copying the others
+	 * @param OutGeneration Data generation the entry points into
+	 * @return false if the pack has no entry of that name
+	 */
+	bool FindEntry(const FString& LevelDir, const FString& Name, FBloodStainPackEntry& OutEntry, int32& OutGeneration);
+
+	/** @return true if the pack has an entry of that name */
+	bool HasEntry(const FString& LevelDir, const FString& Name);
+
+	/**
+	 * Appends a recording to the pack, creating the pack if needed. An entry with the same name is replaced.
+	 * @param HeaderBytes The size-prefixed header block of the recording
+	 * @param WritePayload Writes the payload after the header block. Must leave the archive at the payload's end
+	 * @return Success or failure. A failed append leaves dead bytes behind but never a visible entry
+	 */
+	bool AppendEntry(const FString& LevelDir, const FString& Name, TConstArrayView<uint8> HeaderBytes, const FGameplayTagContainer& Tags, TFunctionRef<bool(FArchive&)> WritePayload);
+
+	/**
+	 * Appends a removal record for Name. Its bytes are reclaimed by the next compaction
+	 * @return false if the pack has no entry of that name or the record could not be written
+	 */
+	bool RemoveEntry(const FString& LevelDir, const FString& Name);
+
+	/** @return true if the pack has enough dead bytes or stale records to be worth compacting */
+	bool ShouldCompact(const FBloodStainPackDirectory& Directory);
+
+	/** ShouldCompact for the cached directory of the pack in LevelDir; false if there is no pack */
+	bool ShouldCompact(const FString& LevelDir);
+
+	/**
+	 * Copies the live entries into a new data segment generation and rewrites the directory with only their records.
+	 * The segment before the replaced one is deleted.
+	 * @return Success or failure. On failure the pack is left as it was
+	 */
+	bool Compact(const FString& LevelDir);
+}
@@ -0,0 +1,78 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FQuatSmallestThree;
+struct FQuantizedTransform_SmallestThree;
+
+/**
+ * BloodStainQuantizationKernels
+ *  - Quantize / dequantize kernels on UE's VectorRegister abstraction (SSE / AVX / NEON, FPU fallback elsewhere)
+ *
+ *  Every kernel has a scalar *_Reference counterpart built from the same IEEE operations in the same order
+ *  (multiply, add, divide, floor, sqrt; horizontal sums are done pairwise in both), so the two are bit-identical
+ *  and the reference can verify the vector path. No fused multiply-add is used on either side.
+ *  Fixed-point fields owned by the engine (FQuatFixed48NoW, FQuatFixed32NoW, FVectorIntervalFixed32NoW)
+ *  keep the engine's own scalar packing; the batch kernels below carry cycle stats so the grid lanes can be
+ *  compared against them (and against the *_Reference loops) in a profile.
+ */
+namespace BloodStainQuantizationKernels
+{
+	/** Rounds every component of V to the nearest multiple of 1 / StepsPerUnit, halves rounding up (QuantizeToGrid) */
+	FORCEINLINE FVector SnapToGrid(const FVector& V, double StepsPerUnit)
+	{
+		const VectorRegister4Double Steps = VectorSetFloat1(StepsPerUnit);
+		const VectorRegister4Double Scaled = VectorMultiply(VectorLoadFloat3(&V.X), Steps);
+		const VectorRegister4Double Rounded = VectorFloor(VectorAdd(Scaled, VectorSetFloat1(0.5)));
+
+		FVector Out;
+		VectorStoreFloat3(VectorDivide(Rounded, Steps), &Out.X);
+		return Out;
+	}
+
+	FORCEINLINE double SnapToGrid_Reference(double Value, double StepsPerUnit)
+	{
+		const double Scaled = Value * StepsPerUnit;
+		const double Rounded = FMath::FloorToDouble(Scaled + 0.5);
+		return Rounded / StepsPerUnit;
+	}
+
+	FORCEINLINE FVector SnapToGrid_Reference(const FVector& V, double StepsPerUnit)
+	{
+		return FVector(SnapToGrid_Reference(V.X, StepsPerUnit), SnapToGrid_Reference(V.Y, StepsPerUnit), SnapToGrid_Reference(V.Z, StepsPerUnit));
+	}
+
+	/**
+	 * Batch SnapToGrid over whole tracks. Every component goes through the same arithmetic, so the vectors are
+	 * walked as a flat run of doubles, four per register. In and Out must have the same length and may alias.
+	 */
+	void SnapToGrid(TConstArrayView<FVector> In, double StepsPerUnit, TArrayView<FVector> Out);
+
+	void SnapToGrid_Reference(TConstArrayView<FVector> In, double StepsPerUnit, TArrayView<FVector> Out);
+
+	/** Grid counts of grid-snapped values, FMath::RoundToInt64(Value * StepsPerUnit). Quantizes the translation / scale channels of a track */
+	void GridValuesToCounts(TConstArrayView<double> Values, double StepsPerUnit, TArrayView<int64> OutCounts);
+
+	void GridValuesToCounts_Reference(TConstArrayView<double> Values, double StepsPerUnit, TArrayView<int64> OutCounts);
+
+	/** Values of grid counts, Count / StepsPerUnit. Dequantizes the translation / scale channels of a track */
+	void GridCountsToValues(TConstArrayView<int64> Counts, double StepsPerUnit, TArrayView<double> OutValues);
+
+	void GridCountsToValues_Reference(TConstArrayView<int64> Counts, double StepsPerUnit, TArrayView<double> OutValues);
+
+	/** Rebuilds one smallest-three rotation. Also the reference of the rotation lanes of DequantizeTransforms */
+	FQuat DequantizeSmallestThree_Reference(const FQuatSmallestThree& Rotation);
+
+	/**
+	 * Rebuilds N smallest-three transforms and appends them to OutTransforms.
+	 * Rotations are decoded four at a time, one quaternion component per register.
+	 */
+	void DequantizeTransforms(TConstArrayView<FQuantizedTransform_SmallestThree> Quantized, TArray<FTransform>& OutTransforms);
+
+	void DequantizeTransforms_Reference(TConstArrayView<FQuantizedTransform_SmallestThree> Quantized, TArray<FTransform>& OutTransforms);
+}
@@ -10,6 +10,7 @@
 struct FRecordFrame;
 struct FComponentActiveInterval;
 struct FRecordActorSaveData;
+struct FRecordHeaderSummary;
 
 namespace BloodStainRecordDataUtils
 {
@@ -19,15 +20,74 @@ namespace BloodStainRecordDataUtils
 	bool CookQueuedFrames(float SamplingInterval, const float& ClipStartTime, TCircularQueue<FRecordFrame>* FrameQueuePtr, FRecordActorSaveData& OutGhostSaveData, TArray<FComponentActiveInterval>& OutComponentIntervals);
 	void BuildInitialComponentStructure(int32 FirstFrameIndex, FRecordActorSaveData& OutGhostSaveData, TArray<FComponentActiveInterval>& OutComponentIntervals);
 
+	/**
+	 * Remaps recorder intervals (recorder frame indices) to saved frame indices [0, NumSavedFrames)
+	 * when the frames themselves are not available, e.g. they are already encoded into blocks.
+	 */
+	void BuildInitialComponentStructure(int32 FirstFrameIndex, int32 NumSavedFrames, TArray<FComponentActiveInterval>& OutComponentIntervals, TArray<FComponentActiveInterval>& OutSavedIntervals);
+
+
 
+	/**
+	 * @brief Removes frames whose component and bone transforms can be rebuilt by interpolating
+	 *        the surrounding kept frames, the same way UPlayComponent does at playback.
+	 *        The first and last frame and frames next to component interval boundaries are always kept.
+	 *        Component intervals are remapped to the remaining frame indices.
+	 *
+	 * @param MaxPositionError      Maximum location error of a removed frame (cm).
+	 * @param MaxRotationError      Maximum rotation error of a removed frame (degrees).
+	 * @return Number of removed frames
+	 */
+	int32 ReduceKeyframes(FRecordActorSaveData& ActorData, float MaxPositionError, float MaxRotationError);
 
 	/**
 	 * @brief Clips each actor’s saved data in ActorSaveDataArray to the last N seconds
 	 *        according to the group’s maximum recording time and sampling interval.
+	 *        Frames are trimmed in place, timestamps are rebased onto the window start
+	 *        and component intervals are shifted and clamped to the kept slice.
 	 *
 	 * @param ActorSaveDataArray    The array of FRecordActorSaveData to be processed.
 	 * @param MaxGroupRecordTime    The maximum recording duration for the entire group (in seconds).
 	 * @param SamplingInterval      The sampling interval used when recording (in seconds).
 	 */	
 	void ClipActorSaveDataByGroup(TArray<FRecordActorSaveData>& Actors, float MaxGroupRecordTime, float SamplingInterval);
+
+	/**
+	 * @brief Shifts component intervals (saved frame indices) onto the slice [FirstFrame, FirstFrame + NumFrames)
+	 *        and clamps them to it. Intervals that end up empty are removed.
+	 */
+	void SliceComponentIntervals(TArray<FComponentActiveInterval>& Intervals, int32 FirstFrame, int32 NumFrames);
+
+	/**
+	 * @brief Keeps the frames from the last one at or before StartTime to the first one at or after EndTime,
+	 *        so playback can interpolate across the whole range, and slices the component intervals to match.
+	 *        Timestamps are left unchanged.
+	 *
+	 * @param FirstSavedFrame       Saved frame index of RecordedFrames[0], when the frames are already a slice of the actor.
+	 */
+	void TrimToTimeRange(FRecordActorSaveData& ActorData, float StartTime, float EndTime, int32 FirstSavedFrame = 0);
+
+	/**
+	 * @brief Builds the low resolution tier of an actor: every FrameStep-th frame plus the last one,
+	 *        skeletal tracks cut to their first MaxBones bones. Component intervals are remapped to the kept frames
+	 *        and never dropped, so the tier reconstructs the same components as the full data.
+	 */
+	void BuildLowResolutionTier(const FRecordActorSaveData& ActorData, int32 FrameStep, int32 MaxBones, FRecordActorSaveData& OutTier);
+
+	/** Largest deviation (seconds) from the ideal grid a timestamp may have for its timeline to count as uniform */
+	constexpr float UniformTimelineTolerance = 0.0005f;
+
+	/**
+	 * @brief Finds the spacing of an evenly sampled timeline, where every
+	 *        Frames[i].TimeStamp is within UniformTimelineTolerance of Frames[0].TimeStamp + i * Interval.
+	 *
+	 * @return The interval (seconds), or 0 if there are fewer than two frames or the timeline is not uniform.
+	 */
+	float FindUniformFrameInterval(TConstArrayView<FRecordFrame> Frames);
+
+	/**
+	 * @brief Fills the counts, world bounds and preview pose of OutSummary from cooked actors.
+	 *        The preview pose is the first frame of Actors[OutSummary.MainActorIndex]; sizes and quantization are left untouched.
+	 */
+	void BuildHeaderSummary(TConstArrayView<FRecordActorSaveData> Actors, FRecordHeaderSummary& OutSummary);
 };
@@ -22,6 +22,8 @@ struct FGameplayTagContainer;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnBuildRecordingHeader, FName, GroupName);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnBloodStainReadyOnClient, ABloodStainActor*, ReadyActor);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnRecordingFinalized, FName, GroupName, bool, bSuccess, const FRecordHeaderData&, Header);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHeadersLoaded, int32, HeaderCount);
 
 struct FIncomingClientFile
 {
@@ -54,6 +56,10 @@ struct FBloodStainRecordGroup
 	UPROPERTY()
 	FBloodStainRecordOptions RecordOptions;
 
+	/** File options captured when the group started; pre-cooked blocks are encoded with these */
+	UPROPERTY()
+	FBloodStainFileOptions FileOptions;
+
 	/** Map of actors currently being recorded to their URecordComponent instances */
 	UPROPERTY()
 	TMap<TObjectPtr<AActor>, TObjectPtr<URecordComponent>> ActiveRecorders;
@@ -74,6 +80,20 @@ struct FBloodStainPlaybackGroup
 	/** Set of currently active replay actors */
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category="BloodStain|Replay")
 	TArray<TObjectPtr<AReplayActor>> ActiveReplayers;
+
+	/** True while the group plays the file's low resolution tier */
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category="BloodStain|Replay")
+	bool bIsLowResolution = false;
+
+	/** True while the full data of a low resolution group is loading in the background */
+	bool bFullResolutionLoading = false;
+
+	/** File the group plays, used to load the full data on upgrade */
+	FString FileName;
+	FString LevelName;
+
+	/** Index into the recording's actor data of each entry of ActiveReplayers */
+	TArray<int32> ReplayerActorIndices;
 };
 
 USTRUCT()
@@ -207,6 +227,17 @@ public:
 	bool StartReplayFromFile(APlayerController* RequestingController, const FString& FileName, const FString& LevelName, FGuid& OutGuid, FBloodStainPlaybackOptions
 	                         PlaybackOptions = FBloodStainPlaybackOptions());
 
+	/**
+	 *  @brief Switches a replay started from the low resolution tier to the full data, keeping its playback time.
+	 *  Called automatically when a ghost comes within FBloodStainPlaybackOptions::FullResolutionDistance of the camera.
+	 *  Unless the full data is cached it is loaded in the background; the group keeps playing the tier and
+	 *  is switched on the game thread once the load completes.
+	 *  
+	 *  @return True if the replay plays full data or its load has started
+	 */
+	UFUNCTION(BlueprintCallable, Category="BloodStain|Replay")
+	bool UpgradeReplayToFullResolution(FGuid PlaybackKey);
+
 	UFUNCTION(BlueprintCallable, Category="BloodStain|Replay")
 	bool IsPlaying(const FGuid& InPlaybackKey) const;
 	
@@ -280,6 +311,17 @@ public:
 	 */
 	UFUNCTION(BlueprintCallable, Category="BloodStain|File")
 	void LoadAllHeaders();
+
+	/**
+	 *	LoadAllHeadersInLevels without blocking the game thread: the files are found and read on an I/O worker,
+	 *	then the cache is replaced and OnHeadersLoaded is broadcast.
+	 */
+	UFUNCTION(BlueprintCallable, Category="BloodStain|File")
+	void LoadAllHeadersInLevelsAsync(const TArray<FString>& LevelNames);
+
+	/** LoadAllHeaders without blocking the game thread. OnHeadersLoaded is broadcast once the cache is filled */
+	UFUNCTION(BlueprintCallable, Category="BloodStain|File")
+	void LoadAllHeadersAsync();
 	
 	/**
 	 *  Loads full replay data (header) for a file, loading it from disk it not already cached
@@ -398,10 +440,13 @@ private:
 	                           & FileHeader, const FRecordHeaderData& RecordHeader, const TArray<uint8>& CompressedPayload, const
 	                           FBloodStainPlaybackOptions& PlaybackOptions, FGuid& OutGuid);
 	
-	/** Internal helper to package actor-specific data into the final save format.
-	 *  Aggregates multiple FRecordActorSaveData instances into a single FRecordSaveData.
+	/** Internal helper to prefill the save data header from the group options.
+	 *  Actor data and the spawn point are filled in later by FSaveRecordingTask.
 	 */
-	FRecordSaveData ConvertToSaveData(float EndTime, const FName& GroupName, const FName& FileName, const FName& LevelName, TArray<FRecordActorSaveData>& RecordActorDataArray);
+	FRecordSaveData ConvertToSaveData(float EndTime, const FName& GroupName, const FName& FileName, const FName& LevelName);
+
+	/** Hands the full data to every replayer of a low resolution group, if the group still exists */
+	void ApplyFullResolutionData(FGuid PlaybackKey, const FRecordSaveData& FullData);
 
 	/** @return true if a recording group is still valid */
 	bool IsValidReplayGroup(const FName& GroupName);
@@ -435,6 +480,14 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "BloodStain|File")
 	FOnBuildRecordingHeader OnCompleteBuildRecordingHeader;
 
+	/** Broadcast on the game thread once a stopped recording has been cooked and written, with the final header */
+	UPROPERTY(BlueprintAssignable, Category = "BloodStain|File")
+	FOnRecordingFinalized OnRecordingFinalized;
+
+	/** Broadcast on the game thread once LoadAllHeadersInLevelsAsync or LoadAllHeadersAsync has filled the header cache */
+	UPROPERTY(BlueprintAssignable, Category = "BloodStain|File")
+	FOnHeadersLoaded OnHeadersLoaded;
+
 	/** Distance to trace downwards to find the ground when spawning a BloodStainActor. */
 	static float LineTraceLength;
 
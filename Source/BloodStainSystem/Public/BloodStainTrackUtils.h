@@ -0,0 +1,59 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BloodStainFileOptions.h"
+#include "QuantizationTypes.h"
+
+/**
+ * BloodStainTrackUtils
+ *  - Serialize/Deserialize a run of frames as per-track columns (EBloodStainFileVersion::Columnar)
+ *
+ *  Layout: NumFrames, timeline,
+ *          component name table, then per component track: presence bits, translation / rotation / scale columns,
+ *          skeletal name table, then per skeletal track: presence bits, bone counts of present frames,
+ *          and per bone track the translation / rotation / scale columns of the frames that have that bone.
+ *
+ *  Names are written once per run instead of once per frame, and each column holds samples of a single kind,
+ *  which is what the general-purpose compressor behind it needs to find redundancy.
+ *
+ *  Quantized columns are split into integer channels (three per translation, rotation and scale) and every channel
+ *  is stored as residuals from a temporal predictor (previous sample or linear extrapolation). Residuals are either
+ *  bit-packed with a per-channel width (FBloodStainBitWriter) or zig-zag varints; the predictor and width that give
+ *  the fewest bytes are stored in the channel header. Unquantized tracks keep raw columns.
+ *  Channels of long, smooth motion can instead be stored as piecewise cubic Bezier curves (segment lengths, knot values
+ *  and inner control points, each a residual channel of its own) that decode within a given number of quantization steps
+ *  of every sample; curves are evaluated in integers while decoding, and only used where they take fewer bytes.
+ *  'Standard_SmallestThree' tracks carry four rotation channels (dropped index and three components)
+ *  and store their rotation width in one byte ahead of the channels.
+ *  'Standard_Low' tracks are quantized against their own range (one per component and per bone),
+ *  stored as float bounds ahead of the channels.
+ *
+ *  Uniformly sampled, consecutively indexed runs store their timeline as start time, interval and first frame index;
+ *  other runs store millisecond offsets from the start time and frame indices as predicted channels.
+ *
+ *  Every track starts with a mask of its translation / rotation / scale groups that stay within a small tolerance
+ *  of their first sample over the run; those groups are stored once instead of once per frame.
+ */
+namespace BloodStainTrackUtils
+{
+	/**
+	 * Writes Frames as per-track columns.
+	 * @param QuantOpts The quantization method applied to every transform.
+	 * @param TrackTable Per-track methods, required when QuantOpts is 'Auto'.
+	 * @param SmallestThreeBits Rotation width of 'Standard_SmallestThree' tracks, stored with each such track.
+	 * @param CurveTolerance If positive, quantized channels may be stored as curves or at reduced precision within this many steps of their samples.
+	 */
+	void SerializeTracks(FArchive& Ar, TConstArrayView<FRecordFrame> Frames, ETransformQuantizationMethod QuantOpts, const FTrackQuantizationTable* TrackTable = nullptr, int32 SmallestThreeBits = FQuatSmallestThree::DefaultBits, int32 CurveTolerance = 0);
+
+	/**
+	 * Reads frames written by SerializeTracks and appends them to OutFrames. Sets the archive error on malformed data.
+	 * @param QuantOpts The quantization method used when the frames were written.
+	 * @param TrackTable Per-track methods the frames were written with, required when QuantOpts is 'Auto'.
+	 */
+	void DeserializeTracks(FArchive& Ar, TArray<FRecordFrame>& OutFrames, ETransformQuantizationMethod QuantOpts, const FTrackQuantizationTable* TrackTable = nullptr);
+}
@@ -0,0 +1,78 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BloodStainBlockUtils.h"
+#include "BloodStainFileOptions.h"
+#include "GhostData.h"
+#include "Tasks/Task.h"
+
+/**
+ * Rolling window of pre-encoded frame blocks for one recorded actor.
+ * Used instead of the frame queue when FBloodStainRecordOptions::bPrecookInBackground is set.
+ *
+ * Frames are gathered into a pending block on the game thread. Once the block is full it is
+ * quantized and compressed on a worker, so StopRecording only has to stitch finished blocks together.
+ */
+class BLOODSTAINSYSTEM_API FFrameBlockRecorder
+{
+public:
+	FFrameBlockRecorder(int32 InBlockFrameCount, const FBloodStainFileOptions& InFileOptions, const FName& InPrimaryComponentName);
+
+	/** Appends a frame; a full pending block is handed to a worker thread for encoding */
+	void AddFrame(FRecordFrame&& Frame);
+
+	/** Drops encoded blocks whose last frame is older than MinTimeStamp (recorder time) */
+	void DiscardBlocksBefore(float MinTimeStamp);
+
+	/** True if there are no pending, in-flight or encoded frames left */
+	bool IsEmpty() const;
+
+	/**
+	 * Waits for in-flight blocks, encodes the partial tail block and moves every block that overlaps
+	 * the saved window [ClipStartTime, end] into OutActorData. Component intervals are left to the caller.
+	 * Blocks of the window whose background encode failed are cooked again here from their raw frames.
+	 * @param ClipStartTime Window start in recorder time; becomes the actor's TimeBase.
+	 * @param OutFirstFrameIndex Recorder frame index of the first saved frame.
+	 * @return false if less than two frames fall inside the window, or a block of the window cannot be encoded
+	 */
+	bool Finalize(float ClipStartTime, FEncodedActorData& OutActorData, int32& OutFirstFrameIndex);
+
+private:
+	/** One block of the rolling window */
+	struct FRecordedBlock
+	{
+		FEncodedFrameBlock Block;
+
+		/** Raw frames of the block, kept only if encoding failed so Finalize can cook them again */
+		TArray<FRecordFrame> FailedFrames;
+	};
+
+	/** Moves finished blocks from the in-flight list to EncodedBlocks, preserving frame order */
+	void CollectFinishedBlocks(bool bWaitForAll);
+
+	/**
+	 * Encodes frames into a block, including the metadata needed to cut and stitch it later.
+	 * On failure the block keeps its time range and takes ownership of the frames.
+	 */
+	static FRecordedBlock EncodeFrames(TArray<FRecordFrame>&& Frames, const FBloodStainFileOptions& Options, const FString& PrimaryComponentKey);
+
+	int32 BlockFrameCount;
+
+	FBloodStainFileOptions FileOptions;
+
+	FString PrimaryComponentKey;
+
+	/** Frames of the block currently being filled */
+	TArray<FRecordFrame> PendingFrames;
+
+	/** Blocks being encoded on worker threads, oldest first */
+	TArray<UE::Tasks::TTask<FRecordedBlock>> InFlightBlocks;
+
+	/** Finished blocks of the rolling window, oldest first */
+	TArray<FRecordedBlock> EncodedBlocks;
+};
@@ -7,6 +7,7 @@
 
 #include "CoreMinimal.h"
 #include "GameplayTagContainer.h"
+#include "BloodStainFileOptions.h"
 #include "StructUtils/InstancedStruct.h"
 #include "GhostData.generated.h"
 
@@ -145,6 +146,11 @@ struct FBoneComponentSpace
 	{
 	}
 
+	explicit FBoneComponentSpace(TArray<FTransform>&& InBoneTransforms)
+		: BoneTransforms(MoveTemp(InBoneTransforms))
+	{
+	}
+
 	friend FArchive& operator<<(FArchive& Ar, FBoneComponentSpace& BoneComponentSpace)
 	{
 		Ar << BoneComponentSpace.BoneTransforms;
@@ -298,6 +304,58 @@ struct FRecordActorSaveData
 	}
 };
 
+/**
+ * @brief Body statistics precomputed at save time and stored with the header,
+ * so browsers and culling can work from header scans without decoding any frames
+ */
+USTRUCT(BlueprintType)
+struct FRecordHeaderSummary
+{
+	GENERATED_BODY()
+
+	/** Number of recorded actors in the group */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "BloodStain|Header")
+	int32 NumActors = 0;
+
+	/** Recorded frames summed over all actors */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "BloodStain|Header")
+	int32 NumFrames = 0;
+
+	/** World-space box around every recorded component location */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "BloodStain|Header")
+	FBox Bounds = FBox(ForceInit);
+
+	/** Size of the recorded body before compression, in bytes */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "BloodStain|Header")
+	int64 UncompressedSize = 0;
+
+	/** Size of the compressed body on disk, in bytes */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "BloodStain|Header")
+	int64 CompressedSize = 0;
+
+	/** Quantization the body was written with */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "BloodStain|Header")
+	ETransformQuantizationMethod QuantizationOption = ETransformQuantizationMethod::None;
+
+	/** Index of the main actor, whose first frame is the preview pose */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "BloodStain|Header")
+	int32 MainActorIndex = 0;
+
+	/** Component names of the preview pose, parallel to PreviewTransforms */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "BloodStain|Header")
+	TArray<FString> PreviewComponentNames;
+
+	/** First-frame world transforms of the main actor's components. Stored quantized, so slightly lossy */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "BloodStain|Header")
+	TArray<FTransform> PreviewTransforms;
+
+	/** True once the body statistics (counts, bounds, preview) have been filled */
+	bool HasBodyStats() const
+	{
+		return NumActors > 0;
+	}
+};
+
 /** @brief Header for a recording session, storing metadata about the group */
 USTRUCT(BlueprintType)
 struct FRecordHeaderData
@@ -338,6 +396,13 @@ struct FRecordHeaderData
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category="BloodStain|Header")
 	TArray<FInstancedStruct> RecordActorUserData;
 
+	/**
+	 * Precomputed body statistics. Serialized by the file layer from EBloodStainFileVersion::Columnar on,
+	 * not by operator<< below; older files leave it empty.
+	 */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "BloodStain|Header")
+	FRecordHeaderSummary Summary;
+
 	FRecordHeaderData()
 		: MaxRecordTime(5.f)
 		, SamplingInterval(0.1f)
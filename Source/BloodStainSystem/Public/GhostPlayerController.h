@@ -31,8 +31,11 @@ public:
 	UFUNCTION(Server, Reliable)
 	void Server_SpawnBloodStain(const FString& FileName, const FString& LevelName, const FBloodStainPlaybackOptions& PlaybackOptions);
 
-	/** [Client-side] Start sending local replay file to the server, called on Tick() */
-	void StartFileUpload(const FString& FilePath, const FRecordHeaderData& Header);
+	/**
+	 * [Client-side] Start sending a local replay file to the server, called on Tick()
+	 * @param FileBytes Whole recording file as stored, loose or in a level pack (BloodStainFileUtils::LoadFileBytesAsync)
+	 */
+	void StartFileUpload(TArray<uint8>&& FileBytes, const FRecordHeaderData& Header);
 	
 protected:
 	virtual void Tick(float DeltaSeconds) override;
@@ -57,9 +60,8 @@ private:
 	int32 MaxBytesToSendThisTick = 1024 * 16; // 16 KB per tick
 	int32 ChunkSize = 1024; // 1 KB per chunk
 
-	FString UploadFilePath;
 	FRecordHeaderData UploadHeader;
-	TUniquePtr<IFileHandle> UploadFileHandle;
+	TArray<uint8> UploadBytes;
 	int64 TotalFileSize = 0;
 	int64 BytesSent = 0;
 	float AccumulatedTickTime = 0.f;
@@ -51,6 +51,15 @@ struct FBloodStainRecordOptions
 	/** Save immediately if all recording actors in group is empty */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Replay")
 	bool bSaveImmediatelyIfGroupEmpty = false;
+
+	/** If true, finished blocks of the rolling window are quantized and compressed on worker threads while recording,
+	 *  so StopRecording only stitches already encoded blocks together */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record|Precook")
+	bool bPrecookInBackground = false;
+
+	/** Number of frames per pre-cooked block. Smaller blocks shorten the tail encoded at stop, larger blocks compress better */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record|Precook", meta = (EditCondition = "bPrecookInBackground", ClampMin = "2"))
+	int32 PrecookBlockFrames = 16;
 	
 	friend FArchive& operator<<(FArchive& Ar, FBloodStainRecordOptions& Data)
 	{
@@ -63,6 +72,8 @@ struct FBloodStainRecordOptions
 		Ar << Data.SamplingInterval;
 		Ar << Data.bTrackAttachmentChanges;
 		Ar << Data.bSaveImmediatelyIfGroupEmpty;
+		Ar << Data.bPrecookInBackground;
+		Ar << Data.PrecookBlockFrames;
 		return Ar;
 	}
 };
@@ -92,6 +103,13 @@ struct FBloodStainPlaybackOptions
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Replay", meta = (EditCondition = "bUseGhostMaterial", EditConditionHides))
 	TObjectPtr<UMaterialInterface> GroupGhostMaterial = nullptr;
 
+	/** If true, standalone replays start from the file's low resolution tier when it has one and the full data is not cached yet */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Replay|LowResolution")
+	bool bStartWithLowResolution = false;
+
+	/** A low resolution replay upgrades to the full data once one of its ghosts comes this close to the local camera. 0 = upgrade only on request */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Replay|LowResolution", meta = (EditCondition = "bStartWithLowResolution", ClampMin = "0.0"))
+	float FullResolutionDistance = 2000.f;
 	
 	friend FArchive& operator<<(FArchive& Ar, FBloodStainPlaybackOptions& Data)
 	{
@@ -99,6 +117,8 @@ struct FBloodStainPlaybackOptions
 		Ar << Data.bIsLooping;
 		Ar << Data.bUseGhostMaterial;
 		Ar << Data.GroupGhostMaterial;
+		Ar << Data.bStartWithLowResolution;
+		Ar << Data.FullResolutionDistance;
 		return Ar;
 	}
 };
\ No newline at end of file
@@ -73,6 +73,17 @@ public:
 	FRecordActorSaveData GetReplayData() const { return ReplayData; }
 
 	void SetPlaybackStartTime(const float StartTime) { PlaybackStartTime = StartTime; }
+
+	/** Marks ReplayData as a low resolution tier, to be upgraded once the ghost gets close to the camera */
+	void SetLowResolution(bool bInLowResolution) { bIsLowResolution = bInLowResolution; }
+
+	bool IsLowResolution() const { return bIsLowResolution; }
+
+	/**
+	 * Replaces low resolution frames with the full data of the same actor. Components are kept,
+	 * since the tier holds the same component intervals.
+	 */
+	void UpgradeReplayData(const FRecordActorSaveData& InReplayData);
 	
 protected:
 	/** Apply Interpolation to Component between Two Frames */
@@ -86,6 +97,15 @@ private:
 	USceneComponent* CreateComponentFromRecord(const FComponentRecord& Record, const TMap<FString, TObjectPtr<UObject>>& AssetCache) const;
 
 	void SeekFrame(int32 FrameIndex);
+
+	/** @return Index of the last frame at or before ElapsedTime, clamped so the next frame exists */
+	int32 FindFrameAtTime(float ElapsedTime) const;
+
+	/** Rebuilds the interval tree over ReplayData.ComponentIntervals */
+	void RebuildIntervalTree();
+
+	/** @return true if a low resolution ghost is within PlaybackOptions.FullResolutionDistance of the local camera */
+	bool ShouldUpgradeResolution() const;
 	
 	static TUniquePtr<FIntervalTreeNode> BuildIntervalTree(const TArray<FComponentActiveInterval*>& InComponentIntervals);
 	static void QueryIntervalTree(FIntervalTreeNode* Node, int32 FrameIndex, TArray<FComponentActiveInterval*>& OutComponentIntervals);
@@ -120,4 +140,13 @@ protected:
 	float PlaybackStartTime = 0.f;
 
 	int32 CurrentFrame = 0;
+
+	/** True while ReplayData holds the file's low resolution tier */
+	bool bIsLowResolution = false;
+
+	/** Set once this component asked the subsystem for the full data */
+	bool bFullResolutionRequested = false;
+
+	/** Frame spacing of ReplayData when it is uniformly sampled, 0 otherwise. Lets FindFrameAtTime index frames directly */
+	float UniformFrameInterval = 0.f;
 };
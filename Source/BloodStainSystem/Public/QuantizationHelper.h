@@ -7,6 +7,7 @@
 
 #include "CoreMinimal.h"
 #include "BloodStainFileOptions.h"
+#include "BloodStainQuantizationKernels.h"
 #include "QuantizationTypes.h"
 
 /**
@@ -18,12 +19,150 @@
  */
 namespace BloodStainFileUtils_Internal
 {
+	/** Constants of one track's quantized type, derived once before any of its samples are (de)quantized */
+	struct FTrackQuantizationParams
+	{
+		/** 'Standard_Low' only */
+		FLowestQuantizationParams Lowest;
+
+		/** 'Standard_SmallestThree' only. Decoded rotations carry their own width */
+		int32 SmallestThreeBits = FQuatSmallestThree::DefaultBits;
+
+		FTrackQuantizationParams() = default;
+
+		FTrackQuantizationParams(const FLocRange* LocRange, const FScaleRange* ScaleRange, int32 InSmallestThreeBits = FQuatSmallestThree::DefaultBits)
+			: SmallestThreeBits(InSmallestThreeBits)
+		{
+			if (LocRange && ScaleRange)
+			{
+				Lowest = FLowestQuantizationParams(*LocRange, *ScaleRange);
+			}
+		}
+	};
+
+	/**
+	 * Quantizes and rebuilds single transforms of a quantized type known at compile time.
+	 * Loops over a track are instantiated once per type, so the method is dispatched once per track instead of per transform.
+	 * Types with bGridLanes keep location and scale on the grid; QuantizeTrack snaps those for the whole track
+	 * in batch and only calls QuantizeRotation per transform.
+	 */
+	template<typename QuantType>
+	struct TQuantizationKernel;
+
+	template<>
+	struct TQuantizationKernel<FQuantizedTransform_High>
+	{
+		static constexpr ETransformQuantizationMethod Method = ETransformQuantizationMethod::Standard_High;
+		static constexpr bool bGridLanes = true;
+		static FORCEINLINE FQuantizedTransform_High Quantize(const FTransform& T, const FTrackQuantizationParams&) { return FQuantizedTransform_High(T); }
+		static FORCEINLINE void QuantizeRotation(const FQuat& R, const FTrackQuantizationParams&, FQuantizedTransform_High& Q) { Q.Rotation = FQuatFixed48NoW(FQuat4f(R)); }
+		static FORCEINLINE FTransform Dequantize(const FQuantizedTransform_High& Q, const FTrackQuantizationParams&) { return Q.ToTransform(); }
+	};
+
+	template<>
+	struct TQuantizationKernel<FQuantizedTransform_Compact>
+	{
+		static constexpr ETransformQuantizationMethod Method = ETransformQuantizationMethod::Standard_Medium;
+		static constexpr bool bGridLanes = true;
+		static FORCEINLINE FQuantizedTransform_Compact Quantize(const FTransform& T, const FTrackQuantizationParams&) { return FQuantizedTransform_Compact(T); }
+		static FORCEINLINE void QuantizeRotation(const FQuat& R, const FTrackQuantizationParams&, FQuantizedTransform_Compact& Q) { Q.Rotation = FQuatFixed32NoW(FQuat4f(R)); }
+		static FORCEINLINE FTransform Dequantize(const FQuantizedTransform_Compact& Q, const FTrackQuantizationParams&) { return Q.ToTransform(); }
+	};
+
+	template<>
+	struct TQuantizationKernel<FQuantizedTransform_SmallestThree>
+	{
+		static constexpr ETransformQuantizationMethod Method = ETransformQuantizationMethod::Standard_SmallestThree;
+		static constexpr bool bGridLanes = true;
+		static FORCEINLINE FQuantizedTransform_SmallestThree Quantize(const FTransform& T, const FTrackQuantizationParams& Params) { return FQuantizedTransform_SmallestThree(T, Params.SmallestThreeBits); }
+		static FORCEINLINE void QuantizeRotation(const FQuat& R, const FTrackQuantizationParams& Params, FQuantizedTransform_SmallestThree& Q) { Q.Rotation = FQuatSmallestThree(R, Params.SmallestThreeBits); }
+		static FORCEINLINE FTransform Dequantize(const FQuantizedTransform_SmallestThree& Q, const FTrackQuantizationParams&) { return Q.ToTransform(); }
+	};
+
+	template<>
+	struct TQuantizationKernel<FQuantizedTransform_Lowest>
+	{
+		static constexpr ETransformQuantizationMethod Method = ETransformQuantizationMethod::Standard_Low;
+
+		/** Interval fixed-point lanes owned by the engine, packed per transform */
+		static constexpr bool bGridLanes = false;
+		static FORCEINLINE FQuantizedTransform_Lowest Quantize(const FTransform& T, const FTrackQuantizationParams& Params) { return FQuantizedTransform_Lowest(T, Params.Lowest); }
+		static FORCEINLINE FTransform Dequantize(const FQuantizedTransform_Lowest& Q, const FTrackQuantizationParams& Params) { return Q.ToTransform(Params.Lowest); }
+	};
+
+	/** Quantizes a whole track into a contiguous array */
+	template<typename QuantType>
+	void QuantizeTrack(TConstArrayView<const FTransform*> Samples, const FTrackQuantizationParams& Params, TArray<QuantType>& OutQuantized)
+	{
+		OutQuantized.Reset(Samples.Num());
+		if constexpr (TQuantizationKernel<QuantType>::bGridLanes)
+		{
+			TArray<FVector> Locations;
+			TArray<FVector> Scales;
+			Locations.Reserve(Samples.Num());
+			Scales.Reserve(Samples.Num());
+			for (const FTransform* Sample : Samples)
+			{
+				Locations.Add(Sample->GetLocation());
+				Scales.Add(Sample->GetScale3D());
+			}
+			BloodStainQuantizationKernels::SnapToGrid(Locations, QuantizedLocationStepsPerUnit, Locations);
+			BloodStainQuantizationKernels::SnapToGrid(Scales, QuantizedScaleStepsPerUnit, Scales);
+
+			for (int32 Index = 0; Index < Samples.Num(); ++Index)
+			{
+				QuantType& Q = OutQuantized.AddDefaulted_GetRef();
+				Q.Location = Locations[Index];
+				TQuantizationKernel<QuantType>::QuantizeRotation(Samples[Index]->GetRotation(), Params, Q);
+				Q.Scale = Scales[Index];
+			}
+		}
+		else
+		{
+			for (const FTransform* Sample : Samples)
+			{
+				OutQuantized.Add(TQuantizationKernel<QuantType>::Quantize(*Sample, Params));
+			}
+		}
+	}
+
+	/** Rebuilds a whole track and appends it to OutTransforms */
+	template<typename QuantType>
+	void DequantizeTrack(TConstArrayView<QuantType> Quantized, const FTrackQuantizationParams& Params, TArray<FTransform>& OutTransforms)
+	{
+		OutTransforms.Reserve(OutTransforms.Num() + Quantized.Num());
+		for (const QuantType& Q : Quantized)
+		{
+			OutTransforms.Add(TQuantizationKernel<QuantType>::Dequantize(Q, Params));
+		}
+	}
+
+	/** Smallest-three rotations are rebuilt several at a time by the vector kernel */
+	template<>
+	inline void DequantizeTrack<FQuantizedTransform_SmallestThree>(TConstArrayView<FQuantizedTransform_SmallestThree> Quantized, const FTrackQuantizationParams&, TArray<FTransform>& OutTransforms)
+	{
+		BloodStainQuantizationKernels::DequantizeTransforms(Quantized, OutTransforms);
+	}
+
 	/**
 	 * Computes the min/max ranges for location and scale across all frames in the save data.
 	 * This is a prerequisite for 'Standard_Low' quantization.
 	 * @param SaveData The replay data to process. Ranges will be computed and stored within this struct.
 	 */
 	void ComputeRanges(FRecordSaveData& SaveData);
+
+	/**
+	 * Computes the min/max ranges for a run of frames without modifying them.
+	 * @param Frames The frames to scan.
+	 * @param OutRanges Receives the component and per-skeletal-mesh bone ranges.
+	 */
+	void ComputeRanges(TConstArrayView<FRecordFrame> Frames, FActorTransformRanges& OutRanges);
+
+	/**
+	 * Computes the location/scale range of a single track (one component or one bone).
+	 * Bounds are rounded to float so they can be stored compactly and reproduced exactly by the reader.
+	 */
+	void ComputeTrackRanges(TConstArrayView<const FTransform*> Samples, FLocRange& OutLocRange, FScaleRange& OutScaleRange);
 	
 	/** 
 	 * Serializes a single FTransform to an archive using the specified quantization options.
@@ -43,13 +182,40 @@ namespace BloodStainFileUtils_Internal
 	 */
 	FTransform DeserializeQuantizedTransform(FArchive& Ar, const ETransformQuantizationMethod& QuantOpts, const FLocRange* LocRange = nullptr, const FScaleRange* ScaleRange = nullptr);
 
+	/**
+	 * Picks the cheapest fixed quantization method for every component and bone track whose worst-case
+	 * round-trip error over Frames stays within the budget. Tracks no method satisfies stay unquantized.
+	 * @param Ranges Shared ranges used for 'Standard_Low', computed over the same frames,
+	 *               or null when every track is quantized against its own range (columnar layout).
+	 * @param SmallestThreeBits Rotation width the frames will be written with if 'Standard_SmallestThree' is picked.
+	 */
+	void ChooseTrackQuantization(TConstArrayView<FRecordFrame> Frames, const FActorTransformRanges* Ranges, float MaxPositionError, float MaxRotationError, int32 SmallestThreeBits, FTrackQuantizationTable& OutTable);
+
+	/**
+	 * Serializes a frame count followed by every frame's quantized component and bone transforms.
+	 * @param Frames The frames to write. They are not modified.
+	 * @param QuantOpts The quantization method applied to every transform.
+	 * @param Ranges Ranges for 'Standard_Low' quantization, computed over the same frames.
+	 * @param TrackTable Per-track methods, required when QuantOpts is 'Auto'.
+	 * @param SmallestThreeBits Rotation width of 'Standard_SmallestThree' transforms; must match the one TrackTable was chosen with.
+	 */
+	void SerializeFrames(FArchive& RawAr, TConstArrayView<FRecordFrame> Frames, const ETransformQuantizationMethod& QuantOpts, const FActorTransformRanges& Ranges, const FTrackQuantizationTable* TrackTable = nullptr, int32 SmallestThreeBits = FQuatSmallestThree::DefaultBits);
+
+	/**
+	 * Reads frames written by SerializeFrames and appends them to OutFrames.
+	 * @param QuantOpts The quantization method used when the frames were written.
+	 * @param Ranges The ranges the frames were quantized with.
+	 * @param TrackTable Per-track methods the frames were written with, required when QuantOpts is 'Auto'.
+	 */
+	void DeserializeFrames(FArchive& DataAr, TArray<FRecordFrame>& OutFrames, const ETransformQuantizationMethod& QuantOpts, const FActorTransformRanges& Ranges, const FTrackQuantizationTable* TrackTable = nullptr);
+
 	/**
 	 * Serializes an entire FRecordSaveData object to a raw byte archive.
 	 * Automatically computes ranges and quantizes all FTransform data according to the options.
-	 * @param SaveData The source replay data to serialize. Its range members will be modified.
-	 * @param QuantOpts The quantization options to apply to all transforms.
+	 * @param SaveData The source replay data to serialize. It is not modified.
+	 * @param Options Quantization method, plus the 'Auto' error budget and smallest-three width, of the file the data came from.
 	 */
-	void SerializeSaveData(FArchive& RawAr,FRecordSaveData& SaveData, ETransformQuantizationMethod& QuantOpts);
+	void SerializeSaveData(FArchive& RawAr, const FRecordSaveData& SaveData, const FBloodStainFileOptions& Options);
 
 	/**
 	 * Deserializes raw byte data from an archive into an FRecordSaveData object.
@@ -9,8 +9,23 @@
 #include "Engine/NetSerialization.h"
 #include "Math/Quat.h"
 #include "AnimationCompression.h"
+#include "BloodStainFileOptions.h"
+#include "BloodStainQuantizationKernels.h"
 #include "GhostData.h"
 
+/**
+ * Snaps a vector to a grid of 1 / UnitsPerStep, so the stored value matches the precision the type advertises
+ * and can be carried as integers by the columnar track codec.
+ */
+inline FVector QuantizeToGrid(const FVector& V, double UnitsPerStep)
+{
+	return BloodStainQuantizationKernels::SnapToGrid(V, UnitsPerStep);
+}
+
+/** Grid steps per unit of the location (FVector_NetQuantize100) and scale (FVector_NetQuantize10) fields */
+constexpr double QuantizedLocationStepsPerUnit = 100.0;
+constexpr double QuantizedScaleStepsPerUnit = 10.0;
+
 /**
  * @brief Relatively High-precision quantized transform.
  *
@@ -30,9 +45,9 @@ struct FQuantizedTransform_High
 	FQuantizedTransform_High() = default;
 
 	explicit FQuantizedTransform_High(const FTransform& T) 
-		: Location(T.GetLocation())
+		: Location(QuantizeToGrid(T.GetLocation(), QuantizedLocationStepsPerUnit))
 		, Rotation(FQuat4f(T.GetRotation()))
-		, Scale(T.GetScale3D()) 
+		, Scale(QuantizeToGrid(T.GetScale3D(), QuantizedScaleStepsPerUnit)) 
 	{}
 	
 	FTransform ToTransform() const
@@ -74,9 +89,9 @@ struct FQuantizedTransform_Compact
 	FQuantizedTransform_Compact() = default;
 
 	explicit FQuantizedTransform_Compact(const FTransform& T) 
-		: Location(T.GetLocation())
+		: Location(QuantizeToGrid(T.GetLocation(), QuantizedLocationStepsPerUnit))
 		, Rotation(FQuat4f(T.GetRotation())) 
-		, Scale(T.GetScale3D()) 
+		, Scale(QuantizeToGrid(T.GetScale3D(), QuantizedScaleStepsPerUnit)) 
 	{}
 	
 	FTransform ToTransform() const
@@ -99,6 +114,112 @@ struct FQuantizedTransform_Compact
 	}
 };
 
+/**
+ * @brief Smallest-three quaternion.
+ *
+ * The component with the largest magnitude is dropped (and rebuilt from the unit norm), its sign is folded
+ * into the others, and the remaining three lie in [-1/sqrt(2), 1/sqrt(2)] where they are stored with BitsPerComponent bits each.
+ * Precision is spread evenly over all rotations, unlike FQuatFixed32NoW which always drops W.
+ */
+struct FQuatSmallestThree
+{
+	static constexpr int32 MinBits = 9;
+	static constexpr int32 MaxBits = 16;
+
+	/** 2 + 3 * 10 = 32 bits per rotation */
+	static constexpr int32 DefaultBits = 10;
+
+	/** Index (X, Y, Z, W) of the dropped component */
+	uint8 LargestIndex = 3;
+
+	uint8 BitsPerComponent = DefaultBits;
+
+	/** The other three components in X, Y, Z, W order, each in [0, 2^BitsPerComponent) */
+	uint16 Components[3] = { 0, 0, 0 };
+
+	FQuatSmallestThree() = default;
+
+	FQuatSmallestThree(const FQuat& Q, int32 InBitsPerComponent);
+
+	FQuat ToQuat() const;
+
+	friend FArchive& operator<<(FArchive& Ar, FQuatSmallestThree& Q)
+	{
+		// Index and width share one byte so row layouts stay self-describing
+		uint8 Packed = static_cast<uint8>((Q.LargestIndex << 6) | (Q.BitsPerComponent & 0x3F));
+		Ar << Packed;
+		Q.LargestIndex = Packed >> 6;
+		Q.BitsPerComponent = static_cast<uint8>(FMath::Clamp<int32>(Packed & 0x3F, MinBits, MaxBits));
+
+		Ar << Q.Components[0];
+		Ar << Q.Components[1];
+		Ar << Q.Components[2];
+		return Ar;
+	}
+};
+
+/**
+ * @brief Quantized transform with a smallest-three rotation.
+ *
+ * Uses:
+ *  - 0.01-unit quantization for Location (FVector_NetQuantize100),
+ *  - smallest-three rotation with a configurable width (FQuatSmallestThree),
+ *  - 0.1-unit quantization for Scale (FVector_NetQuantize10).
+ */
+struct FQuantizedTransform_SmallestThree
+{
+	FVector_NetQuantize100 Location;
+
+	FQuatSmallestThree Rotation;
+
+	FVector_NetQuantize10 Scale;
+
+	FQuantizedTransform_SmallestThree() = default;
+
+	FQuantizedTransform_SmallestThree(const FTransform& T, int32 RotationBits)
+		: Location(QuantizeToGrid(T.GetLocation(), QuantizedLocationStepsPerUnit))
+		, Rotation(T.GetRotation(), RotationBits)
+		, Scale(QuantizeToGrid(T.GetScale3D(), QuantizedScaleStepsPerUnit))
+	{}
+
+	FTransform ToTransform() const
+	{
+		FTransform T;
+		T.SetLocation(Location);
+		T.SetRotation(Rotation.ToQuat());
+		T.SetScale3D(Scale);
+		return T;
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FQuantizedTransform_SmallestThree& Data)
+	{
+		Ar << Data.Location;
+		Ar << Data.Rotation;
+		Ar << Data.Scale;
+		return Ar;
+	}
+};
+
+/**
+ * @brief Range-derived constants of 'Standard_Low' quantization.
+ *
+ * Built once per track (or per shared range) so quantizing a run of transforms does not rebuild them for every sample.
+ */
+struct FLowestQuantizationParams
+{
+	float Mins[3] = { 0.f, 0.f, 0.f };
+
+	float Ranges[3] = { 1.f, 1.f, 1.f };
+
+	float ScaleMins[3] = { 0.f, 0.f, 0.f };
+
+	float ScaleRanges[3] = { 1.f, 1.f, 1.f };
+
+	FLowestQuantizationParams() = default;
+
+	FLowestQuantizationParams(const FLocRange& Range, const FScaleRange& ScaleRange);
+};
+
 /**
  * @brief Lowest-bit quantized transform.
  *
@@ -120,9 +241,13 @@ struct FQuantizedTransform_Lowest
 	/** Quantize original FTransform into bitfields */
 	FQuantizedTransform_Lowest(const FTransform& T, const FLocRange& Range, const FScaleRange& ScaleRange);
 
+	FQuantizedTransform_Lowest(const FTransform& T, const FLowestQuantizationParams& Params);
+
 	/** Reconstruct FTransform from quantized bitfields */
 	FTransform ToTransform(const FLocRange& Range, const FScaleRange& ScaleRange) const;
 
+	FTransform ToTransform(const FLowestQuantizationParams& Params) const;
+
 	friend FArchive& operator<<(FArchive& Ar, FQuantizedTransform_Lowest& Q)
 	{
 		Ar << Q.Translation;
@@ -130,4 +255,62 @@ struct FQuantizedTransform_Lowest
 		Ar << Q.Scale;
 		return Ar;
 	}
-};
\ No newline at end of file
+};
+
+/**
+ * @brief Location/scale ranges used to quantize one run of frames.
+ *
+ * Computed from the frames being encoded (a whole actor in the legacy layout, a single block otherwise)
+ * without touching the source data. Serialized in the same order as the range fields of FRecordActorSaveData.
+ */
+struct FActorTransformRanges
+{
+	FLocRange ComponentRanges;
+
+	FScaleRange ComponentScaleRanges;
+
+	TMap<FString, FLocRange> BoneRanges;
+
+	TMap<FString, FScaleRange> BoneScaleRanges;
+
+	friend FArchive& operator<<(FArchive& Ar, FActorTransformRanges& Ranges)
+	{
+		Ar << Ranges.ComponentRanges;
+		Ar << Ranges.ComponentScaleRanges;
+		Ar << Ranges.BoneRanges;
+		Ar << Ranges.BoneScaleRanges;
+		return Ar;
+	}
+};
+
+/**
+ * @brief Quantization method chosen per track by ETransformQuantizationMethod::Auto.
+ *
+ * Component tracks are keyed by component name, bone tracks by skeletal component name and bone index.
+ * Tracks missing from the table are stored unquantized.
+ */
+struct FTrackQuantizationTable
+{
+	TMap<FString, ETransformQuantizationMethod> ComponentMethods;
+
+	TMap<FString, TArray<ETransformQuantizationMethod>> BoneMethods;
+
+	ETransformQuantizationMethod GetComponentMethod(const FString& ComponentName) const
+	{
+		const ETransformQuantizationMethod* Method = ComponentMethods.Find(ComponentName);
+		return Method ? *Method : ETransformQuantizationMethod::None;
+	}
+
+	ETransformQuantizationMethod GetBoneMethod(const FString& ComponentName, int32 BoneIndex) const
+	{
+		const TArray<ETransformQuantizationMethod>* Methods = BoneMethods.Find(ComponentName);
+		return Methods && Methods->IsValidIndex(BoneIndex) ? (*Methods)[BoneIndex] : ETransformQuantizationMethod::None;
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FTrackQuantizationTable& Table)
+	{
+		Ar << Table.ComponentMethods;
+		Ar << Table.BoneMethods;
+		return Ar;
+	}
+};
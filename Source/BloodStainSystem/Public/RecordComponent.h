@@ -6,6 +6,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "BloodStainFileOptions.h"
+#include "FrameBlockRecorder.h"
 #include "GhostData.h"
 #include "OptionTypes.h"
 #include "Components/ActorComponent.h"
@@ -13,6 +15,7 @@
 #include "RecordComponent.generated.h"
 
 class UMeshComponent;
+struct FRecordActorSnapshot;
 
 
 /**
@@ -32,10 +35,16 @@ public:
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-	void Initialize(const FBloodStainRecordOptions& InOptions, const float& InGroupStartTime);
+	void Initialize(const FBloodStainRecordOptions& InOptions, const float& InGroupStartTime, const FBloodStainFileOptions& InFileOptions = FBloodStainFileOptions());
 
-	// Cook Data from FrameQueue to GhostSaveData
-	FRecordActorSaveData CookQueuedFrames(const float& BaseTime);
+	/**
+	 * Hands the recorded buffers over to OutSnapshot without copying any frame.
+	 * The component stops recording afterwards; cooking is left to FSaveRecordingTask.
+	 */
+	void TakeRecordSnapshot(FRecordActorSnapshot& OutSnapshot);
+
+	/** True if frames are encoded into blocks in the background instead of being queued */
+	bool IsPrecooking() const { return BlockRecorder.IsValid(); }
 	
 public:
 	/* Called when a new component attached to the owner */
@@ -98,6 +107,9 @@ protected:
 	/** Records All frames up to MaxFrames */
 	TUniquePtr<TCircularQueue<FRecordFrame>> FrameQueuePtr;
 
+	/** Background block encoder, replaces FrameQueuePtr when RecordOptions.bPrecookInBackground is set */
+	TUniquePtr<FFrameBlockRecorder> BlockRecorder;
+
 	/** Component currently owned */
 	UPROPERTY()
 	TArray<TObjectPtr<UMeshComponent>> OwnedComponentsForRecord;
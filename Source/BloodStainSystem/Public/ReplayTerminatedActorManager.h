@@ -6,6 +6,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "FrameBlockRecorder.h"
 #include "GhostData.h"
 #include "OptionTypes.h"
 #include "UObject/Object.h"
@@ -14,6 +15,7 @@
 #include "ReplayTerminatedActorManager.generated.h"
 
 struct FRecordActorSaveData;
+struct FRecordActorSnapshot;
 DECLARE_DELEGATE(FOnRecordGroupRemove);
 
 /**
@@ -29,9 +31,8 @@ public:
 	virtual void Tick(float DeltaTime) override;
 	virtual TStatId GetStatId() const override;
 
-	/** Cook Data from FrameQueue to GhostSaveData */
-	TArray<FRecordActorSaveData> CookQueuedFrames(const FName& GroupName, const float& BaseTime, TArray<FName>& OutActorNameArray, TArray<FInstancedStruct>&
-	                                              OutInstancedStructArray);
+	/** Moves the buffers of every terminated actor in the group into OutSnapshots and removes the group. Frames are not cooked here */
+	void TakeRecordGroupSnapshots(const FName& GroupName, TArray<FRecordActorSnapshot>& OutSnapshots);
 
 	/** if the group already exists, RecordComponent join the group */
 	void AddToRecordGroup(const FName& GroupName, URecordComponent* RecordComponent);
@@ -57,7 +58,8 @@ private:
 		float StartTime = 0.f;
 
 		TSharedPtr<TCircularQueue<FRecordFrame>> FrameQueuePtr = nullptr;
-		FRecordActorSaveData GhostSaveData = FRecordActorSaveData();
+		TSharedPtr<FFrameBlockRecorder> BlockRecorder = nullptr;
+		FName PrimaryComponentName = NAME_None;
 		TArray<FComponentActiveInterval> ComponentIntervals;
 		FInstancedStruct InstancedStruct = FInstancedStruct();
 	};
@@ -6,38 +6,80 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "BloodStainBlockUtils.h"
 #include "BloodStainFileOptions.h"
-#include "Async/AsyncWork.h"
-#include "Async/TaskGraphInterfaces.h"
+#include "Containers/CircularQueue.h"
+#include "FrameBlockRecorder.h"
 #include "GhostData.h"
+#include "StructUtils/InstancedStruct.h"
+
+DECLARE_DELEGATE_TwoParams(FOnSaveRecordingTaskCompleted, bool /*bSuccess*/, const FRecordHeaderData& /*FinalHeader*/);
 
 /**
- * Async Task that saves recorded data to a file in the background.
+ * Recording buffers of one actor, taken over from its URecordComponent (or the terminated actor manager)
+ * when the group stops. Only ownership moves on the game thread; the frames are cooked by FSaveRecordingTask.
  */
-class BLOODSTAINSYSTEM_API FSaveRecordingTask : public FNonAbandonableTask
+struct FRecordActorSnapshot
+{
+	FName ActorName = NAME_None;
+
+	FName PrimaryComponentName = NAME_None;
+
+	/** Raw frame queue; null when the recorder pre-cooked its frames */
+	TSharedPtr<TCircularQueue<FRecordFrame>> FrameQueuePtr;
+
+	/** Pre-cooked blocks; null unless FBloodStainRecordOptions::bPrecookInBackground was set */
+	TSharedPtr<FFrameBlockRecorder> BlockRecorder;
+
+	/** Component intervals in recorder frame indices */
+	TArray<FComponentActiveInterval> ComponentIntervals;
+
+	FInstancedStruct RecordActorUserData;
+};
+
+/**
+ * Task that finalizes a stopped recording group off the game thread:
+ * cooks every actor snapshot, resolves the spawn point, and saves the result to a file.
+ * Completion is reported on the game thread with the final header.
+ */
+class BLOODSTAINSYSTEM_API FSaveRecordingTask
 {
 public:
+	/** Header prefilled on the game thread; actor data and user data are filled while cooking */
 	FRecordSaveData SavedData;
+
+	/** Buffers of every recorded actor in the group */
+	TArray<FRecordActorSnapshot> Snapshots;
+
+	/** Start of the saved window in recorder time */
+	float ClipStartTime = 0.f;
+
+	float SamplingInterval = 0.1f;
+
+	/** Actor whose first saved frame becomes the spawn point. Falls back to the first saved actor */
+	FName MainActorName = NAME_None;
+
 	FString LevelName;
 	FString FileName;
 	FBloodStainFileOptions FileOptions;
 
-	/** This Delegate will trigger send replay file to server only if it's client */
-	FSimpleDelegateGraphTask::FDelegate OnTaskCompleted;
-	
-	FSaveRecordingTask(FRecordSaveData&& InData, const FString& InLevelName, const FString& InFileName, const FBloodStainFileOptions& InOptions, FSimpleDelegateGraphTask::FDelegate&& InOnTaskCompleted)
-		: SavedData(MoveTemp(InData))
-		, LevelName(InLevelName)
-		, FileName(InFileName)
-		, FileOptions(InOptions)
-		, OnTaskCompleted(MoveTemp(InOnTaskCompleted))
-	{ }
-
-	/** Save the recorded data to a file */
+	/** Called on the game thread once the file is written (or saving failed) */
+	FOnSaveRecordingTaskCompleted OnTaskCompleted;
+
+	/** Cook and queue the save, then report back to the game thread once it is written; does not wait for the write */
 	void DoWork();
 
-	FORCEINLINE TStatId GetStatId() const
-	{
-		RETURN_QUICK_DECLARE_CYCLE_STAT(FSaveRecordingTask, STATGROUP_ThreadPoolAsyncTasks);
-	}
+private:
+	/** Cooks each snapshot into SavedData / EncodedActors. @return false if no actor has enough frames */
+	bool CookSnapshots();
+
+	/**
+	 * Encodes the actors cooked from frame queues and merges them with the pre-cooked ones, keeping the snapshot order
+	 * the actor indices of the header refer to. Such mixed groups are saved without a low resolution tier.
+	 * @param SavedPrecooked Per saved actor, whether it came from a pre-cooked recorder
+	 */
+	bool MergeCookedActors(TConstArrayView<bool> SavedPrecooked);
+
+	/** Filled instead of SavedData.RecordActorDataArray for pre-cooked recorders; holds every actor once any recorder was pre-cooked */
+	TArray<FEncodedActorData> EncodedActors;
 };